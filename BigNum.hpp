@@ -10,18 +10,35 @@ the types of games that would use this library
 
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <cassert>
+#include <cctype>
+#include <charconv>
 #include <cmath>
 #include <compare>
+#include <cstddef>
 #include <cstdint>
-#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
 #include <iostream>
 #include <limits>
+#include <numbers>
 #include <optional>
-#include <sstream>
+#include <span>
 #include <string>
 #include <string_view>
+#include <system_error>
 #include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __has_include(<format>)
+#include <format>
+#endif
+#if __has_include(<expected>)
+#include <expected>
+#endif
 
 /* Define a macro for deducing CONSTEXPR_NEXTAFTER_FALLBACK
  * We do this because std::nextafter is not properly constepxr in most compilers
@@ -33,10 +50,12 @@ the types of games that would use this library
 
 // MSVC is really behind constexpr, so disable it altogether :(
 #define MAYBE_CONSTEXPR 
+#define BIGNUM_CONSTEXPR 0
 
 #elifdef __clang__
 // Clang supports most constexpr
 #define MAYBE_CONSTEXPR constexpr
+#define BIGNUM_CONSTEXPR 1
 
 // Clang does NOT support constexpr std::nextafter as of now
 #ifndef CONSTEXPR_NEXTAFTER_FALLBACK
@@ -47,6 +66,7 @@ the types of games that would use this library
 
 // GCC supports most constexpr
 #define MAYBE_CONSTEXPR constexpr
+#define BIGNUM_CONSTEXPR 1
 
 // It's safe to use constexpr nextafter if we compile with -fno-trapping-math
 #ifndef NO_TRAPPING_MATH
@@ -60,6 +80,8 @@ the types of games that would use this library
 #else // Neither _MSC_VER, __clang__, nor __GNUC__
 
 // For other compilers, be conservative
+#define MAYBE_CONSTEXPR
+#define BIGNUM_CONSTEXPR 0
 #ifndef CONSTEXPR_NEXTAFTER_FALLBACK
 #define CONSTEXPR_NEXTAFTER_FALLBACK
 #endif // CONSTEXPR_NEXTAFTER_FALLBACK
@@ -69,23 +91,115 @@ the types of games that would use this library
 // Define a macro for CPP26 and later for statements
 #define CPP26 (__cplusplus >= 202600L)
 
-// Constant precision for serializing
+/* Define BIGNUM_FAST_MATH to compute pow(), root(), log10() and exp() with the
+ * FastMath table kernels instead of std::log10 and std::pow, see FastMath for
+ * their error bounds. fast_pow(), fast_root() and fast_log10() use the kernels
+ * either way
+ */
+
+/* Define BIGNUM_SIMD when the BigNumArray kernels can use AVX2/AVX-512
+ * The vector normalization mirrors the _log10 loop used before C++26, so the
+ * kernels are only enabled there. Define BIGNUM_NO_SIMD to force the scalar
+ * path
+ */
+#if !CPP26 && !defined(BIGNUM_NO_SIMD) &&                                      \
+    (defined(__AVX512F__) || defined(__AVX2__))
+#define BIGNUM_SIMD
+#include <immintrin.h>
+#endif
+
+/* Define BIGNUM_NO_EXCEPTIONS to use the headers without exceptions. It is
+ * defined automatically when they are disabled, e.g. with -fno-exceptions
+ * Errors that would throw then give NaN instead: pow() and root() outside
+ * their domain, the string constructor and deserialize() on invalid text, and
+ * the series functions on invalid prices. Invalid std::format specifiers and
+ * _bn literals still fail to compile, and abort if only found at run time
+ * The try_* functions report what went wrong in either mode
+ */
+#if !defined(BIGNUM_NO_EXCEPTIONS) && !defined(__cpp_exceptions) &&            \
+    !defined(_CPPUNWIND)
+#define BIGNUM_NO_EXCEPTIONS
+#endif
+
+// Throws exception, or aborts when exceptions are off. Functions that give
+// NaN instead check USE_EXCEPTIONS before reaching it
+#ifdef BIGNUM_NO_EXCEPTIONS
+#define BIGNUM_FATAL(exception) std::abort()
+#else
+#define BIGNUM_FATAL(exception) throw exception
+#endif
+
 namespace BigNumber {
 using namespace std::literals::string_literals;
 
-static unsigned int SERIAL_PRECISION = 9;
-static char DECIMAL_SEPARATOR = '.';
-static char THOUSANDS_SEPARATOR = ',';
+#ifdef BIGNUM_NO_EXCEPTIONS
+inline constexpr bool USE_EXCEPTIONS = false;
+#else
+inline constexpr bool USE_EXCEPTIONS = true;
+#endif
+
+// Why an operation has no result, as returned by the try_* functions
+enum class BigNumError {
+    InvalidNumber,       // Text that is not a number
+    ExponentOutOfRange,  // A number whose exponent does not fit exp_t
+    ZeroToNegativePower, // pow(0, p) with p < 0
+    ComplexPower,        // A non-integer power of a negative number
+    ZerothRoot,          // root(0)
+    EvenRootOfNegative,  // root(n) of a negative number with n even
+};
+
+// The message of the exception that the throwing function would raise
+constexpr std::string_view error_message(const BigNumError error) {
+    switch (error) {
+    case BigNumError::InvalidNumber:
+        return "Failed to parse number";
+    case BigNumError::ExponentOutOfRange:
+        return "Exponent out of range";
+    case BigNumError::ZeroToNegativePower:
+        return "Cannot raise 0 to a negative power";
+    case BigNumError::ComplexPower:
+        return "Non-integer powers of negative numbers result in complex values";
+    case BigNumError::ZerothRoot:
+        return "Cannot take the zeroth root";
+    case BigNumError::EvenRootOfNegative:
+        return "Even root of a negative number is not defined";
+    }
+    return "Unknown error";
+}
 
-// Formatting context
+// Formatting context, read by to_string(), to_pretty_string(), from_chars()
+// and the string constructor
 struct BigNumContext {
     unsigned int max_digits = 10; // Up to how many "real" digits to display before
                           // using scientific notation
     unsigned int print_precision =
         3; // How many fractional digits to display on scientific notation
+    char decimal_separator = '.';
+    char thousands_separator = ',';
+};
+/* Default context for calls that are not given one. It is thread_local, so
+ * each thread configures its own (e.g. per request locale) and formatting
+ * never touches shared mutable state. New threads start from the defaults
+ * above; use ScopedBigNumContext to bind one temporarily
+ */
+inline thread_local BigNumContext DefaultBigNumContext;
+
+// Constant context for serializing, independent of any thread's default
+inline constexpr unsigned int SERIAL_PRECISION = 9;
+inline constexpr BigNumContext SerialBigNumContext{10, SERIAL_PRECISION, '.', ','};
+
+// Binds a context as the current thread's default until the end of the scope
+class ScopedBigNumContext {
+  private:
+    BigNumContext saved;
+
+  public:
+    explicit ScopedBigNumContext(const BigNumContext &ctx)
+        : saved(std::exchange(DefaultBigNumContext, ctx)) {}
+    ~ScopedBigNumContext() { DefaultBigNumContext = saved; }
+    ScopedBigNumContext(const ScopedBigNumContext &) = delete;
+    ScopedBigNumContext &operator=(const ScopedBigNumContext &) = delete;
 };
-// Global "default" context when none is passed to functions
-inline BigNumContext DefaultBigNumContext;
 
 // Precompute powers-of-10 table for performance
 static inline constexpr int Pow10TableOffset =
@@ -120,12 +234,172 @@ class Pow10 {
     }
 };
 
+/* Table-driven log10 and 10^x, the kernels behind fast_pow(), fast_root()
+ * and fast_log10(), their BigNumArray batch versions, and pow(), root(),
+ * log10() and exp() when BIGNUM_FAST_MATH is defined
+ * exp10(x) = 10^(j/64) * 10^r, where j is the integer nearest to 64x, so
+ * |r| <= 1/128 and 10^r is a degree 7 Taylor polynomial
+ * log10(x) = k log10(2) + log10(c) + log10(m/c), where x = 2^k m, c = 1 + j/64
+ * is the table point nearest to m, and log10(m/c) is an odd series in
+ * s = (m - c) / (m + c), |s| <= 1/256. Mantissas above sqrt(2) use k + 1 and
+ * c / 2, so that values near 1 never cancel against log10(2)
+ * Max errors in ulps are EXP10_MAX_ULP and LOG10_MAX_ULP, checked by the
+ * tests (std::pow and std::log10 stay below 1 and 2). Outside the table range
+ * (|x| >= 1 for exp10, zero, negative, subnormal, inf and NaN for log10) the
+ * std functions are used
+ */
+class FastMath {
+  private:
+    FastMath() = delete;
+
+  public:
+    // 10^(j/64) at [j + 64], correctly rounded
+    static inline constexpr std::array<double, 129> Exp10Table = {
+        0x1.999999999999ap-4, 0x1.a89ad748f4604p-4, 0x1.b828cc3ddd725p-4,
+        0x1.c848a01ba47a8p-4, 0x1.d8ffaadd33b09p-4, 0x1.ea53769a6aa0dp-4,
+        0x1.fc49c15e14863p-4, 0x1.07743f868afb2p-3, 0x1.111aedafb9a9dp-3,
+        0x1.1b1c1df5ebb1fp-3, 0x1.257b212323c52p-3, 0x1.303b67195cbfbp-3,
+        0x1.3b607ff6227d8p-3, 0x1.46ee1d40d948dp-3, 0x1.52e813241811dp-3,
+        0x1.5f5259b27d46ep-3, 0x1.6c310e3769f3fp-3, 0x1.7988749412c1cp-3,
+        0x1.875cf8a95a82dp-3, 0x1.95b32fceee3a3p-3, 0x1.a48fda581eeb9p-3,
+        0x1.b3f7e526fa136p-3, 0x1.c3f06b4e265cep-3, 0x1.d47eb7c20f110p-3,
+        0x1.e5a84719edcd2p-3, 0x1.f772c9614750ap-3, 0x1.04f211fd3ad2dp-2,
+        0x1.0e8139c96fc79p-2, 0x1.186a0714c181bp-2, 0x1.22afc2943f44dp-2,
+        0x1.2d55d3c925d0dp-2, 0x1.385fc221b16f1p-2, 0x1.43d136248490fp-2,
+        0x1.4fadfaa706391p-2, 0x1.5bf9fe0f1f09bp-2, 0x1.68b953a0bf998p-2,
+        0x1.75f034d79e965p-2, 0x1.83a302cda14a6p-2, 0x1.91d647ae654bdp-2,
+        0x1.a08eb83866767p-2, 0x1.afd1354c40d50p-2, 0x1.bfa2cd8a92c9dp-2,
+        0x1.d008bf0108a00p-2, 0x1.e10878e71fb72p-2, 0x1.f2a79d6b34ac7p-2,
+        0x1.027601c83aa77p-1, 0x1.0beddc8f2a614p-1, 0x1.15be82511301fp-1,
+        0x1.1feb33c1c381ep-1, 0x1.2a77501626657p-1, 0x1.3566562253c7ep-1,
+        0x1.40bbe5821e2d8p-1, 0x1.4c7bbfcc7c63cp-1, 0x1.58a9c9d236509p-1,
+        0x1.654a0ce83e4cbp-1, 0x1.7260b83e24841p-1, 0x1.7ff2224115d9ap-1,
+        0x1.8e02ca0bdbf3ap-1, 0x1.9c9758e458666p-1, 0x1.abb4a3c6f968dp-1,
+        0x1.bb5fad00ab22cp-1, 0x1.cb9da5d7cd6ebp-1, 0x1.dc73f044bae55p-1,
+        0x1.ede820ba73310p-1, 0x1.0000000000000p+0, 0x1.0960c68d98bc3p+0,
+        0x1.13197fa6aa677p+0, 0x1.1d2d641146cc9p+0, 0x1.279fcaca404e6p+0,
+        0x1.32742a2082a48p+0, 0x1.3dae18daccd3ep+0, 0x1.49514f682db9fp+0,
+        0x1.5561a91ba8144p+0, 0x1.61e32573669e7p+0, 0x1.6ed9e96becb66p+0,
+        0x1.7c4a40dfb3efap+0, 0x1.8a389ff3ab1cfp+0, 0x1.98a9a4910f9b1p+0,
+        0x1.a7a217ed1e165p+0, 0x1.b726f01f1c989p+0, 0x1.c73d51c54470ep+0,
+        0x1.d7ea91b917723p+0, 0x1.e93436d3b1239p+0, 0x1.fb1ffbc2a9c8cp+0,
+        0x1.06d9e87713534p+1, 0x1.107aef385c4c2p+1, 0x1.1a764310d7fa1p+1,
+        0x1.24cf32d9496aap+1, 0x1.2f892c7034a03p+1, 0x1.3aa7bddccc926p+1,
+        0x1.462e967c89878p+1, 0x1.5221883bcbb97p+1, 0x1.5e8488d9f1e22p+1,
+        0x1.6b5bb3394f161p+1, 0x1.78ab48bb6f451p+1, 0x1.8677b2aa1dcadp+1,
+        0x1.94c583ada5b53p+1, 0x1.a3997950c7c75p+1, 0x1.b2f87d92e6cc1p+1,
+        0x1.c2e7a888ef7fdp+1, 0x1.d36c420d863bep+1, 0x1.e48bc381099d0p+1,
+        0x1.f64bd999fe9ecp+1, 0x1.04593323400a0p+2, 0x1.0de2c14fa8852p+2,
+        0x1.17c5c0769bbe2p+2, 0x1.22057760a5640p+2, 0x1.2ca54b9073d27p+2,
+        0x1.37a8c26300ebcp+2, 0x1.4313823a49515p+2, 0x1.4ee953b2f4f99p+2,
+        0x1.5b2e22e557c27p+2, 0x1.67e600b234626p+2, 0x1.7515241baffecp+2,
+        0x1.82bfebaae8b9dp+2, 0x1.90eadee2a5b8dp+2, 0x1.9f9aafbf9b7cbp+2,
+        0x1.aed43c46c3e4bp+2, 0x1.be9c90224ddfdp+2, 0x1.cef8e64dada51p+2,
+        0x1.dfeeaad15b500p+2, 0x1.f1837c8ed2f09p+2, 0x1.01de978eb73ffp+3,
+        0x1.0b50e65c5be18p+3, 0x1.151bcc206af5cp+3, 0x1.1f4287a6e0653p+3,
+        0x1.29c8762af4cf5p+3, 0x1.34b1147487feap+3, 0x1.4000000000000p+3};
+    // log10(1 + j/64), minus log10(2) from j = 27 on, correctly rounded
+    static inline constexpr std::array<double, 65> Log10Table = {
+        0x0p+0, 0x1.b9476a4fcd10fp-8, 0x1.b5e908eb13790p-7,
+        0x1.45f4f5acb8be0p-6, 0x1.af5f92b00e610p-6, 0x1.0ba01a8170000p-5,
+        0x1.3ed1199a5e425p-5, 0x1.71483427d2a99p-5, 0x1.a30a9d609efeap-5,
+        0x1.d41d5164facb4p-5, 0x1.02428c1f08016p-4, 0x1.1a23445501816p-4,
+        0x1.31b3055c47118p-4, 0x1.48f3ed1df48fbp-4, 0x1.5fe80488af4fdp-4,
+        0x1.769140a2526fdp-4, 0x1.8cf183886480dp-4, 0x1.a30a9d609efeap-4,
+        0x1.b8de4d3ab3d98p-4, 0x1.ce6e41e463da5p-4, 0x1.e3bc1ab0e19fep-4,
+        0x1.f8c9683468191p-4, 0x1.06cbd67a6c3b6p-3, 0x1.11142f0811357p-3,
+        0x1.1b3e71ec94f7bp-3, 0x1.254b4d35e7d3cp-3, 0x1.2f3b691c5a001p-3,
+        -0x1.2f7301cf4e87bp-3, -0x1.25ba8215af7fcp-3, -0x1.1c1ce9955c0c6p-3,
+        -0x1.1299a4fb3e306p-3, -0x1.093025a19976cp-3, -0x1.ffbfc2bbc7803p-4,
+        -0x1.ed50a4a26eafcp-4, -0x1.db11ed766abf4p-4, -0x1.c902a19e65111p-4,
+        -0x1.b721cd17157e3p-4, -0x1.a56e8325f5c87p-4, -0x1.93e7de0fc3e80p-4,
+        -0x1.828cfed29a215p-4, -0x1.715d0ce367afcp-4, -0x1.605735ee985f1p-4,
+        -0x1.4f7aad9bbcbafp-4, -0x1.3ec6ad5407868p-4, -0x1.2e3a740b7800fp-4,
+        -0x1.1dd5460c8b16fp-4, -0x1.0d966cc6500fap-4, -0x1.fafa6d397efdbp-5,
+        -0x1.db11ed766abf4p-5, -0x1.bb7209d1e24e5p-5, -0x1.9c197abf00dd7p-5,
+        -0x1.7d070145f4fd7p-5, -0x1.5e3966b7e9295p-5, -0x1.3faf7c663060ep-5,
+        -0x1.21681b5c8c213p-5, -0x1.0362241e638ecp-5, -0x1.cb38fccd8bfdbp-6,
+        -0x1.902c31d62a843p-6, -0x1.559bd2406c3bap-6, -0x1.1b85d6044e9aep-6,
+        -0x1.c3d0837784c41p-7, -0x1.51824c7587eb0p-7, -0x1.c03a80ae5e054p-8,
+        -0x1.be76bd77b4fc3p-9, 0x0p+0
+    };
+
+    // ln(10)^k / k!
+    static inline constexpr double EXP10_C1 = 0x1.26bb1bbb55516p+1;
+    static inline constexpr double EXP10_C2 = 0x1.53524c73cea69p+1;
+    static inline constexpr double EXP10_C3 = 0x1.0470591de2ca4p+1;
+    static inline constexpr double EXP10_C4 = 0x1.2bd7609fd98c4p+0;
+    static inline constexpr double EXP10_C5 = 0x1.1429ffd1d4d76p-1;
+    static inline constexpr double EXP10_C6 = 0x1.a7ed70847c8b6p-3;
+    static inline constexpr double EXP10_C7 = 0x1.16e4dfc333a87p-4;
+    // 2 / (k ln(10)), with the rounding error of the leading one in A1_LO
+    static inline constexpr double LOG10_A1 = 0x1.bcb7b1526e50ep-1;
+    static inline constexpr double LOG10_A1_LO = 0x1.95355baaafad3p-56;
+    static inline constexpr double LOG10_A3 = 0x1.287a7636f435fp-2;
+    static inline constexpr double LOG10_A5 = 0x1.63c62775250d8p-3;
+    static inline constexpr double LOG10_A7 = 0x1.fc3fa615105c7p-4;
+    // log10(2) split so that k * LOG10_2_HI is exact for every exponent k
+    static inline constexpr double LOG10_2_HI = 0x1.3441350800000p-2;
+    static inline constexpr double LOG10_2_LO = 0x1.f79fef311f12bp-34;
+    // Adding this rounds a double below 2^51 to an integer, kept in the low
+    // mantissa bits
+    static inline constexpr double ROUND_MAGIC = 0x1.8p52;
+
+    // Max errors in ulps, measured against long double results
+    static inline constexpr double EXP10_MAX_ULP = 1.5;
+    static inline constexpr double LOG10_MAX_ULP = 3.0;
+
+    static MAYBE_CONSTEXPR double exp10(const double x) {
+        if (!(std::abs(x) < 1)) {
+            return std::pow(10.0, x);
+        }
+        const double jd = (x * 64 + ROUND_MAGIC) - ROUND_MAGIC;
+        const auto j = static_cast<std::int64_t>(jd);
+        const double r = (x * 64 - jd) * (1.0 / 64);
+        const double p =
+            r * (EXP10_C1 +
+                 r * (EXP10_C2 +
+                      r * (EXP10_C3 +
+                           r * (EXP10_C4 +
+                                r * (EXP10_C5 + r * (EXP10_C6 + r * EXP10_C7))))));
+        const double t = Exp10Table[static_cast<std::size_t>(j + 64)];
+        return t + t * p;
+    }
+
+    static MAYBE_CONSTEXPR double log10(const double x) {
+        if (!(x >= std::numeric_limits<double>::min() &&
+              x < std::numeric_limits<double>::infinity())) {
+            return std::log10(x);
+        }
+        const auto bits = std::bit_cast<std::uint64_t>(x);
+        const double m = std::bit_cast<double>((bits & 0x000FFFFFFFFFFFFF) |
+                                               0x3FF0000000000000);
+        const double jd = ((m - 1) * 64 + ROUND_MAGIC) - ROUND_MAGIC;
+        const auto j = static_cast<std::size_t>(jd);
+        const double c = 1 + jd * (1.0 / 64);
+        const double k = static_cast<double>(static_cast<int>(bits >> 52) - 1023 +
+                                             (j >= 27 ? 1 : 0));
+        const double s = (m - c) / (m + c);
+        const double s2 = s * s;
+        const double series =
+            s * LOG10_A1 +
+            s * (LOG10_A1_LO + s2 * (LOG10_A3 + s2 * (LOG10_A5 + s2 * LOG10_A7)));
+        return k * LOG10_2_HI + ((k * LOG10_2_LO + Log10Table[j]) + series);
+    }
+};
+
 class BigNum {
     using man_t = double;    // mantissa type
     using exp_t = uintmax_t; // exponent type
 
     friend std::ostream &operator<<(std::ostream &os, const BigNum &bn);
     friend std::istream &operator>>(std::istream &is, BigNum &bn);
+    friend class BigNumArray;
+    friend class UnnormalizedBigNum;
+    friend class BigNum64;
+    friend class BigLog;
+    friend class GeneratorChain;
+    friend class AtomicBigNum;
 
   private:
     man_t m = 0; // mantissa
@@ -136,61 +410,14 @@ class BigNum {
                   "exponent must be an arithmetic type");
 
     static inline constexpr exp_t MAX_DIV_DIFF = 308;
-    // helper functions to convert strings to mantissa/exponent
-    static inline MAYBE_CONSTEXPR man_t strtom(const std::string_view &sv) {
-        man_t m;
-        auto result = std::from_chars(sv.data(), sv.data() + sv.size(), m);
-        if (result.ec != std::errc()) {
-            throw std::invalid_argument(
-                "Failed to convert string to mantissa: " + std::string(sv));
-        }
-        return m;
-    }
-    static inline MAYBE_CONSTEXPR exp_t strtoe(const std::string_view &sv) {
-        exp_t e;
-        auto result = std::from_chars(sv.data(), sv.data() + sv.size(), e);
-        if (result.ec != std::errc()) {
-            throw std::invalid_argument(
-                "Failed to convert string to exponent: " + std::string(sv));
-        }
-        return e;
-    }
-
-    // convert the number to a full-precision string
-    static MAYBE_CONSTEXPR std::string to_string_full(const man_t &value) {
-        std::ostringstream out;
-        out << std::setprecision(std::numeric_limits<man_t>::digits10 + 1)
-            << value;
-        return out.str();
-    }
-
-    // convert double to string, rounding down and up to specific precision
-    static MAYBE_CONSTEXPR std::string to_string_floor(const double &value,
-                                       const int &precision) {
-        // Assumes value is normalized to 1 digit before the decimal point
-        // (|value| < 10)
-        assert(value > -10 && value < 10 && "Value must be normalized");
-        double scale = std::pow(10.0, precision);
-        double truncated_value = std::floor(value * scale) / scale;
-
-        std::ostringstream out;
-        out << std::fixed << std::setprecision(precision) << truncated_value;
-        std::string out_str = out.str();
-
-        // If necessary, round down to always return 1 digit before the decimal
-        // point This is to avoid rounding errors when the number is close to 10
-        // Should always be correct given our assumption that |value| < 10
-        if (out_str.substr(0, 3) == "10"s + DECIMAL_SEPARATOR) {
-            out_str = "9"s + DECIMAL_SEPARATOR + std::string(precision, '9');
-        } else if (out_str.substr(0, 4) == "-10"s + DECIMAL_SEPARATOR) {
-            out_str = "-9"s + DECIMAL_SEPARATOR + std::string(precision, '9');
-        }
-        return out_str;
-    }
-
+#ifdef BIGNUM_FAST_MATH
+    static inline constexpr bool FAST_MATH = true;
+#else
+    static inline constexpr bool FAST_MATH = false;
+#endif
 // Fallback implemnetation in case of non-std::nextafter
 #if defined(CONSTEXPR_NEXTAFTER_FALLBACK) && !defined(_MSC_VER)
-    static double _prev_double(double x) {
+    static MAYBE_CONSTEXPR double _prev_double(double x) {
         using uint = std::uint64_t;
         static_assert(sizeof(double) == sizeof(uint),
                       "Size of float and uint must be the same");
@@ -207,7 +434,7 @@ class BigNum {
         return std::bit_cast<double>(bits);
     }
 
-    static double _next_double(double x) {
+    static MAYBE_CONSTEXPR double _next_double(double x) {
         using uint = std::uint64_t;
         static_assert(sizeof(double) == sizeof(uint),
                       "Size of float and uint must be the same");
@@ -227,7 +454,7 @@ class BigNum {
 
 // Fallback to std::log10 if not on C++26
 #if !CPP26
-    static int _log10(double x) {
+    static MAYBE_CONSTEXPR int _log10(double x) {
         assert(x > 0.0 && "x must be positive for log10");
         int exponent = 0;
         while (x >= 10.0) {
@@ -242,6 +469,46 @@ class BigNum {
     }
 #endif
 
+    // <cmath> functions used by the core, evaluated without builtins in
+    // constant expressions since not every compiler folds them yet
+    static MAYBE_CONSTEXPR bool _isnan(double x) {
+        if consteval {
+            return x != x;
+        }
+        return std::isnan(x);
+    }
+    static MAYBE_CONSTEXPR bool _isinf(double x) {
+        if consteval {
+            return x == std::numeric_limits<double>::infinity() ||
+                   x == -std::numeric_limits<double>::infinity();
+        }
+        return std::isinf(x);
+    }
+    static MAYBE_CONSTEXPR double _abs(double x) {
+        if consteval {
+            return std::bit_cast<double>(std::bit_cast<std::uint64_t>(x) &
+                                         ~(std::uint64_t(1) << 63));
+        }
+        return std::abs(x);
+    }
+    // Rounds half away from zero, like std::round
+    static MAYBE_CONSTEXPR double _round(double x) {
+        if consteval {
+            if (!(_abs(x) < 0x1p52)) {
+                return x; // already integral, or inf/NaN
+            }
+            double t = static_cast<double>(static_cast<std::int64_t>(x));
+            if (_abs(x - t) >= 0.5) {
+                t += x < 0 ? -1.0 : 1.0;
+            }
+            // Keep the sign of x, so that -0.4 rounds to -0.0
+            return std::bit_cast<double>(
+                (std::bit_cast<std::uint64_t>(t) & ~(std::uint64_t(1) << 63)) |
+                (std::bit_cast<std::uint64_t>(x) & (std::uint64_t(1) << 63)));
+        }
+        return std::round(x);
+    }
+
     MAYBE_CONSTEXPR BigNum(const man_t mantissa, const exp_t exponent, bool normalize)
         : m(mantissa), e(exponent) {
         if (normalize)
@@ -249,20 +516,271 @@ class BigNum {
     }
 
     MAYBE_CONSTEXPR void parseStr(const std::string_view &sv) {
-        try {
-            size_t pos = sv.find('e');
-            if (pos != std::string::npos) {
-                m = strtom(sv.substr(0, pos));
-                e = strtoe(sv.substr(pos + 1));
+        if consteval {
+            *this = parse_constexpr(sv);
+            return;
+        }
+        const char *last = sv.data() + sv.size();
+        auto [ptr, ec] = from_chars(sv.data(), last, *this);
+        if (ec != std::errc() || ptr != last) {
+            *this = nan();
+            if constexpr (USE_EXCEPTIONS) {
+                BIGNUM_FATAL(std::invalid_argument("Failed to parse number: " +
+                                                   std::string(sv)));
+            }
+        }
+    }
+
+    /* Compile-time counterpart of from_chars(), used by parseStr() in
+     * constant expressions and by the _bn literal. Accepts an optional '-',
+     * digits (with optional ' digit separators), an optional '.' and fraction,
+     * an optional 'e' or 'E' exponent, and inf/nan. The first 19 significant
+     * digits are scaled in long double, so the mantissa can differ from the
+     * runtime parser in the last bit
+     */
+    static MAYBE_CONSTEXPR BigNum parse_constexpr(const std::string_view sv) {
+        // Without exceptions, abort() still stops constant evaluation
+        auto fail = [] { BIGNUM_FATAL(std::invalid_argument("Failed to parse number")); };
+        auto is_digit = [](char c) { return c >= '0' && c <= '9'; };
+        size_t i = 0;
+        const bool negative = !sv.empty() && sv[0] == '-';
+        i += negative;
+        const man_t sign = negative ? -1.0 : 1.0;
+
+        std::string_view rest = sv.substr(i);
+        if (rest == "inf" || rest == "infinity" || rest == "INF" || rest == "Infinity") {
+            return BigNum(sign * std::numeric_limits<man_t>::infinity(), 0, false);
+        }
+        if (rest == "nan" || rest == "NaN" || rest == "NAN") {
+            return BigNum(std::numeric_limits<man_t>::quiet_NaN(), 0, false);
+        }
+
+        // Significant digits, and the power of ten that scales them
+        std::uint64_t digits = 0;
+        int kept = 0;
+        std::int64_t scale = 0;
+        bool any_digit = false;
+        bool fraction = false;
+        for (; i < sv.size(); ++i) {
+            char c = sv[i];
+            if (c == '\'') {
+                continue;
+            }
+            if (c == '.' && !fraction) {
+                fraction = true;
+                continue;
+            }
+            if (!is_digit(c)) {
+                break;
+            }
+            any_digit = true;
+            if (digits == 0 && c == '0') {
+                scale -= fraction; // leading zero
+            } else if (kept < 19) {
+                digits = digits * 10 + static_cast<std::uint64_t>(c - '0');
+                ++kept;
+                scale -= fraction;
             } else {
-                m = strtom(sv);
-                e = 0;
+                scale += !fraction; // dropped digit
+            }
+        }
+        if (!any_digit) {
+            fail();
+        }
+
+        exp_t exponent = 0;
+        if (i < sv.size() && (sv[i] == 'e' || sv[i] == 'E')) {
+            if (++i == sv.size()) {
+                fail();
+            }
+            for (; i < sv.size(); ++i) {
+                if (!is_digit(sv[i])) {
+                    fail();
+                }
+                const auto digit = static_cast<exp_t>(sv[i] - '0');
+                if (exponent > (std::numeric_limits<exp_t>::max() - digit) / 10) {
+                    fail();
+                }
+                exponent = exponent * 10 + digit;
+            }
+        }
+        if (i != sv.size()) {
+            fail();
+        }
+
+        // Large integer parts move into the exponent, like from_chars()
+        exp_t shift = 0;
+        if (scale > 280) {
+            shift = static_cast<exp_t>(scale - 280);
+            scale = 280;
+        }
+        // The mantissa has kept - 1 + scale integer digits past the first,
+        // which normalizing carries into the exponent as well
+        const std::int64_t carry = digits == 0 ? 0 : std::max<std::int64_t>(kept - 1 + scale, 0);
+        if (exponent > std::numeric_limits<exp_t>::max() - shift ||
+            exponent + shift > std::numeric_limits<exp_t>::max() - static_cast<exp_t>(carry)) {
+            fail();
+        }
+        long double power = 1, base = 10;
+        for (std::uint64_t n = scale < 0 ? -scale : scale; n != 0; n >>= 1) {
+            if (n & 1) {
+                power *= base;
+            }
+            base *= base;
+        }
+        long double mantissa = static_cast<long double>(digits);
+        mantissa = scale < 0 ? mantissa / power : mantissa * power;
+        return BigNum(sign * static_cast<man_t>(mantissa), exponent + shift);
+    }
+
+    // Exponent alignment step of add(), before normalization. Shared with the
+    // BigNumArray kernels so that both round identically
+    static MAYBE_CONSTEXPR void align_add(const man_t am, const exp_t ae,
+                                          const man_t bm, const exp_t be,
+                                          man_t &m2, exp_t &e2) {
+        bool this_is_bigger = ae > be;
+        exp_t delta = this_is_bigger ? ae - be : be - ae;
+        if (delta > 14) {
+            m2 = this_is_bigger ? am : bm;
+            e2 = this_is_bigger ? ae : be;
+        } else if (this_is_bigger) {
+            m2 = am * (*Pow10::get(delta)) + bm;
+            e2 = be;
+        } else {
+            m2 = am + bm * (*Pow10::get(delta));
+            e2 = ae;
+        }
+    }
+
+    /* Fused operations take their fast path only for finite operands with
+     * exponents below FUSED_MAX_E, where sums of two exponents cannot wrap.
+     * Everything else goes through the unfused operations
+     */
+    static inline constexpr exp_t FUSED_MAX_E = exp_t(1) << 62;
+    MAYBE_CONSTEXPR bool fusable() const {
+        return !_isnan(m) && !_isinf(m) && e < FUSED_MAX_E;
+    }
+
+    // c + pm * 10^pe with a single alignment and normalize, for a product
+    // mantissa 1 <= |pm| < 100
+    static MAYBE_CONSTEXPR BigNum fused_add(man_t pm, exp_t pe, const BigNum &c) {
+        if (_abs(pm) >= 10) {
+            pm /= 10;
+            ++pe;
+        }
+        man_t m2;
+        exp_t e2;
+        align_add(pm, pe, c.m, c.e, m2, e2);
+        return BigNum(m2, e2);
+    }
+
+    // Splits a normal double into fm * 10^fe with 1 <= |fm| < 10
+    static bool split_pow10(const man_t x, man_t &fm, int &fe) {
+        const man_t a = std::abs(x);
+        if (!(a >= 1e-300 && a <= std::numeric_limits<man_t>::max())) {
+            return false;
+        }
+        // floor(log10(2^k)) is at most one below floor(log10(a)), and much
+        // cheaper than std::log10
+        fe = static_cast<int>(std::floor(std::ilogb(a) * std::numbers::log10e /
+                                         std::numbers::log2e));
+        fm = fe >= 0 ? x / *Pow10::get(fe) : x * *Pow10::get(-fe);
+        if (std::abs(fm) >= 10) {
+            fm /= 10;
+            ++fe;
+        } else if (std::abs(fm) < 1) {
+            fm *= 10;
+            --fe;
+        }
+        return true;
+    }
+
+    // *this + x * factor, where factor = fm * 10^fe was split by the caller
+    BigNum scaled_add(const BigNum &x, const man_t factor, const man_t fm,
+                      const int fe) const {
+        const man_t pm = x.m * fm;
+        const man_t a = std::abs(pm);
+        if (!(a >= 1 && a < 100) || x.e >= FUSED_MAX_E || !fusable() ||
+            (fe < 0 && x.e < static_cast<exp_t>(-fe))) {
+            return add(x.mul(BigNum(factor)));
+        }
+        const exp_t pe = fe >= 0 ? x.e + static_cast<exp_t>(fe)
+                                 : x.e - static_cast<exp_t>(-fe);
+        return fused_add(pm, pe, *this);
+    }
+
+    // *this * 10^log without materializing 10^log, or nullopt when 10^log is
+    // beyond the fused range
+    std::optional<BigNum> mul_pow10(const double log) const {
+        if (!std::isfinite(log) ||
+            std::abs(log) >= static_cast<double>(FUSED_MAX_E)) {
+            return std::nullopt;
+        }
+        const double whole = std::floor(log);
+        const man_t f = std::pow(10.0, log - whole);
+        if (whole >= 0) {
+            return mul(BigNum(f, static_cast<exp_t>(whole), false));
+        }
+        const auto down = static_cast<exp_t>(-whole);
+        if (down <= e) {
+            return BigNum(m * f, e - down);
+        }
+        if (down - e > static_cast<exp_t>(Pow10TableOffset)) {
+            return BigNum();
+        }
+        return BigNum(m * f * *Pow10::get(-static_cast<int>(down - e)), 0);
+    }
+
+    // The current thread's default context with another print precision
+    static BigNumContext with_precision(unsigned int precision) {
+        BigNumContext ctx = DefaultBigNumContext;
+        ctx.print_precision = precision;
+        return ctx;
+    }
+
+    // Runs a to_chars-style writer into a string sized by max_chars()
+    template <typename Writer>
+    static std::string chars_to_string(const BigNumContext &ctx, Writer &&write) {
+        std::string str(max_chars(ctx) * 4 / 3, '\0');
+        for (;;) {
+            auto [ptr, ec] = write(str.data(), str.data() + str.size());
+            if (ec == std::errc()) {
+                str.resize(ptr - str.data());
+                return str;
+            }
+            if (ec != std::errc::value_too_large) {
+                if constexpr (USE_EXCEPTIONS) {
+                    BIGNUM_FATAL(std::invalid_argument("Precision out of range: " +
+                                                       std::to_string(ctx.print_precision)));
+                } else {
+                    return std::string();
+                }
             }
-            normalize();
-        } catch (const std::invalid_argument &ex) {
-            throw std::invalid_argument(
-                std::string("Failed to parse number: ") + ex.what());
+            // Only reachable for mantissas that were never normalized
+            str.resize(2 * str.size());
+        }
+    }
+
+    // Little-endian 64-bit load/store for the binary format
+    static void store_le(std::byte *out, std::uint64_t bits) {
+        if constexpr (std::endian::native == std::endian::little) {
+            std::memcpy(out, &bits, 8);
+            return;
+        }
+        for (int i = 0; i < 8; ++i) {
+            out[i] = static_cast<std::byte>(bits >> (8 * i));
+        }
+    }
+    static std::uint64_t load_le(const std::byte *in) {
+        std::uint64_t bits = 0;
+        if constexpr (std::endian::native == std::endian::little) {
+            std::memcpy(&bits, in, 8);
+            return bits;
+        }
+        for (int i = 0; i < 8; ++i) {
+            bits |= std::to_integer<std::uint64_t>(in[i]) << (8 * i);
         }
+        return bits;
     }
 
     MAYBE_CONSTEXPR void set(const BigNum &other) {
@@ -270,46 +788,104 @@ class BigNum {
         e = other.e;
     }
 
-  public:
-    static MAYBE_CONSTEXPR const BigNum &inf() {
-        static BigNum inf_val(std::numeric_limits<man_t>::infinity(),
-                                        0, false);
+    // Helpers for the series functions
+    // Throws for invalid ratios, or returns false without exceptions
+    static bool check_ratio(const double price_ratio) {
+        if (!(price_ratio > 0) || std::isinf(price_ratio)) {
+            if constexpr (USE_EXCEPTIONS) {
+                BIGNUM_FATAL(std::domain_error("Price ratio must be positive and finite"));
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // The value as a double, inf past double range
+    static double to_double(const BigNum &v) {
+        if (v.e > static_cast<exp_t>(std::numeric_limits<double>::max_exponent10)) {
+            return v.m == 0 ? 0.0 : std::copysign(std::numeric_limits<double>::infinity(), v.m);
+        }
+        return v.m * (*Pow10::get(static_cast<int>(v.e)));
+    }
+
+    // 10^log as a BigNum, clamped to max() past the exponent range
+    static MAYBE_CONSTEXPR BigNum exp10(const double log) {
+        if (std::isnan(log)) {
+            return nan();
+        }
+        if (log >= static_cast<double>(std::numeric_limits<exp_t>::max())) {
+            return max();
+        }
+        if (log < 0) {
+            return BigNum(math_exp10<FAST_MATH>(log));
+        }
+        const double whole = std::floor(log);
+        return BigNum(math_exp10<FAST_MATH>(log - whole), static_cast<exp_t>(whole));
+    }
+
+    // log10((r^n - 1) / (r - 1)), the number of first-item prices in n items
+    static double log10_geometric_factor(const double n, const double r) {
+        if (r == 1) {
+            return std::log10(n);
+        }
+        const double x = n * std::log(r);
+        if (x > 40) {
+            return x / std::numbers::ln10 - std::log10(r - 1);
+        }
+        return std::log10(std::abs(std::expm1(x))) - std::log10(std::abs(r - 1));
+    }
 
-        return inf_val;
+    // floor(n) as a BigNum, corrected by one if rounding in the closed form
+    // put it on the wrong side of the budget
+    template <typename Affordable>
+    static BigNum floor_count(const double n, Affordable &&affordable) {
+        if (std::isinf(n)) {
+            return inf();
+        }
+        if (!(n > 0)) {
+            return BigNum();
+        }
+        if (n >= 0x1p53) {
+            return BigNum(std::floor(n));
+        }
+        BigNum count(std::floor(n));
+        if (count.m > 0 && !affordable(count)) {
+            return count - 1.0;
+        }
+        if (affordable(count + 1.0)) {
+            return count + 1.0;
+        }
+        return count;
     }
-    static MAYBE_CONSTEXPR const BigNum &nan() {
-        static BigNum nan_val(std::numeric_limits<man_t>::quiet_NaN(),
-                                        0, false);
 
-        return nan_val;
+  public:
+    // Returned by value so that they are usable in constant expressions
+    static MAYBE_CONSTEXPR BigNum inf() {
+        return BigNum(std::numeric_limits<man_t>::infinity(), 0, false);
     }
-    static MAYBE_CONSTEXPR const BigNum &max() {
+    static MAYBE_CONSTEXPR BigNum nan() {
+        return BigNum(std::numeric_limits<man_t>::quiet_NaN(), 0, false);
+    }
+    static MAYBE_CONSTEXPR BigNum max() {
 #if defined(CONSTEXPR_NEXTAFTER_FALLBACK) && !defined(_MSC_VER)
-        static const BigNum max_val(
-            _prev_double(10.0), std::numeric_limits<exp_t>::max(), false);
+        return BigNum(_prev_double(10.0), std::numeric_limits<exp_t>::max(), false);
 #else
-        static const BigNum max_val(std::nextafter(10.0, 0.0),
-                                              std::numeric_limits<exp_t>::max(),
-                                              false);
+        return BigNum(std::nextafter(10.0, 0.0), std::numeric_limits<exp_t>::max(),
+                      false);
 #endif
-
-        return max_val;
     }
-    static MAYBE_CONSTEXPR const BigNum &min() {
+    static MAYBE_CONSTEXPR BigNum min() {
 #if defined(CONSTEXPR_NEXTAFTER_FALLBACK) && !defined(_MSC_VER)
-        static const BigNum min_val(
-            _next_double(-10.0), std::numeric_limits<exp_t>::max(), false);
+        return BigNum(_next_double(-10.0), std::numeric_limits<exp_t>::max(), false);
 #else
-        static const BigNum min_val(std::nextafter(-10.0, 0.0),
-                                              std::numeric_limits<exp_t>::max(),
-                                              false);
+        return BigNum(std::nextafter(-10.0, 0.0), std::numeric_limits<exp_t>::max(),
+                      false);
 #endif
-
-        return min_val;
     }
 
-    man_t getM() const { return m; }
-    exp_t getE() const { return e; }
+    MAYBE_CONSTEXPR man_t getM() const { return m; }
+    MAYBE_CONSTEXPR exp_t getE() const { return e; }
 
     MAYBE_CONSTEXPR BigNum(const man_t mantissa, const exp_t exponent = 0) {
         m = mantissa;
@@ -333,11 +909,11 @@ class BigNum {
         if (*this == max() || *this == min()) {
             return;
         }
-        if (std::isnan(m)) {
+        if (_isnan(m)) {
             e = 0;
             return;
         }
-        if (std::isinf(m)) {
+        if (_isinf(m)) {
             e = 0;
             return;
         }
@@ -345,22 +921,37 @@ class BigNum {
             e = 0;
             return;
         }
-        if (std::abs(m) < 1 && e == 0) {
+        if (_abs(m) < 1 && e == 0) {
             return;
         }
 
         // Start normalization
         int n_log;
 #if !CPP26
-        n_log = std::max(_log10(std::abs(m)), 0);
+        n_log = _log10(_abs(m));
 #else
-        n_log =
-            std::max(static_cast<int>(std::floor(std::log10(std::abs(m)))), 0);
+        n_log = static_cast<int>(std::floor(std::log10(std::abs(m))));
 #endif
 
-        // if (n_log < 0) { n_log = 0; }
-        m = m / (*Pow10::get(n_log));
-        e += n_log;
+        if (n_log >= 0) {
+            m = m / (*Pow10::get(n_log));
+            e += n_log;
+        } else {
+            // Mantissa under 1 (e.g. after a division): borrow from the
+            // exponent, but never below 0
+            exp_t k = std::min(static_cast<exp_t>(-n_log), e);
+            m = m * (*Pow10::get(static_cast<int>(k)));
+            e -= k;
+        }
+
+        // The powers of ten are rounded, so the shifted mantissa can land an
+        // ulp outside [1, 10), e.g. 1e300 / 1e300 < 1. Only exponent 0 keeps
+        // fractions
+        if (e > 0 && _abs(m) < 1) {
+            m = m < 0 ? -1.0 : 1.0;
+        } else if (_abs(m) >= 10) {
+            m = m < 0 ? min().m : max().m;
+        }
 
         // Clamp between max and min
         if (*this > max()) {
@@ -374,8 +965,14 @@ class BigNum {
         // precision
         if (e < std::numeric_limits<man_t>::max_digits10) {
             double target_precision = Pow10::get(e).value_or(1.0);
-            m = std::round(m * target_precision) / target_precision;
+            m = _round(m * target_precision) / target_precision;
             // m = std::floor(m * target_precision) / target_precision;
+
+            // Rounding can carry into the next power of ten (9.9 -> 10)
+            if (_abs(m) >= 10) {
+                m /= 10;
+                ++e;
+            }
         }
     }
 
@@ -387,7 +984,7 @@ class BigNum {
         if (m == m_inf || b.m == m_inf) {
             return inf();
         }
-        if (std::isnan(m) || std::isnan(b.m)) {
+        if (_isnan(m) || _isnan(b.m)) {
             return nan();
         }
 
@@ -411,20 +1008,9 @@ class BigNum {
         }
 
         // Handle general case
-        bool this_is_bigger = e > b.e;
-        exp_t delta = this_is_bigger ? e - b.e : b.e - e;
         man_t m2;
         exp_t e2;
-        if (delta > 14) {
-            m2 = this_is_bigger ? m : b.m;
-            e2 = this_is_bigger ? e : b.e;
-        } else if (this_is_bigger) {
-            m2 = m * (*Pow10::get(delta)) + b.m;
-            e2 = b.e;
-        } else {
-            m2 = m + b.m * (*Pow10::get(delta));
-            e2 = e;
-        }
+        align_add(m, e, b.m, b.e, m2, e2);
 
         return BigNum(m2, e2);
     }
@@ -448,11 +1034,63 @@ class BigNum {
             return BigNum(static_cast<man_t>(0));
         }
 
+        // Result below 10^0: fold the exponent difference into the mantissa
+        if (b.e > e) {
+            return BigNum(m / b.m / (*Pow10::get(static_cast<int>(b.e - e))), 0);
+        }
+
         // Perform division
         return BigNum(m / b.m, e - b.e);
     }
 
-    MAYBE_CONSTEXPR BigNum abs() const { return BigNum(std::abs(m), e); }
+    /* Fused operations: one exponent alignment and one normalize instead of
+     * one per intermediate result, and no clamping of the intermediates
+     * fma(a, b, c)            a * b + c
+     * scaled_add(x, factor)   *this + x * factor, e.g. balance + rate * dt
+     * mul_pow(base, power)    *this * base^power, e.g. compound growth
+     * Results can differ from the unfused expressions in the last digits,
+     * since the intermediate product is not rounded
+     */
+    static MAYBE_CONSTEXPR BigNum fma(const BigNum &a, const BigNum &b,
+                                      const BigNum &c) {
+        const man_t pm = a.m * b.m;
+        const man_t abs_pm = _abs(pm);
+        if (!(abs_pm >= 1 && abs_pm < 100) || a.e >= FUSED_MAX_E ||
+            b.e >= FUSED_MAX_E || !c.fusable()) {
+            return a.mul(b).add(c);
+        }
+        return fused_add(pm, a.e + b.e, c);
+    }
+
+    BigNum scaled_add(const BigNum &x, const man_t factor) const {
+        man_t fm = 0;
+        int fe = 0;
+        if (!split_pow10(factor, fm, fe)) {
+            return add(x.mul(BigNum(factor)));
+        }
+        return scaled_add(x, factor, fm, fe);
+    }
+
+    BigNum mul_pow(const BigNum &base, const double power) const {
+        if (base.m > 0 && base.fusable()) {
+            const double log = power * (std::log10(base.m) + static_cast<double>(base.e));
+            if (auto r = mul_pow10(log)) {
+                return *r;
+            }
+        }
+        return mul(base.pow(power));
+    }
+    // Base as a double, for growth rates such as 1.07 that BigNum would round
+    BigNum mul_pow(const man_t base, const double power) const {
+        if (base > 0) {
+            if (auto r = mul_pow10(power * std::log10(base))) {
+                return *r;
+            }
+        }
+        return mul(BigNum(base).pow(power));
+    }
+
+    MAYBE_CONSTEXPR BigNum abs() const { return BigNum(_abs(m), e); }
 
     MAYBE_CONSTEXPR BigNum negate() const {
         return mul(BigNum(static_cast<man_t>(-1)));
@@ -491,6 +1129,10 @@ class BigNum {
             // Divisor is significantly larger than dividend, result is 0
             m = 0;
             e = 0;
+        } else if (b.e > e) {
+            // Result below 10^0
+            m = m / b.m / (*Pow10::get(static_cast<int>(b.e - e)));
+            e = 0;
         } else {
             // Perform division
             m /= b.m;
@@ -569,8 +1211,8 @@ class BigNum {
     // Comparison operations
     MAYBE_CONSTEXPR bool is_positive() const { return m >= 0; }
     MAYBE_CONSTEXPR bool is_negative() const { return m < 0; }
-    MAYBE_CONSTEXPR bool is_inf() const { return std::isinf(m); }
-    MAYBE_CONSTEXPR bool is_nan() const { return std::isnan(m); }
+    MAYBE_CONSTEXPR bool is_inf() const { return _isinf(m); }
+    MAYBE_CONSTEXPR bool is_nan() const { return _isnan(m); }
     static MAYBE_CONSTEXPR BigNum &max(BigNum &a, BigNum &b) { return a > b ? a : b; }
     static MAYBE_CONSTEXPR BigNum &min(BigNum &a, BigNum &b) { return a < b ? a : b; }
 
@@ -578,8 +1220,9 @@ class BigNum {
         if (is_nan() || b.is_nan())
             return std::partial_ordering::unordered;
 
-        if (is_inf() && b.is_inf())
-            return std::partial_ordering::equivalent;
+        // Infinities are stored with e == 0, so order them by mantissa alone
+        if (is_inf() || b.is_inf())
+            return (is_inf() ? m : 0.0) <=> (b.is_inf() ? b.m : 0.0);
 
         if (m == b.m && e == b.e)
             return std::partial_ordering::equivalent;
@@ -606,9 +1249,10 @@ class BigNum {
                 return std::partial_ordering::less;
             if (e < b.e)
                 return std::partial_ordering::greater;
+            // Same exponent: the mantissa closer to zero is the larger value
             if (m > b.m)
-                return std::partial_ordering::less;
-            return std::partial_ordering::greater; // m != b.m, and m < b.m
+                return std::partial_ordering::greater;
+            return std::partial_ordering::less; // m != b.m, and m < b.m
         }
     }
     // Equality operator (only use this under the assumption that the numbers
@@ -624,149 +1268,611 @@ class BigNum {
     }
 
     // Conversion methods
-    std::string to_string(
-        const unsigned int &precision = DefaultBigNumContext.print_precision) const {
-        if (this->is_inf()) {
-            return "inf";
+
+    // Upper bound for the length of to_chars() output with this context
+    static unsigned int max_chars(const BigNumContext &ctx) {
+        return std::max(ctx.print_precision, ctx.max_digits) + 32;
+    }
+    static unsigned int max_chars(const unsigned int &precision =
+                                      DefaultBigNumContext.print_precision) {
+        return max_chars(with_precision(precision));
+    }
+
+    // Writes the same text as to_string(ctx) into [first, last) without
+    // allocating. Returns {end of text, std::errc()} on success, or
+    // {last, std::errc::value_too_large} if the buffer is too small
+    std::to_chars_result to_chars(char *first, char *last,
+                                  const BigNumContext &ctx) const {
+        auto result = to_chars_point(first, last, ctx);
+        if (result.ec == std::errc() && ctx.decimal_separator != '.') {
+            std::replace(first, result.ptr, '.', ctx.decimal_separator);
         }
-        if (this->is_nan()) {
-            return "nan";
+        return result;
+    }
+    std::to_chars_result to_chars(
+        char *first, char *last,
+        const unsigned int &precision =
+            DefaultBigNumContext.print_precision) const {
+        return to_chars(first, last, with_precision(precision));
+    }
+
+  private:
+    // to_chars() with '.' as the decimal separator
+    std::to_chars_result to_chars_point(char *first, char *last,
+                                        const BigNumContext &ctx) const {
+        const unsigned int precision = ctx.print_precision;
+        const std::to_chars_result too_large{last, std::errc::value_too_large};
+        if (this->is_inf() || this->is_nan()) {
+            std::string_view str = this->is_inf() ? "inf" : "nan";
+            if (last - first < static_cast<std::ptrdiff_t>(str.size())) {
+                return too_large;
+            }
+            return {std::copy(str.begin(), str.end(), first), std::errc()};
         }
 
         // Handle small numbers directly
         if (e == 0) {
+            if (precision > static_cast<unsigned int>(Pow10TableOffset)) {
+                return {first, std::errc::invalid_argument};
+            }
 
             // Round down to specified precision
-            double scale = *Pow10::get(precision);
+            double scale = *Pow10::get(static_cast<int>(precision));
             double rounded = std::floor(m * scale) / scale;
-
-            // Use std::format for fixed precision and predictable output
-            std::string str = std::format("{:.{}f}", rounded, precision-1);
-
-            // Remove trailing zeroes and the decimal point if it's the last character
-            size_t last_nonzero_pos = str.find_last_not_of('0');
-            if (last_nonzero_pos != std::string::npos) {
-                if (str[last_nonzero_pos] == '.') {
-                    // Remove the decimal point if it's the last character after trimming zeros
-                    str.resize(last_nonzero_pos);
-                } else {
-                    // Trim trailing zeros
-                    str.resize(last_nonzero_pos + 1);
-                }
+            auto result =
+                std::to_chars(first, last, rounded, std::chars_format::fixed,
+                              static_cast<int>(precision == 0 ? 0 : precision - 1));
+            if (result.ec != std::errc()) {
+                return result;
             }
 
-            return str;
+            // Remove trailing zeroes and the decimal point if it's the last
+            // character
+            char *end = result.ptr;
+            while (end != first && end[-1] == '0') {
+                --end;
+            }
+            if (end == first) {
+                return result;
+            }
+            return {end[-1] == '.' ? end - 1 : end, std::errc()};
         }
 
         // Can this number be fully displayed as a string <= max_digits long?
         // Assumes m and e are already normalized
         unsigned int max_digits =
-            std::max(precision + 1, DefaultBigNumContext.max_digits);
+            std::max(precision + 1, ctx.max_digits);
         if (this->e < max_digits - 1) {
-            std::string str = to_string_full(m);
+            char digits[32];
+            auto result = std::to_chars(
+                digits, digits + sizeof(digits), m, std::chars_format::general,
+                std::numeric_limits<man_t>::digits10 + 1);
 
             // calculate new length based on
             exp_t newLen = std::min(static_cast<exp_t>(max_digits), e + 1) +
-                           (str[0] == '-' ? 1 : 0);
+                           (digits[0] == '-' ? 1 : 0);
 
             // Remove the decimal separator if it exists (and isn't small number
             // <1)
-            str.erase(
-                std::remove_if(str.begin(), str.end(),
-                               [](char c) { return c == DECIMAL_SEPARATOR; }),
-                str.end());
+            char *digits_end = std::remove(digits, result.ptr, '.');
+            exp_t len = static_cast<exp_t>(digits_end - digits);
+            if (static_cast<exp_t>(last - first) < newLen) {
+                return too_large;
+            }
 
             // If the string is shorter than the desired length, pad with zeros
-            if (str.length() < newLen) {
-                str += std::string(newLen - str.length(), '0');
-            } else {
-                // If the string is longer than the desired length, truncate it,
-                // and round the last digit if necessary
-                bool round_up = false;
-
-                int first_unused_digit_pos =
-                    (str.length() > newLen) ? newLen : -1;
-                int first_unused_digit =
-                    (first_unused_digit_pos > 0)
-                        ? int(str[first_unused_digit_pos] - '0')
-                        : -1;
-
-                if (first_unused_digit >= 5) {
-                    // Round up the last digit
-                    round_up = true;
+            if (len < newLen) {
+                char *end = std::copy(digits, digits_end, first);
+                return {std::fill_n(end, newLen - len, '0'), std::errc()};
+            }
+
+            // If the string is longer than the desired length, truncate it,
+            // and round the last digit if necessary, carrying into the digits
+            // before it (8699|9 -> 8700, 999|9 -> 1000)
+            char *end = std::copy_n(digits, newLen, first);
+            if (len > newLen && digits[newLen] - '0' >= 5) {
+                char *digit_begin = first + (first[0] == '-' ? 1 : 0);
+                char *p = end;
+                while (p != digit_begin && p[-1] == '9') {
+                    *--p = '0';
                 }
-                str = str.substr(0, newLen);
-                if (round_up) {
-                    assert(!str.empty() &&
-                           "String should not be empty after truncation");
-                    str[str.length() - 1] += 1;
+                if (p != digit_begin) {
+                    p[-1] += 1;
+                } else {
+                    if (end == last) {
+                        return too_large;
+                    }
+                    *digit_begin = '1';
+                    *end++ = '0';
                 }
             }
-            return str;
+            return {end, std::errc()};
         }
 
-        // Otherwise, use scientific notation
-        std::ostringstream out;
-        // out << std::fixed << std::setprecision(precision) << m;
-
-        // Handle max() and min() specifically due to rounding issues
-        // std::string m_str;
-        // if (*this == max()) { m_str = std::string("9.") +
-        // std::string(precision, '9'); } else if (*this == min()) { m_str =
-        // std::string("-9.") + std::string(precision, '9'); } else { m_str =
-        // to_string_floor(m, precision); }
+        // Otherwise, use scientific notation, with the mantissa rounded down
+        // to the given precision
+        assert(m > -10 && m < 10 && "Value must be normalized");
+        double scale = std::pow(10.0, precision);
+        double truncated_value = std::floor(m * scale) / scale;
+        auto result = std::to_chars(first, last, truncated_value,
+                                    std::chars_format::fixed,
+                                    static_cast<int>(precision));
+        if (result.ec != std::errc()) {
+            return result;
+        }
+        char *end = result.ptr;
 
-        // Trim the result to the desired precision
-        // std::string m_str = to_string_floor(m, 2);
-        // size_t dot_pos = m_str.find('.');
-        // if (dot_pos != std::string::npos && dot_pos + precision + 1 <
-        // m_str.size()) {
-        //     m_str = m_str.substr(0, dot_pos + precision + 1);
-        // }
-        std::string m_str = to_string_floor(m, precision);
-        out << m_str;
+        // If necessary, round down to always return 1 digit before the decimal
+        // point. This is to avoid rounding errors when the number is close to
+        // 10. Should always be correct given our assumption that |m| < 10
+        std::string_view m_str(first, end);
+        const size_t sign = m_str.starts_with('-') ? 1 : 0;
+        if (m_str.size() >= sign + 3 && m_str[sign] == '1' &&
+            m_str[sign + 1] == '0' && m_str[sign + 2] == '.') {
+            first[sign] = '9';
+            first[sign + 1] = '.';
+            end = std::fill_n(first + sign + 2, precision, '9');
+        }
 
         if (e != 0) {
-            out << "e" << e;
+            if (end == last) {
+                return too_large;
+            }
+            *end++ = 'e';
+            result = std::to_chars(end, last, e);
+            if (result.ec != std::errc()) {
+                return too_large;
+            }
+            end = result.ptr;
         }
+        return {end, std::errc()};
+    }
 
-        return out.str();
+  public:
+    std::string to_string(const BigNumContext &ctx) const {
+        return chars_to_string(ctx, [&](char *first, char *last) {
+            return to_chars(first, last, ctx);
+        });
+    }
+    std::string to_string(
+        const unsigned int &precision = DefaultBigNumContext.print_precision) const {
+        return to_string(with_precision(precision));
     }
 
     // Pretty string: 1234567 -> 1,234,567
     // Scientific notation is not affected
-    std::string to_pretty_string(
-        const unsigned int &precision = DefaultBigNumContext.print_precision) const {
-        std::string str = to_string(precision);
+    // Writes the same text as to_pretty_string(ctx), see to_chars()
+    std::to_chars_result to_pretty_chars(char *first, char *last,
+                                         const BigNumContext &ctx) const {
+        auto result = to_chars(first, last, ctx);
+        if (result.ec != std::errc()) {
+            return result;
+        }
+        std::string_view str(first, result.ptr);
 
         // Early exit if in scientific notation or if the number is too small
-        if (str.contains('e') || str.contains(DECIMAL_SEPARATOR)) {
-            return str;
+        if (str.contains('e') || str.contains(ctx.decimal_separator)) {
+            return result;
         }
         if (str.length() < 4) {
-            return str;
+            return result;
         }
 
-        // Insert thousands separators
-        for (size_t i = str.length() - 3; i > 0; i -= 3) {
-            str.insert(i, 1, THOUSANDS_SEPARATOR);
+        // Insert thousands separators, never directly after the sign, by
+        // shifting groups of 3 digits right, starting from the end
+        const size_t first_digit = (str[0] == '-') ? 1 : 0;
+        const size_t separators = (str.length() - first_digit - 1) / 3;
+        if (static_cast<size_t>(last - result.ptr) < separators) {
+            return {last, std::errc::value_too_large};
+        }
+        char *src = result.ptr;
+        char *dst = result.ptr + separators;
+        for (size_t i = 0; i < separators; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                *--dst = *--src;
+            }
+            *--dst = ctx.thousands_separator;
         }
-        return str;
+        return {result.ptr + separators, std::errc()};
+    }
+    std::to_chars_result to_pretty_chars(
+        char *first, char *last,
+        const unsigned int &precision =
+            DefaultBigNumContext.print_precision) const {
+        return to_pretty_chars(first, last, with_precision(precision));
+    }
+
+    std::string to_pretty_string(const BigNumContext &ctx) const {
+        return chars_to_string(ctx, [&](char *first, char *last) {
+            return to_pretty_chars(first, last, ctx);
+        });
+    }
+    std::string to_pretty_string(
+        const unsigned int &precision = DefaultBigNumContext.print_precision) const {
+        return to_pretty_string(with_precision(precision));
     }
 
-    // Standard methods for (de)serialization
+    // Standard methods for (de)serialization, in SerialBigNumContext whatever
+    // the thread's default context
     std::string serialize() const {
-        return to_string(SERIAL_PRECISION);
+        return to_string(SerialBigNumContext);
     }
 
     static BigNum deserialize(const std::string_view &str) {
-        return BigNum(str);
+        BigNum bn;
+        const char *last = str.data() + str.size();
+        auto [ptr, ec] = from_chars(str.data(), last, bn, SerialBigNumContext);
+        if (ec != std::errc() || ptr != last) {
+            if constexpr (USE_EXCEPTIONS) {
+                BIGNUM_FATAL(std::invalid_argument("Failed to parse number: " +
+                                                   std::string(str)));
+            } else {
+                return nan();
+            }
+        }
+        return bn;
     }
 
-    // Returns number as intmax_t, or nullopt if the number is too large
-    MAYBE_CONSTEXPR std::optional<intmax_t> to_number() const {
-        int total_digits = e + std::log10(std::abs(m)) + 1;
-        if (total_digits > std::numeric_limits<intmax_t>::digits10) {
+    /* Binary (de)serialization, exact and independent of host byte order
+     * Fixed:   16 bytes, mantissa bits then exponent, both little-endian
+     * Compact: 8 mantissa bytes, then the exponent as an LEB128 varint
+     *          (1 byte below 128, 2 bytes below 16384, at most 10)
+     */
+    enum class SerialFormat { Fixed, Compact };
+    static inline constexpr size_t SERIAL_FIXED_SIZE = 16;
+    static inline constexpr size_t SERIAL_MAX_SIZE = 18;
+
+    MAYBE_CONSTEXPR size_t
+    serialized_size(const SerialFormat format = SerialFormat::Fixed) const {
+        if (format == SerialFormat::Fixed) {
+            return SERIAL_FIXED_SIZE;
+        }
+        size_t size = 9;
+        for (exp_t rest = e >> 7; rest != 0; rest >>= 7) {
+            ++size;
+        }
+        return size;
+    }
+
+    // Returns the number of bytes written, or 0 if out is too small
+    size_t serialize_to(std::span<std::byte> out,
+                        const SerialFormat format = SerialFormat::Fixed) const {
+        static_assert(sizeof(man_t) == 8 && sizeof(exp_t) == 8,
+                      "binary format assumes 64-bit mantissa and exponent");
+        size_t size = serialized_size(format);
+        if (out.size() < size) {
+            return 0;
+        }
+        store_le(out.data(), std::bit_cast<std::uint64_t>(m));
+        if (format == SerialFormat::Fixed) {
+            store_le(out.data() + 8, e);
+            return size;
+        }
+        std::byte *p = out.data() + 8;
+        exp_t rest = e;
+        for (; rest >= 0x80; rest >>= 7) {
+            *p++ = static_cast<std::byte>((rest & 0x7F) | 0x80);
+        }
+        *p = static_cast<std::byte>(rest);
+        return size;
+    }
+
+    // Whether the value has the shape normalize() gives it, which operator==,
+    // sort_key() and hashing rely on: zero, inf, NaN and fractions only at
+    // exponent 0, and otherwise a mantissa in [1, 10)
+    MAYBE_CONSTEXPR bool is_normalized() const {
+        const man_t a = _abs(m);
+        if (_isnan(m) || _isinf(m) || a < 1) {
+            return e == 0;
+        }
+        return a < 10;
+    }
+
+    // Returns the number of bytes consumed, or 0 if the input is truncated,
+    // malformed or not a normalized value, in which case value is left
+    // untouched. Encodings that normalize() could not produce would break
+    // operator==, sort_key() and hashing, so they are rejected
+    static size_t deserialize_from(std::span<const std::byte> in, BigNum &value,
+                                   const SerialFormat format = SerialFormat::Fixed) {
+        if (in.size() < 9) {
+            return 0;
+        }
+        man_t mantissa = std::bit_cast<man_t>(load_le(in.data()));
+        exp_t exponent = 0;
+        size_t size = 8;
+        if (format == SerialFormat::Fixed) {
+            if (in.size() < SERIAL_FIXED_SIZE) {
+                return 0;
+            }
+            exponent = load_le(in.data() + 8);
+            size = SERIAL_FIXED_SIZE;
+        } else {
+            for (unsigned shift = 0;; shift += 7) {
+                if (size == in.size() || shift > 63) {
+                    return 0;
+                }
+                auto byte = std::to_integer<exp_t>(in[size++]);
+                if (shift == 63 && byte > 1) {
+                    return 0; // more than 64 bits
+                }
+                exponent |= (byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0) {
+                    break;
+                }
+            }
+        }
+        const BigNum parsed(mantissa, exponent, false);
+        if (!parsed.is_normalized()) {
+            return 0;
+        }
+        value = parsed;
+        return size;
+    }
+
+    // Bulk variants: values are laid out back to back. Return the total
+    // number of bytes written/consumed, or 0 on failure
+    static size_t serialize_to(std::span<const BigNum> values,
+                               std::span<std::byte> out,
+                               const SerialFormat format = SerialFormat::Fixed) {
+        if (format == SerialFormat::Fixed) {
+            if (out.size() / SERIAL_FIXED_SIZE < values.size()) {
+                return 0;
+            }
+            // On little-endian hosts the fixed layout is the in-memory layout
+            if constexpr (std::endian::native == std::endian::little &&
+                          sizeof(BigNum) == SERIAL_FIXED_SIZE) {
+                if (!values.empty()) {
+                    std::memcpy(out.data(), values.data(), values.size_bytes());
+                }
+                return values.size_bytes();
+            }
+        }
+        size_t offset = 0;
+        for (const BigNum &v : values) {
+            size_t written = v.serialize_to(out.subspan(offset), format);
+            if (written == 0) {
+                return 0;
+            }
+            offset += written;
+        }
+        return offset;
+    }
+
+    static size_t deserialize_from(std::span<const std::byte> in,
+                                   std::span<BigNum> values,
+                                   const SerialFormat format = SerialFormat::Fixed) {
+        if (format == SerialFormat::Fixed) {
+            if (in.size() / SERIAL_FIXED_SIZE < values.size()) {
+                return 0;
+            }
+            if constexpr (std::endian::native == std::endian::little &&
+                          sizeof(BigNum) == SERIAL_FIXED_SIZE) {
+                if (!values.empty()) {
+                    std::memcpy(values.data(), in.data(), values.size_bytes());
+                }
+                if (!std::ranges::all_of(values, &BigNum::is_normalized)) {
+                    return 0;
+                }
+                return values.size_bytes();
+            }
+        }
+        size_t offset = 0;
+        for (BigNum &v : values) {
+            size_t read = deserialize_from(in.subspan(offset), v, format);
+            if (read == 0) {
+                return 0;
+            }
+            offset += read;
+        }
+        return offset;
+    }
+
+    /* Order-preserving key: unsigned comparison of (hi, lo) orders keys like
+     * operator<=> orders the values, and equivalent values (0 and -0) get equal
+     * keys. Positive values store 1, e and the mantissa bits; negative values
+     * the complement of their magnitude's key. -inf is all zeros, +inf sorts
+     * above max(), and every NaN gets the all-ones key, after everything else
+     * The big-endian bytes of a key compare the same way with memcmp
+     */
+    struct SortKey {
+        std::uint64_t hi = 0;
+        std::uint64_t lo = 0;
+
+        MAYBE_CONSTEXPR auto operator<=>(const SortKey &) const = default;
+
+        void to_bytes(std::span<std::byte, 16> out) const {
+            for (int i = 0; i < 8; ++i) {
+                out[i] = static_cast<std::byte>(hi >> (56 - 8 * i));
+                out[8 + i] = static_cast<std::byte>(lo >> (56 - 8 * i));
+            }
+        }
+        static SortKey from_bytes(std::span<const std::byte, 16> in) {
+            SortKey key;
+            for (int i = 0; i < 8; ++i) {
+                key.hi = (key.hi << 8) | std::to_integer<std::uint64_t>(in[i]);
+                key.lo = (key.lo << 8) | std::to_integer<std::uint64_t>(in[8 + i]);
+            }
+            return key;
+        }
+    };
+
+    MAYBE_CONSTEXPR SortKey sort_key() const {
+        static_assert(sizeof(man_t) == 8 && sizeof(exp_t) == 8,
+                      "sort key assumes 64-bit mantissa and exponent");
+        constexpr std::uint64_t TOP = std::uint64_t(1) << 63;
+        if (_isnan(m)) {
+            return {~std::uint64_t(0), ~std::uint64_t(0)};
+        }
+        if (_isinf(m)) {
+            return m > 0 ? SortKey{~std::uint64_t(0), ~std::uint64_t(0) - 1}
+                         : SortKey{0, 0};
+        }
+        // The magnitude's bits are below 0x7FF0..., so 63 bits hold them and
+        // the exponent's lowest bit fits on top
+        const std::uint64_t bits = std::bit_cast<std::uint64_t>(m) & ~TOP;
+        if (bits == 0) {
+            return {TOP, 0};
+        }
+        SortKey key{TOP | (e >> 1), (e << 63) | bits};
+        if (m < 0) {
+            key = {~key.hi, ~key.lo};
+        }
+        return key;
+    }
+
+    // Inverse of sort_key(), except that -0 comes back as 0 and every NaN as
+    // nan()
+    static MAYBE_CONSTEXPR BigNum from_sort_key(SortKey key) {
+        constexpr std::uint64_t TOP = std::uint64_t(1) << 63;
+        if (key.hi == ~std::uint64_t(0) && key.lo >= ~std::uint64_t(0) - 1) {
+            return key.lo == ~std::uint64_t(0) ? nan() : inf();
+        }
+        if (key.hi == 0 && key.lo == 0) {
+            return -inf();
+        }
+        const bool negative = (key.hi & TOP) == 0;
+        if (negative) {
+            key = {~key.hi, ~key.lo};
+        }
+        const exp_t exponent = (key.hi << 1) | (key.lo >> 63);
+        const std::uint64_t bits = (key.lo & ~TOP) | (negative ? TOP : 0);
+        return BigNum(std::bit_cast<man_t>(bits), exponent, false);
+    }
+
+    /* Parses a BigNum from the start of [first, last), like std::from_chars
+     * Accepts everything to_string() and to_pretty_string() produce: an
+     * optional '-', digits optionally grouped by ctx.thousands_separator, an
+     * optional ctx.decimal_separator and fraction, an optional 'e' or 'E'
+     * exponent, and inf/nan. Parsing stops at the first character that does
+     * not continue the number, returned as ptr. On error value is left
+     * untouched and ec is std::errc::invalid_argument (no number) or
+     * std::errc::result_out_of_range (exponent too large)
+     * Never throws or allocates
+     */
+    static std::from_chars_result
+    from_chars(const char *first, const char *last, BigNum &value,
+               const BigNumContext &ctx = DefaultBigNumContext) noexcept {
+        auto is_digit = [](char c) { return c >= '0' && c <= '9'; };
+        const char *it = first;
+        const bool negative = (it != last && *it == '-');
+        if (negative) {
+            ++it;
+        }
+
+        // Special values
+        if (it != last && (*it == 'i' || *it == 'I' || *it == 'n' || *it == 'N')) {
+            man_t special;
+            auto result = std::from_chars(first, last, special);
+            if (result.ec == std::errc()) {
+                value = BigNum(special);
+            }
+            return result;
+        }
+
+        // Integer part, optionally grouped by thousands separators
+        size_t int_digits = 0;
+        bool grouped = false;
+        for (; it != last && is_digit(*it); ++it) {
+            ++int_digits;
+        }
+        while (int_digits > 0 && last - it >= 4 && *it == ctx.thousands_separator &&
+               is_digit(it[1]) && is_digit(it[2]) && is_digit(it[3]) &&
+               (last - it == 4 || !is_digit(it[4]))) {
+            grouped = true;
+            int_digits += 3;
+            it += 4;
+        }
+
+        // Fraction part
+        size_t frac_digits = 0;
+        const char *decimal = nullptr;
+        if (it != last && *it == ctx.decimal_separator &&
+            (int_digits > 0 || (last - it >= 2 && is_digit(it[1])))) {
+            decimal = it;
+            for (++it; it != last && is_digit(*it); ++it) {
+                ++frac_digits;
+            }
+        }
+        if (int_digits == 0 && frac_digits == 0) {
+            return {first, std::errc::invalid_argument};
+        }
+        const char *mantissa_end = it;
+
+        // Exponent part
+        exp_t exponent = 0;
+        if (last - it >= 2 && (*it == 'e' || *it == 'E') && is_digit(it[1])) {
+            auto result = std::from_chars(it + 1, last, exponent);
+            if (result.ec != std::errc()) {
+                return result;
+            }
+            it = result.ptr;
+        }
+
+        // Plain mantissas go straight to std::from_chars. Otherwise they are
+        // copied without separators, integer digits past MAX_INT_DIGITS move
+        // into the exponent, and surplus fraction digits are dropped
+        constexpr size_t MAX_INT_DIGITS = 300;
+        constexpr size_t MAX_CHARS = 400;
+        exp_t shift = 0;
+        man_t mantissa = 0;
+        std::from_chars_result result;
+        if (!grouped && ctx.decimal_separator == '.' && int_digits <= MAX_INT_DIGITS) {
+            result = std::from_chars(first, mantissa_end, mantissa);
+        } else {
+            char buffer[MAX_CHARS + 2];
+            size_t len = 0;
+            size_t kept_int_digits = 0;
+            if (negative) {
+                buffer[len++] = '-';
+            }
+            const char *p = first + (negative ? 1 : 0);
+            for (; p != mantissa_end && p != decimal; ++p) {
+                if (!is_digit(*p) || (kept_int_digits == 0 && *p == '0')) {
+                    continue; // separator or leading zero
+                }
+                if (kept_int_digits < MAX_INT_DIGITS) {
+                    buffer[len++] = *p;
+                    ++kept_int_digits;
+                } else {
+                    ++shift;
+                }
+            }
+            if (kept_int_digits == 0) {
+                buffer[len++] = '0';
+            }
+            if (decimal != nullptr) {
+                buffer[len++] = '.';
+                for (p = decimal + 1; p != mantissa_end && len < MAX_CHARS; ++p) {
+                    buffer[len++] = *p;
+                }
+            }
+            result = std::from_chars(buffer, buffer + len, mantissa);
+        }
+        if (result.ec != std::errc() &&
+            result.ec != std::errc::result_out_of_range) {
+            return {first, std::errc::invalid_argument};
+        }
+        // Underflow below the smallest double rounds to zero
+        if (result.ec == std::errc::result_out_of_range) {
+            mantissa = negative ? -0.0 : 0.0;
+        }
+        // Normalizing carries the integer digits of the mantissa past the
+        // first into the exponent as well
+        const man_t magnitude = std::abs(mantissa);
+        const exp_t carry =
+            magnitude >= 10 ? static_cast<exp_t>(std::floor(std::log10(magnitude))) : 0;
+        if (exponent > std::numeric_limits<exp_t>::max() - shift ||
+            exponent + shift > std::numeric_limits<exp_t>::max() - carry) {
+            return {it, std::errc::result_out_of_range};
+        }
+        value = BigNum(mantissa, exponent + shift);
+        return {it, std::errc()};
+    }
+
+    // Returns number as intmax_t, or nullopt if the number is too large
+    MAYBE_CONSTEXPR std::optional<intmax_t> to_number() const {
+        int total_digits = e + std::log10(std::abs(m)) + 1;
+        if (total_digits > std::numeric_limits<intmax_t>::digits10) {
             // std::cerr << "Number is too large to convert to intmax_t: " <<
             // this->to_string() << std::endl;
             return std::nullopt;
@@ -784,44 +1890,144 @@ class BigNum {
 
     // Returns log10(num), or nullopt if the result would be too large
     MAYBE_CONSTEXPR std::optional<double> log10() const {
-        if (std::numeric_limits<double>::max() - e < std::log10(m)) {
+        return log10_impl<FAST_MATH>();
+    }
+
+    // Returns num^power
+    MAYBE_CONSTEXPR BigNum pow(double power) const { return pow_impl<FAST_MATH>(power); }
+
+    // Integer power overload - just calls the double version
+    MAYBE_CONSTEXPR BigNum pow(intmax_t power) const {
+        return pow(static_cast<double>(power));
+    }
+
+    // Returns num^(1/n), aka the nth root
+    MAYBE_CONSTEXPR BigNum root(intmax_t n) const { return root_impl<FAST_MATH>(n); }
+
+    // log10(), pow() and root() with the FastMath kernels, whether or not
+    // BIGNUM_FAST_MATH is defined
+    std::optional<double> fast_log10() const { return log10_impl<true>(); }
+    BigNum fast_pow(double power) const { return pow_impl<true>(power); }
+    BigNum fast_root(intmax_t n) const { return root_impl<true>(n); }
+
+#ifdef __cpp_lib_expected
+    // pow(), root() and the string constructor, returning why there is no
+    // result instead of throwing or giving NaN
+    std::expected<BigNum, BigNumError> try_pow(double power) const noexcept {
+        if (const auto error = pow_error(power)) {
+            return std::unexpected(*error);
+        }
+        return pow(power);
+    }
+    std::expected<BigNum, BigNumError> try_root(intmax_t n) const noexcept {
+        if (const auto error = root_error(n)) {
+            return std::unexpected(*error);
+        }
+        return root(n);
+    }
+    static std::expected<BigNum, BigNumError>
+    try_parse(const std::string_view sv,
+              const BigNumContext &ctx = DefaultBigNumContext) noexcept {
+        BigNum bn;
+        const char *last = sv.data() + sv.size();
+        auto [ptr, ec] = from_chars(sv.data(), last, bn, ctx);
+        if (ec == std::errc::result_out_of_range) {
+            return std::unexpected(BigNumError::ExponentOutOfRange);
+        }
+        if (ec != std::errc() || ptr != last) {
+            return std::unexpected(BigNumError::InvalidNumber);
+        }
+        return bn;
+    }
+#endif
+
+    // Returns e^num. BIGNUM_FAST_MATH computes 10^(num log10(e)) with the
+    // FastMath kernel
+    static MAYBE_CONSTEXPR BigNum exp(exp_t n) {
+        if constexpr (FAST_MATH) {
+            return exp10(static_cast<double>(n) * std::numbers::log10e);
+        }
+        return BigNum(std::exp(1)).pow(static_cast<intmax_t>(n));
+    }
+
+    // Returns the square root of num
+    MAYBE_CONSTEXPR BigNum sqrt() const { return root(2); }
+
+  private:
+    // log10 and 10^x of doubles in the functions above
+    template <bool Fast> static MAYBE_CONSTEXPR double math_log10(const double x) {
+        if constexpr (Fast) {
+            return FastMath::log10(x);
+        }
+        return std::log10(x);
+    }
+    template <bool Fast> static MAYBE_CONSTEXPR double math_exp10(const double x) {
+        if constexpr (Fast) {
+            return FastMath::exp10(x);
+        }
+        return std::pow(10.0, x);
+    }
+
+    template <bool Fast> MAYBE_CONSTEXPR std::optional<double> log10_impl() const {
+        const double lm = math_log10<Fast>(m);
+        if (std::numeric_limits<double>::max() - e < lm) {
             return std::nullopt;
         }
-        return e + std::log10(m);
+        return e + lm;
     }
 
-    // Returns num^power
-    MAYBE_CONSTEXPR BigNum pow(double power) const {
+    // Why pow(power) and root(n) have no real result, if they have none
+    MAYBE_CONSTEXPR std::optional<BigNumError> pow_error(double power) const {
+        if (power == 0.0) {
+            return std::nullopt;
+        }
+        if (m == 0 && power < 0) {
+            return BigNumError::ZeroToNegativePower;
+        }
+        // Negative bases need powers that are effectively integers
+        if (m < 0 && std::abs(power - std::round(power)) >= 1e-10) {
+            return BigNumError::ComplexPower;
+        }
+        return std::nullopt;
+    }
+    MAYBE_CONSTEXPR std::optional<BigNumError> root_error(intmax_t n) const {
+        if (n == 0) {
+            return BigNumError::ZerothRoot;
+        }
+        if (m < 0 && n % 2 == 0) {
+            return BigNumError::EvenRootOfNegative;
+        }
+        return std::nullopt;
+    }
+
+    template <bool Fast> MAYBE_CONSTEXPR BigNum pow_impl(double power) const {
         // Special cases
         if (power == 0.0) {
             return BigNum(static_cast<man_t>(1));
         }
-        if (m == 0) {
-            if (power < 0) {
-                throw std::domain_error("Cannot raise 0 to a negative power");
+        if (const auto error = pow_error(power)) {
+            // The messages are string literals, so data() is null-terminated
+            if constexpr (USE_EXCEPTIONS) {
+                BIGNUM_FATAL(std::domain_error(error_message(*error).data()));
+            } else {
+                return nan();
             }
+        }
+        if (m == 0) {
             return BigNum(static_cast<man_t>(0));
         }
 
         // When the mantissa is negative
         if (m < 0) {
-            // Check if power is effectively an integer
-            bool is_integer_power = std::abs(power - std::round(power)) < 1e-10;
-
-            if (!is_integer_power) {
-                throw std::domain_error("Non-integer powers of negative "
-                                        "numbers result in complex values");
-            }
-
             // Handle integer powers of negative numbers
             if (std::fmod(std::round(power), 2.0) == 0.0) {
-                return BigNum(-m, e).pow(power); // Even power
+                return BigNum(-m, e).pow_impl<Fast>(power); // Even power
             }
-            return BigNum(-m, e).pow(power).negate(); // Odd power
+            return BigNum(-m, e).pow_impl<Fast>(power).negate(); // Odd power
         }
 
         // Calculate using logarithms
-        auto log = log10();
+        auto log = log10_impl<Fast>();
         if (!log) {
             // std::cerr << "Logarithm out of bounds" << std::endl;
             return BigNum(static_cast<man_t>(0));
@@ -837,36 +2043,29 @@ class BigNum {
         }
 
         // Split into mantissa and exponent
-        man_t m2 = static_cast<man_t>(std::pow(10, std::fmod(new_log, 1.0)));
+        man_t m2 = static_cast<man_t>(math_exp10<Fast>(std::fmod(new_log, 1.0)));
         exp_t e2 = static_cast<exp_t>(std::floor(new_log));
 
         return BigNum(m2, e2);
     }
 
-    // Integer power overload - just calls the double version
-    MAYBE_CONSTEXPR BigNum pow(intmax_t power) const {
-        return pow(static_cast<double>(power));
-    }
-
-    // Returns num^(1/n), aka the nth root
-    MAYBE_CONSTEXPR BigNum root(intmax_t n) const {
-        if (n == 0) {
-            throw std::domain_error("Cannot take the zeroth root");
-        } // Handle zero early
+    template <bool Fast> MAYBE_CONSTEXPR BigNum root_impl(intmax_t n) const {
+        // Only odd roots are allowed for negative bases
+        if (const auto error = root_error(n)) {
+            if constexpr (USE_EXCEPTIONS) {
+                BIGNUM_FATAL(std::domain_error(error_message(*error).data()));
+            } else {
+                return nan();
+            }
+        }
+        // Handle zero early
         if (m == 0) {
             return BigNum(static_cast<man_t>(0));
         }
-        // Handle negative numbers: Only allow odd roots for negative bases
         bool is_negative = (m < 0);
-        if (is_negative) {
-            if (n % 2 == 0) {
-                throw std::domain_error(
-                    "Even root of a negative number is not defined");
-            }
-        }
 
         // Compute log10(|num|) = log10(|m|) + e
-        double abs_log = std::log10(std::abs(m)) + e;
+        double abs_log = math_log10<Fast>(std::abs(m)) + e;
         // The new logarithm for the x-th root
         double new_log = abs_log / static_cast<double>(n);
 
@@ -875,7 +2074,7 @@ class BigNum {
         exp_t new_e = static_cast<exp_t>(std::floor(new_log));
         double fractional = new_log - std::floor(new_log);
         // Compute the new mantissa from the fractional part
-        man_t new_m = std::pow(10.0, fractional);
+        man_t new_m = math_exp10<Fast>(fractional);
 
         // For negative bases with an odd root, the result should be negative
         if (is_negative) {
@@ -885,24 +2084,247 @@ class BigNum {
         return BigNum(new_m, new_e);
     }
 
-    // Returns e^num
-    static MAYBE_CONSTEXPR BigNum exp(exp_t n) {
-        return BigNum(std::exp(1)).pow(static_cast<intmax_t>(n));
+  public:
+
+    /* Bulk-buy helpers, closed forms of break_infinity.js' sumGeometricSeries,
+     * affordGeometricSeries, sumArithmeticSeries and affordArithmeticSeries
+     * Prices of a geometric ramp are price_start * price_ratio^k, those of an
+     * arithmetic ramp price_start + k * price_add, where k counts from
+     * current_owned. The ratio is a double since BigNum rounds values below
+     * 1e17 to integers. Geometric sums are computed in the log domain and are
+     * accurate to about 1e-15 relative
+     */
+    static BigNum sum_geometric_series(const BigNum &num_items,
+                                       const BigNum &price_start,
+                                       const double price_ratio,
+                                       const BigNum &current_owned = BigNum()) {
+        if (!check_ratio(price_ratio)) {
+            return nan();
+        }
+        const double n = to_double(num_items);
+        if (n <= 0) {
+            return BigNum();
+        }
+        const double log_start = *price_start.log10() +
+                                 to_double(current_owned) * std::log10(price_ratio);
+        return exp10(log_start + log10_geometric_factor(n, price_ratio));
     }
 
-    // Returns the square root of num
-    MAYBE_CONSTEXPR BigNum sqrt() const { return root(2); }
+    // Largest n such that the next n items cost at most budget
+    static BigNum afford_geometric_series(const BigNum &budget,
+                                          const BigNum &price_start,
+                                          const double price_ratio,
+                                          const BigNum &current_owned = BigNum()) {
+        if (!check_ratio(price_ratio)) {
+            return nan();
+        }
+        if (budget.m <= 0) {
+            return BigNum();
+        }
+        const double log_ratio = std::log10(price_ratio);
+        // log10 of budget / price of the next item
+        const double q = *budget.log10() - *price_start.log10() -
+                         to_double(current_owned) * log_ratio;
+        double n;
+        if (price_ratio == 1) {
+            n = q > 308 ? std::numeric_limits<double>::infinity() : std::pow(10.0, q);
+        } else if (price_ratio > 1) {
+            // Solve (r^n - 1) / (r - 1) = budget / start
+            const double x = q + std::log10(price_ratio - 1);
+            const double log_total = x > 17 ? x : std::log1p(std::pow(10.0, x)) / std::numbers::ln10;
+            n = log_total / log_ratio;
+        } else {
+            // Decreasing prices: everything is affordable past start / (1 - r)
+            const double y = 1 - std::pow(10.0, q) * (1 - price_ratio);
+            n = y <= 0 ? std::numeric_limits<double>::infinity() : std::log10(y) / log_ratio;
+        }
+        return floor_count(n, [&](const BigNum &count) {
+            return sum_geometric_series(count, price_start, price_ratio,
+                                        current_owned) <= budget;
+        });
+    }
+
+    static BigNum sum_arithmetic_series(const BigNum &num_items,
+                                        const BigNum &price_start,
+                                        const BigNum &price_add,
+                                        const BigNum &current_owned = BigNum()) {
+        if (num_items.m <= 0) {
+            return BigNum();
+        }
+        // n * (2 * start + (n - 1) * add) / 2, halved last to stay on the
+        // integer grid
+        const BigNum start = price_start + current_owned * price_add;
+        return num_items * (start * 2.0 + (num_items - 1.0) * price_add) / 2.0;
+    }
+
+    static BigNum afford_arithmetic_series(const BigNum &budget,
+                                           const BigNum &price_start,
+                                           const BigNum &price_add,
+                                           const BigNum &current_owned = BigNum()) {
+        if (price_add.m < 0) {
+            if constexpr (USE_EXCEPTIONS) {
+                BIGNUM_FATAL(std::domain_error("Price increase must not be negative"));
+            } else {
+                return nan();
+            }
+        }
+        const BigNum start = price_start + current_owned * price_add;
+        if (budget.m <= 0) {
+            return BigNum();
+        }
+        if (price_add.m == 0) {
+            if (start.m <= 0) {
+                return inf();
+            }
+            return floor_count(to_double(budget / start), [&](const BigNum &count) {
+                return count * start <= budget;
+            });
+        }
+
+        /* Positive root of n^2 / 2 + (s - 1/2) n - b = 0, where s = start / add
+         * and b = budget / add. Both are scaled down by 10^h to stay within
+         * double range, and the form without cancellation is used for s > 1/2.
+         * Free or negative starting prices are paid back by later items
+         */
+        const double log_add = *price_add.log10();
+        const double lb = *budget.log10() - log_add;
+        double h = lb / 2;
+        double s = 0;
+        if (start.m != 0) {
+            const double ls = *start.abs().log10() - log_add;
+            h = std::max(ls, h);
+            s = std::copysign(std::pow(10.0, ls - h), start.m);
+        }
+        s -= 0.5 * std::pow(10.0, -h);
+        const double b = std::pow(10.0, lb - 2 * h);
+        const double root = std::sqrt(s * s + 2 * b);
+        const double n = s > 0 ? 2 * b / (s + root) : root - s;
+        const double log_n = std::log10(n) + h;
+        if (log_n > 15) {
+            return exp10(log_n); // already beyond integer precision
+        }
+        return floor_count(std::pow(10.0, log_n), [&](const BigNum &count) {
+            return sum_arithmetic_series(count, price_start, price_add,
+                                         current_owned) <= budget;
+        });
+    }
+
+    // Batch variants, one result per upgrade; defined after the class
+    struct GeometricUpgrade;
+    struct ArithmeticUpgrade;
+    static void sum_geometric_series(const BigNum &num_items,
+                                     std::span<const GeometricUpgrade> upgrades,
+                                     std::span<BigNum> out);
+    static void afford_geometric_series(const BigNum &budget,
+                                        std::span<const GeometricUpgrade> upgrades,
+                                        std::span<BigNum> out);
+    static void sum_arithmetic_series(const BigNum &num_items,
+                                      std::span<const ArithmeticUpgrade> upgrades,
+                                      std::span<BigNum> out);
+    static void afford_arithmetic_series(const BigNum &budget,
+                                         std::span<const ArithmeticUpgrade> upgrades,
+                                         std::span<BigNum> out);
 };
 
+struct BigNum::GeometricUpgrade {
+    BigNum price_start;
+    double price_ratio;
+    BigNum current_owned;
+};
+struct BigNum::ArithmeticUpgrade {
+    BigNum price_start;
+    BigNum price_add;
+    BigNum current_owned;
+};
+
+inline void BigNum::sum_geometric_series(const BigNum &num_items,
+                                         std::span<const GeometricUpgrade> upgrades,
+                                         std::span<BigNum> out) {
+    assert(out.size() >= upgrades.size());
+    for (size_t i = 0; i < upgrades.size(); ++i) {
+        const GeometricUpgrade &u = upgrades[i];
+        out[i] = sum_geometric_series(num_items, u.price_start, u.price_ratio,
+                                      u.current_owned);
+    }
+}
+inline void BigNum::afford_geometric_series(const BigNum &budget,
+                                            std::span<const GeometricUpgrade> upgrades,
+                                            std::span<BigNum> out) {
+    assert(out.size() >= upgrades.size());
+    for (size_t i = 0; i < upgrades.size(); ++i) {
+        const GeometricUpgrade &u = upgrades[i];
+        out[i] = afford_geometric_series(budget, u.price_start, u.price_ratio,
+                                         u.current_owned);
+    }
+}
+inline void BigNum::sum_arithmetic_series(const BigNum &num_items,
+                                          std::span<const ArithmeticUpgrade> upgrades,
+                                          std::span<BigNum> out) {
+    assert(out.size() >= upgrades.size());
+    for (size_t i = 0; i < upgrades.size(); ++i) {
+        const ArithmeticUpgrade &u = upgrades[i];
+        out[i] = sum_arithmetic_series(num_items, u.price_start, u.price_add,
+                                       u.current_owned);
+    }
+}
+inline void BigNum::afford_arithmetic_series(const BigNum &budget,
+                                             std::span<const ArithmeticUpgrade> upgrades,
+                                             std::span<BigNum> out) {
+    assert(out.size() >= upgrades.size());
+    for (size_t i = 0; i < upgrades.size(); ++i) {
+        const ArithmeticUpgrade &u = upgrades[i];
+        out[i] = afford_arithmetic_series(budget, u.price_start, u.price_add,
+                                          u.current_owned);
+    }
+}
+
 inline std::ostream &operator<<(std::ostream &os, const BigNum &bn) {
     os << bn.to_string();
     return os;
 }
 
+// Reads one whitespace-delimited token and parses it with BigNum::from_chars
+// Malformed input sets failbit and leaves bn untouched
 inline std::istream &operator>>(std::istream &is, BigNum &bn) {
-    std::string input;
-    is >> input;
-    bn.parseStr(input);
+    std::istream::sentry sentry(is);
+    if (!sentry) {
+        return is;
+    }
+
+    // Tokens longer than the stack buffer spill into a string
+    std::array<char, 128> buffer;
+    std::string long_token;
+    size_t len = 0;
+    std::streambuf *sb = is.rdbuf();
+    int c = sb->sgetc();
+    for (; c != std::char_traits<char>::eof() &&
+           !std::isspace(static_cast<unsigned char>(c));
+         c = sb->snextc()) {
+        if (len == buffer.size()) {
+            long_token.append(buffer.data(), len);
+            len = 0;
+        }
+        buffer[len++] = static_cast<char>(c);
+    }
+    if (c == std::char_traits<char>::eof()) {
+        is.setstate(std::ios_base::eofbit);
+    }
+
+    std::string_view token(buffer.data(), len);
+    if (!long_token.empty()) {
+        long_token.append(buffer.data(), len);
+        token = long_token;
+    }
+    // Parsed into a copy, since from_chars() stores a valid prefix such as
+    // the 12 of "12abc"
+    const char *last = token.data() + token.size();
+    BigNum parsed;
+    auto [ptr, ec] = BigNum::from_chars(token.data(), last, parsed);
+    if (ec != std::errc() || ptr != last) {
+        is.setstate(std::ios_base::failbit);
+    } else {
+        bn = parsed;
+    }
     return is;
 }
 
@@ -915,7 +2337,2016 @@ static_assert(std::default_initializable<BigNum>);
 static_assert(std::semiregular<BigNum>);
 static_assert(std::regular<BigNum>);
 
-} // namespace BigNumber
+// BigNum whose mantissa may drift outside [1, 10) across a chain of
+// operations. Normalization is deferred until the value is converted back to
+// a BigNum, compared, printed, or the mantissa leaves the drift window
+// Example: BigNum r = UnnormalizedBigNum(base) * mult1 * mult2 + bonus;
+class UnnormalizedBigNum {
+  public:
+    using man_t = BigNum::man_t;
+    using exp_t = BigNum::exp_t;
 
-// Expose BigNum to the global namespace
-using BigNumber::BigNum;
+  private:
+    man_t m = 0; // mantissa, |m| kept within [1 / MAX_DRIFT, MAX_DRIFT]
+    exp_t e = 0; // exponent (base 10)
+
+    // Products of up to ~100 normalized mantissas fit before folding, and
+    // aligning two drifted mantissas cannot overflow a double
+    static inline constexpr man_t MAX_DRIFT = 1e100;
+    static inline constexpr exp_t MAX_ALIGN_DIFF = 100;
+
+    // Moves excess digits of a tiny mantissa back out of the exponent
+    static MAYBE_CONSTEXPR void unfold(man_t &mantissa, exp_t &exponent) {
+        man_t a = std::abs(mantissa);
+        if (a == 0 || a >= 1 || exponent == 0 || !std::isfinite(a)) {
+            return;
+        }
+        int shift = std::min(static_cast<int>(-std::floor(std::log10(a))),
+                             Pow10TableOffset);
+        exp_t k = std::min(exponent, static_cast<exp_t>(shift));
+        mantissa *= *Pow10::get(static_cast<int>(k));
+        exponent -= k;
+    }
+
+    // Moves excess digits of a large mantissa into the exponent with one
+    // division, leaving BigNum::normalize() at most one digit to shift
+    // instead of a loop over every digit. Short mantissas are left to the loop
+    static MAYBE_CONSTEXPR void fold(man_t &mantissa, exp_t &exponent) {
+        man_t a = std::abs(mantissa);
+        if (!(a >= 1e4) || !std::isfinite(a)) {
+            return;
+        }
+        // floor(log10(2^k)) is at most one below floor(log10(a)), and k is
+        // read from the exponent bits of a
+        int k = static_cast<int>(std::bit_cast<std::uint64_t>(a) >> 52) - 1023;
+        int shift = static_cast<int>(k * std::numbers::log10e / std::numbers::log2e);
+        if (exponent > std::numeric_limits<exp_t>::max() - static_cast<exp_t>(shift)) {
+            return; // BigNum::normalize() saturates
+        }
+        mantissa /= *Pow10::get(shift);
+        exponent += static_cast<exp_t>(shift);
+    }
+
+    // Folds the mantissa back into the exponent once it leaves the window
+    MAYBE_CONSTEXPR void rebalance() {
+        man_t a = std::abs(m);
+        if (a > MAX_DRIFT) {
+            fold(m, e);
+            BigNum n(m, e);
+            m = n.m;
+            e = n.e;
+        } else if (a < 1 / MAX_DRIFT) {
+            unfold(m, e);
+        }
+    }
+
+  public:
+    MAYBE_CONSTEXPR UnnormalizedBigNum() = default;
+    MAYBE_CONSTEXPR UnnormalizedBigNum(const BigNum &b) : m(b.m), e(b.e) {}
+    // A scalar past the drift window is split into mantissa and exponent, so
+    // that a chain of large factors cannot overflow the double mantissa
+    MAYBE_CONSTEXPR UnnormalizedBigNum(const man_t mantissa) : m(mantissa) {
+        rebalance();
+    }
+
+    // Normalizes into a regular BigNum
+    MAYBE_CONSTEXPR BigNum normalized() const {
+        // A mantissa that never left [1, 10) is already normalized
+        man_t a = std::abs(m);
+        if (a >= 1 && a < 10 &&
+            e >= std::numeric_limits<man_t>::max_digits10 &&
+            e < std::numeric_limits<exp_t>::max()) {
+            return BigNum(m, e, false);
+        }
+        man_t mantissa = m;
+        exp_t exponent = e;
+        unfold(mantissa, exponent);
+        fold(mantissa, exponent);
+        return BigNum(mantissa, exponent);
+    }
+    MAYBE_CONSTEXPR operator BigNum() const { return normalized(); }
+
+    // Raw (possibly unnormalized) mantissa and exponent
+    man_t getM() const { return m; }
+    exp_t getE() const { return e; }
+
+    // Arithmetic operations
+    MAYBE_CONSTEXPR UnnormalizedBigNum add(const UnnormalizedBigNum &b) const {
+        if (!std::isfinite(m) || !std::isfinite(b.m)) {
+            return normalized().add(b.normalized());
+        }
+        if (b.m == 0) {
+            return *this;
+        }
+        if (m == 0) {
+            return b;
+        }
+
+        // Align onto the smaller exponent while the shifted mantissa still
+        // fits, otherwise scale the smaller operand down onto the larger
+        // exponent. Past the table, even a drifted smaller operand is below
+        // 1e-100 of the larger one and is dropped
+        bool this_is_bigger = e > b.e;
+        exp_t delta = this_is_bigger ? e - b.e : b.e - e;
+        UnnormalizedBigNum r;
+        if (delta > static_cast<exp_t>(Pow10TableOffset)) {
+            return this_is_bigger ? *this : b;
+        }
+        if (delta > MAX_ALIGN_DIFF) {
+            const man_t scale = *Pow10::get(-static_cast<int>(delta));
+            r.m = this_is_bigger ? m + b.m * scale : m * scale + b.m;
+            r.e = this_is_bigger ? e : b.e;
+        } else if (this_is_bigger) {
+            r.m = m * (*Pow10::get(static_cast<int>(delta))) + b.m;
+            r.e = b.e;
+        } else {
+            r.m = m + b.m * (*Pow10::get(static_cast<int>(delta)));
+            r.e = e;
+        }
+        r.rebalance();
+        return r;
+    }
+
+    MAYBE_CONSTEXPR UnnormalizedBigNum sub(const UnnormalizedBigNum &b) const {
+        return add(b.negate());
+    }
+
+    MAYBE_CONSTEXPR UnnormalizedBigNum mul(const UnnormalizedBigNum &b) const {
+        // Exponent sums past exp_t are left to BigNum::mul
+        if (b.e > std::numeric_limits<exp_t>::max() - e) {
+            return normalized().mul(b.normalized());
+        }
+        // Both mantissas are within the drift window, so the product stays
+        // within 1e200 until rebalance() folds it
+        UnnormalizedBigNum r;
+        r.m = m * b.m;
+        r.e = e + b.e;
+        r.rebalance();
+        return r;
+    }
+
+    MAYBE_CONSTEXPR UnnormalizedBigNum div(const UnnormalizedBigNum &b) const {
+        // Division by zero, and results that would need a negative exponent,
+        // follow BigNum::div
+        if (b.m == 0 || b.e > e) {
+            return normalized().div(b.normalized());
+        }
+        UnnormalizedBigNum r;
+        r.m = m / b.m;
+        r.e = e - b.e;
+        r.rebalance();
+        return r;
+    }
+
+    MAYBE_CONSTEXPR UnnormalizedBigNum negate() const {
+        UnnormalizedBigNum r = *this;
+        r.m = -r.m;
+        return r;
+    }
+
+    // Operator overloads
+    MAYBE_CONSTEXPR UnnormalizedBigNum
+    operator+(const UnnormalizedBigNum &other) const {
+        return add(other);
+    }
+    MAYBE_CONSTEXPR UnnormalizedBigNum operator+(const BigNum &other) const {
+        return add(other);
+    }
+    MAYBE_CONSTEXPR UnnormalizedBigNum operator+(const man_t other) const {
+        return add(other);
+    }
+    MAYBE_CONSTEXPR UnnormalizedBigNum
+    operator-(const UnnormalizedBigNum &other) const {
+        return sub(other);
+    }
+    MAYBE_CONSTEXPR UnnormalizedBigNum operator-(const BigNum &other) const {
+        return sub(other);
+    }
+    MAYBE_CONSTEXPR UnnormalizedBigNum operator-(const man_t other) const {
+        return sub(other);
+    }
+    MAYBE_CONSTEXPR UnnormalizedBigNum
+    operator*(const UnnormalizedBigNum &other) const {
+        return mul(other);
+    }
+    MAYBE_CONSTEXPR UnnormalizedBigNum operator*(const BigNum &other) const {
+        return mul(other);
+    }
+    MAYBE_CONSTEXPR UnnormalizedBigNum operator*(const man_t other) const {
+        return mul(other);
+    }
+    MAYBE_CONSTEXPR UnnormalizedBigNum
+    operator/(const UnnormalizedBigNum &other) const {
+        return div(other);
+    }
+    MAYBE_CONSTEXPR UnnormalizedBigNum operator/(const BigNum &other) const {
+        return div(other);
+    }
+    MAYBE_CONSTEXPR UnnormalizedBigNum operator/(const man_t other) const {
+        return div(other);
+    }
+    MAYBE_CONSTEXPR UnnormalizedBigNum operator-() const { return negate(); }
+    MAYBE_CONSTEXPR UnnormalizedBigNum &
+    operator+=(const UnnormalizedBigNum &b) {
+        return *this = add(b);
+    }
+    MAYBE_CONSTEXPR UnnormalizedBigNum &
+    operator-=(const UnnormalizedBigNum &b) {
+        return *this = sub(b);
+    }
+    MAYBE_CONSTEXPR UnnormalizedBigNum &
+    operator*=(const UnnormalizedBigNum &b) {
+        return *this = mul(b);
+    }
+    MAYBE_CONSTEXPR UnnormalizedBigNum &
+    operator/=(const UnnormalizedBigNum &b) {
+        return *this = div(b);
+    }
+
+    // Comparison operations (normalize both sides)
+    MAYBE_CONSTEXPR std::partial_ordering
+    operator<=>(const UnnormalizedBigNum &b) const {
+        return normalized() <=> b.normalized();
+    }
+    MAYBE_CONSTEXPR std::partial_ordering operator<=>(const BigNum &b) const {
+        return normalized() <=> b;
+    }
+    MAYBE_CONSTEXPR bool operator==(const UnnormalizedBigNum &b) const {
+        return normalized() == b.normalized();
+    }
+    MAYBE_CONSTEXPR bool operator==(const BigNum &b) const {
+        return normalized() == b;
+    }
+
+    // Conversion methods
+    std::string to_string(const BigNumContext &ctx) const {
+        return normalized().to_string(ctx);
+    }
+    std::string to_string(const unsigned int &precision =
+                              DefaultBigNumContext.print_precision) const {
+        return normalized().to_string(precision);
+    }
+};
+
+inline std::ostream &operator<<(std::ostream &os, const UnnormalizedBigNum &bn) {
+    os << bn.normalized();
+    return os;
+}
+
+namespace detail {
+// The BigNum for a sum kept as special, the sum of its inf/NaN terms, and the
+// finite part m * 10^e. Saturates at max()/min() where normalizing would carry
+// the exponent past its maximum, or where m overflowed a double
+inline BigNum finish_sum(double special, double m, std::uintmax_t e) {
+    if (special != 0 || std::isnan(special)) {
+        return std::isnan(special) ? BigNum::nan()
+               : special > 0       ? BigNum::inf()
+                                   : -BigNum::inf();
+    }
+    if (m == 0) {
+        return BigNum();
+    }
+    const double carry = std::floor(std::log10(std::abs(m)));
+    if (!std::isfinite(m) ||
+        (carry > 0 &&
+         e > std::numeric_limits<std::uintmax_t>::max() - static_cast<std::uintmax_t>(carry))) {
+        return m > 0 ? BigNum::max() : BigNum::min();
+    }
+    return BigNum(m, e);
+}
+} // namespace detail
+
+// Sum of many BigNums without a normalize per addition. Addends are bucketed
+// by exponent, each bucket is a plain double sum (optionally compensated), and
+// the buckets are only folded into a BigNum when the value is read. Unlike
+// repeated +=, addends far below the running total are not dropped:
+// ten million additions of 1e10 to 1e30 give 1.0000000000001e30
+// Example: BigNumAccumulator income; for (...) income += source; balance += income;
+class BigNumAccumulator {
+  public:
+    using man_t = decltype(BigNum().getM());
+    using exp_t = decltype(BigNum().getE());
+
+  private:
+    // A bucket holds sum * 10^base for addends with exponents in
+    // [base, base + WIDTH), so scaled addends stay below 1e17
+    static inline constexpr exp_t WIDTH = 16;
+    static inline constexpr std::size_t BUCKETS = 8;
+
+    struct Bucket {
+        exp_t base = 0;
+        man_t sum = 0;
+        man_t c = 0; // running compensation, only used when compensated
+    };
+    std::array<Bucket, BUCKETS> buckets{};
+    std::size_t used = 0;
+    std::size_t last = 0; // bucket hit by the previous addition
+    man_t special = 0;    // sum of inf/NaN addends
+    bool compensated = false;
+
+    static void add_to(Bucket &b, man_t x, bool compensated) {
+        if (compensated) {
+            // Neumaier's variant of Kahan summation, also exact for |x| > |sum|
+            man_t t = b.sum + x;
+            b.c += std::abs(b.sum) >= std::abs(x) ? (b.sum - t) + x
+                                                   : (x - t) + b.sum;
+            b.sum = t;
+        } else {
+            b.sum += x;
+        }
+    }
+
+    // 10^-(hi - lo), or 0 when the lower value is beyond double range
+    static man_t scale_down(exp_t hi, exp_t lo) {
+        return hi - lo > static_cast<exp_t>(Pow10TableOffset)
+                   ? 0.0
+                   : *Pow10::get(-static_cast<int>(hi - lo));
+    }
+
+    // Folds the lowest bucket into the next one up, where only digits far
+    // below the total can be lost
+    void merge_lowest() {
+        std::size_t lo = 0;
+        for (std::size_t i = 1; i < used; ++i) {
+            if (buckets[i].base < buckets[lo].base) {
+                lo = i;
+            }
+        }
+        std::size_t next = lo == 0 ? 1 : 0;
+        for (std::size_t i = 0; i < used; ++i) {
+            if (i != lo && buckets[i].base < buckets[next].base) {
+                next = i;
+            }
+        }
+        const man_t scale = scale_down(buckets[next].base, buckets[lo].base);
+        add_to(buckets[next], buckets[lo].sum * scale, compensated);
+        add_to(buckets[next], buckets[lo].c * scale, compensated);
+        buckets[lo] = buckets[--used];
+        last = 0;
+    }
+
+    Bucket &bucket(exp_t base) {
+        if (used > 0 && buckets[last].base == base) {
+            return buckets[last];
+        }
+        for (std::size_t i = 0; i < used; ++i) {
+            if (buckets[i].base == base) {
+                last = i;
+                return buckets[i];
+            }
+        }
+        if (used == BUCKETS) {
+            merge_lowest();
+        }
+        buckets[used] = Bucket{base, 0, 0};
+        last = used++;
+        return buckets[last];
+    }
+
+  public:
+    BigNumAccumulator(bool kahan = false) : compensated(kahan) {}
+    explicit BigNumAccumulator(const BigNum &initial, bool kahan = false)
+        : compensated(kahan) {
+        add(initial);
+    }
+
+    void add(const BigNum &x) {
+        const man_t m = x.getM();
+        const exp_t e = x.getE();
+        if (!std::isfinite(m)) {
+            special += m;
+            return;
+        }
+        if (m == 0) {
+            return;
+        }
+        const exp_t base = e - e % WIDTH;
+        add_to(bucket(base), m * *Pow10::get(static_cast<int>(e - base)),
+               compensated);
+    }
+    BigNumAccumulator &operator+=(const BigNum &x) {
+        add(x);
+        return *this;
+    }
+    BigNumAccumulator &operator-=(const BigNum &x) {
+        add(-x);
+        return *this;
+    }
+
+    // Folds every bucket, scaled to the highest one, into a BigNum
+    BigNum value() const {
+        exp_t top = 0;
+        for (std::size_t i = 0; i < used; ++i) {
+            if (buckets[i].sum != 0) {
+                top = std::max(top, buckets[i].base);
+            }
+        }
+        Bucket total{top, 0, 0};
+        for (std::size_t i = 0; i < used; ++i) {
+            const man_t scale = scale_down(top, buckets[i].base);
+            add_to(total, buckets[i].sum * scale, true);
+            add_to(total, buckets[i].c * scale, true);
+        }
+        return detail::finish_sum(special, total.sum + total.c, top);
+    }
+    operator BigNum() const { return value(); }
+
+    void clear() {
+        used = 0;
+        last = 0;
+        special = 0;
+    }
+    void reset(const BigNum &initial) {
+        clear();
+        add(initial);
+    }
+};
+
+// BigNum packed into a single uint64_t, for bandwidth-bound workloads
+// Layout, from the most significant bit:
+//   sign (1) | exponent + 1 (24) | mantissa (39)
+// The mantissa keeps the top 37 fraction bits of the double in [1, 10), about
+// 11 significant decimal digits. Exponent field 0 holds values below 1 as
+// fixed point with 2^-39 resolution, and the all-ones field holds inf/NaN
+// Ignoring the sign, the packed bits are ordered like the values themselves
+// Arithmetic widens to BigNum and rounds the result back to nearest
+class BigNum64 {
+    using man_t = double;
+    using exp_t = uintmax_t;
+
+  public:
+    static inline constexpr unsigned MANTISSA_BITS = 39;
+    static inline constexpr unsigned EXPONENT_BITS = 24;
+    static inline constexpr exp_t MAX_EXPONENT = (exp_t(1) << EXPONENT_BITS) - 3;
+
+  private:
+    static inline constexpr std::uint64_t SIGN_BIT = std::uint64_t(1) << 63;
+    static inline constexpr std::uint64_t MANTISSA_MASK =
+        (std::uint64_t(1) << MANTISSA_BITS) - 1;
+    static inline constexpr std::uint64_t ONE_BITS = std::bit_cast<std::uint64_t>(1.0);
+    static inline constexpr unsigned DROPPED_BITS = 52 + 2 - MANTISSA_BITS;
+    // Mantissa field of 10.0, the first value that belongs to the next exponent
+    static inline constexpr std::uint64_t TEN_MANTISSA =
+        (std::bit_cast<std::uint64_t>(10.0) - ONE_BITS) >> DROPPED_BITS;
+    static inline constexpr std::uint64_t INF_BITS =
+        ((std::uint64_t(1) << EXPONENT_BITS) - 1) << MANTISSA_BITS;
+    static inline constexpr std::uint64_t MAX_BITS =
+        ((MAX_EXPONENT + 1) << MANTISSA_BITS) | (TEN_MANTISSA - 1);
+
+    std::uint64_t bits = 0;
+
+    static MAYBE_CONSTEXPR std::uint64_t pack(const BigNum &v) {
+        const std::uint64_t sign = std::signbit(v.m) ? SIGN_BIT : 0;
+        man_t am = std::abs(v.m);
+        exp_t e = v.e;
+        if (std::isnan(am)) {
+            return sign | INF_BITS | (std::uint64_t(1) << (MANTISSA_BITS - 1));
+        }
+        if (std::isinf(am)) {
+            return sign | INF_BITS;
+        }
+        if (am < 1 && am != 0 && e > 0) {
+            // BigNum leaves |m| < 1 unnormalized when e > 0
+            auto shift = static_cast<exp_t>(-std::floor(std::log10(am)));
+            shift = std::min({shift, e, exp_t(308)});
+            am *= *Pow10::get(static_cast<int>(shift));
+            e -= shift;
+            if (am < 1 && e > 0) {
+                am *= 10;
+                --e;
+            }
+        }
+        if (e == 0 && am < 1) {
+            // Rounding up to 1.0 carries into exponent field 1, which is 1e0
+            return sign | static_cast<std::uint64_t>(
+                              std::nearbyint(std::ldexp(am, MANTISSA_BITS)));
+        }
+        if (am >= 10) { // normalize() can round a mantissa up to 10
+            am /= 10;
+            ++e;
+        }
+        if (e > MAX_EXPONENT) {
+            return sign | MAX_BITS;
+        }
+
+        // Round the 54 bits of (binary exponent, fraction) to nearest even
+        const std::uint64_t wide = std::bit_cast<std::uint64_t>(am) - ONE_BITS;
+        const std::uint64_t rest = wide & ((std::uint64_t(1) << DROPPED_BITS) - 1);
+        const std::uint64_t half = std::uint64_t(1) << (DROPPED_BITS - 1);
+        std::uint64_t mantissa = wide >> DROPPED_BITS;
+        if (rest > half || (rest == half && (mantissa & 1))) {
+            ++mantissa;
+        }
+        std::uint64_t packed = ((e + 1) << MANTISSA_BITS) + mantissa;
+        if (mantissa >= TEN_MANTISSA) {
+            packed = (e + 2) << MANTISSA_BITS;
+        }
+        return sign | std::min(packed, MAX_BITS);
+    }
+
+    // Operands of arithmetic skip the integer grid rounding, since the result
+    // is normalized anyway
+    MAYBE_CONSTEXPR BigNum unpack(const bool on_grid = true) const {
+        const std::uint64_t magnitude = bits & ~SIGN_BIT;
+        const man_t sign = (bits & SIGN_BIT) ? -1.0 : 1.0;
+        if (magnitude >= INF_BITS) {
+            return BigNum(magnitude == INF_BITS
+                              ? std::copysign(std::numeric_limits<man_t>::infinity(), sign)
+                              : std::copysign(std::numeric_limits<man_t>::quiet_NaN(), sign),
+                          0, false);
+        }
+        const exp_t field = magnitude >> MANTISSA_BITS;
+        const std::uint64_t mantissa = magnitude & MANTISSA_MASK;
+        if (field == 0) {
+            return BigNum(std::copysign(std::ldexp(static_cast<man_t>(mantissa),
+                                                   -static_cast<int>(MANTISSA_BITS)),
+                                        sign),
+                          0, false);
+        }
+        const man_t m =
+            std::bit_cast<man_t>(ONE_BITS + (mantissa << DROPPED_BITS));
+        // Below 1e17 BigNum keeps values on the integer grid
+        if (on_grid && field - 1 < std::numeric_limits<man_t>::max_digits10) {
+            return BigNum(std::copysign(m, sign), field - 1);
+        }
+        return BigNum(std::copysign(m, sign), field - 1, false);
+    }
+
+  public:
+    MAYBE_CONSTEXPR BigNum64() = default;
+    MAYBE_CONSTEXPR BigNum64(const man_t mantissa, const exp_t exponent = 0)
+        : bits(pack(BigNum(mantissa, exponent))) {}
+    MAYBE_CONSTEXPR BigNum64(const std::string_view &str) : bits(pack(BigNum(str))) {}
+    // Rounds to the nearest BigNum64, clamping to max()/min() when out of range
+    explicit MAYBE_CONSTEXPR BigNum64(const BigNum &value) : bits(pack(value)) {}
+
+    // Converts only if the value survives the round trip unchanged
+    static MAYBE_CONSTEXPR std::optional<BigNum64> from_exact(const BigNum &value) {
+        BigNum64 packed(value);
+        BigNum back = packed;
+        if (back.e == value.e && (back.m == value.m || (value.is_nan() && back.is_nan()))) {
+            return packed;
+        }
+        return std::nullopt;
+    }
+
+    // Exact conversion back to BigNum
+    MAYBE_CONSTEXPR operator BigNum() const { return unpack(); }
+    MAYBE_CONSTEXPR BigNum to_bignum() const { return unpack(); }
+
+    static MAYBE_CONSTEXPR BigNum64 from_bits(const std::uint64_t raw) {
+        BigNum64 v;
+        v.bits = raw;
+        return v;
+    }
+    MAYBE_CONSTEXPR std::uint64_t to_bits() const { return bits; }
+
+    static MAYBE_CONSTEXPR BigNum64 inf() { return from_bits(INF_BITS); }
+    static MAYBE_CONSTEXPR BigNum64 nan() {
+        return from_bits(INF_BITS | (std::uint64_t(1) << (MANTISSA_BITS - 1)));
+    }
+    static MAYBE_CONSTEXPR BigNum64 max() { return from_bits(MAX_BITS); }
+    static MAYBE_CONSTEXPR BigNum64 min() { return from_bits(SIGN_BIT | MAX_BITS); }
+
+    man_t getM() const { return unpack().m; }
+    exp_t getE() const { return unpack().e; }
+
+    // Arithmetic operations
+    MAYBE_CONSTEXPR BigNum64 add(const BigNum64 &b) const {
+        return BigNum64(unpack(false).add(b.unpack(false)));
+    }
+    MAYBE_CONSTEXPR BigNum64 sub(const BigNum64 &b) const {
+        return BigNum64(unpack(false).sub(b.unpack(false)));
+    }
+    MAYBE_CONSTEXPR BigNum64 mul(const BigNum64 &b) const {
+        return BigNum64(unpack(false).mul(b.unpack(false)));
+    }
+    MAYBE_CONSTEXPR BigNum64 div(const BigNum64 &b) const {
+        return BigNum64(unpack(false).div(b.unpack(false)));
+    }
+    MAYBE_CONSTEXPR BigNum64 abs() const { return from_bits(bits & ~SIGN_BIT); }
+    MAYBE_CONSTEXPR BigNum64 negate() const { return from_bits(bits ^ SIGN_BIT); }
+
+    MAYBE_CONSTEXPR BigNum64 operator+(const BigNum64 &other) const { return add(other); }
+    MAYBE_CONSTEXPR BigNum64 operator+(const std::string_view &other) const {
+        return add(BigNum64(other));
+    }
+    MAYBE_CONSTEXPR BigNum64 operator+(const man_t other) const {
+        return add(BigNum64(other));
+    }
+    MAYBE_CONSTEXPR BigNum64 operator-(const BigNum64 &other) const { return sub(other); }
+    MAYBE_CONSTEXPR BigNum64 operator-(const std::string_view &other) const {
+        return sub(BigNum64(other));
+    }
+    MAYBE_CONSTEXPR BigNum64 operator-(const man_t other) const {
+        return sub(BigNum64(other));
+    }
+    MAYBE_CONSTEXPR BigNum64 operator*(const BigNum64 &other) const { return mul(other); }
+    MAYBE_CONSTEXPR BigNum64 operator*(const std::string_view &other) const {
+        return mul(BigNum64(other));
+    }
+    MAYBE_CONSTEXPR BigNum64 operator*(const man_t other) const {
+        return mul(BigNum64(other));
+    }
+    MAYBE_CONSTEXPR BigNum64 operator/(const BigNum64 &other) const { return div(other); }
+    MAYBE_CONSTEXPR BigNum64 operator/(const std::string_view &other) const {
+        return div(BigNum64(other));
+    }
+    MAYBE_CONSTEXPR BigNum64 operator/(const man_t other) const {
+        return div(BigNum64(other));
+    }
+    // Mixed with a full BigNum, the result widens to BigNum
+    MAYBE_CONSTEXPR BigNum operator+(const BigNum &other) const { return unpack() + other; }
+    MAYBE_CONSTEXPR BigNum operator-(const BigNum &other) const { return unpack() - other; }
+    MAYBE_CONSTEXPR BigNum operator*(const BigNum &other) const { return unpack() * other; }
+    MAYBE_CONSTEXPR BigNum operator/(const BigNum &other) const { return unpack() / other; }
+    MAYBE_CONSTEXPR BigNum64 operator-() const { return negate(); }
+
+    MAYBE_CONSTEXPR BigNum64 &operator+=(const BigNum64 &b) { return *this = add(b); }
+    MAYBE_CONSTEXPR BigNum64 &operator+=(const std::string_view &b) {
+        return *this = add(BigNum64(b));
+    }
+    MAYBE_CONSTEXPR BigNum64 &operator+=(const man_t b) { return *this = add(BigNum64(b)); }
+    MAYBE_CONSTEXPR BigNum64 &operator-=(const BigNum64 &b) { return *this = sub(b); }
+    MAYBE_CONSTEXPR BigNum64 &operator-=(const std::string_view &b) {
+        return *this = sub(BigNum64(b));
+    }
+    MAYBE_CONSTEXPR BigNum64 &operator-=(const man_t b) { return *this = sub(BigNum64(b)); }
+    MAYBE_CONSTEXPR BigNum64 &operator*=(const BigNum64 &b) { return *this = mul(b); }
+    MAYBE_CONSTEXPR BigNum64 &operator*=(const std::string_view &b) {
+        return *this = mul(BigNum64(b));
+    }
+    MAYBE_CONSTEXPR BigNum64 &operator*=(const man_t b) { return *this = mul(BigNum64(b)); }
+    MAYBE_CONSTEXPR BigNum64 &operator/=(const BigNum64 &b) { return *this = div(b); }
+    MAYBE_CONSTEXPR BigNum64 &operator/=(const std::string_view &b) {
+        return *this = div(BigNum64(b));
+    }
+    MAYBE_CONSTEXPR BigNum64 &operator/=(const man_t b) { return *this = div(BigNum64(b)); }
+    MAYBE_CONSTEXPR BigNum64 &operator++() { return *this += 1.0; }
+    MAYBE_CONSTEXPR BigNum64 operator++(int) {
+        BigNum64 old = *this;
+        ++*this;
+        return old;
+    }
+    MAYBE_CONSTEXPR BigNum64 &operator--() { return *this -= 1.0; }
+    MAYBE_CONSTEXPR BigNum64 operator--(int) {
+        BigNum64 old = *this;
+        --*this;
+        return old;
+    }
+
+    // Comparison operators, computed on the packed bits
+    MAYBE_CONSTEXPR bool is_positive() const { return !(bits & SIGN_BIT) || is_nan(); }
+    MAYBE_CONSTEXPR bool is_negative() const { return (bits & SIGN_BIT) && !is_zero(); }
+    MAYBE_CONSTEXPR bool is_inf() const { return (bits & ~SIGN_BIT) == INF_BITS; }
+    MAYBE_CONSTEXPR bool is_nan() const { return (bits & ~SIGN_BIT) > INF_BITS; }
+    MAYBE_CONSTEXPR bool is_zero() const { return (bits & ~SIGN_BIT) == 0; }
+
+    MAYBE_CONSTEXPR std::partial_ordering operator<=>(const BigNum64 &b) const {
+        if (is_nan() || b.is_nan()) {
+            return std::partial_ordering::unordered;
+        }
+        // Sign-magnitude to two's complement; -0 and +0 both map to 0
+        auto key = [](std::uint64_t v) {
+            auto magnitude = static_cast<std::int64_t>(v & ~SIGN_BIT);
+            return (v & SIGN_BIT) ? -magnitude : magnitude;
+        };
+        return key(bits) <=> key(b.bits);
+    }
+    MAYBE_CONSTEXPR bool operator==(const BigNum64 &other) const {
+        return (*this <=> other) == 0;
+    }
+    MAYBE_CONSTEXPR std::partial_ordering
+    operator<=>(const std::string_view &other) const {
+        return *this <=> BigNum64(other);
+    }
+    MAYBE_CONSTEXPR std::partial_ordering operator<=>(const man_t other) const {
+        return unpack() <=> BigNum(other);
+    }
+    MAYBE_CONSTEXPR std::partial_ordering operator<=>(const BigNum &other) const {
+        return unpack() <=> other;
+    }
+    MAYBE_CONSTEXPR bool operator==(const man_t other) const {
+        return (*this <=> other) == 0;
+    }
+    MAYBE_CONSTEXPR bool operator==(const BigNum &other) const {
+        return (unpack() <=> other) == 0;
+    }
+
+    // Conversion methods
+    std::to_chars_result to_chars(char *first, char *last,
+                                  const BigNumContext &ctx) const {
+        return unpack().to_chars(first, last, ctx);
+    }
+    std::to_chars_result to_chars(char *first, char *last,
+                                  const unsigned int &precision =
+                                      DefaultBigNumContext.print_precision) const {
+        return unpack().to_chars(first, last, precision);
+    }
+    std::to_chars_result to_pretty_chars(char *first, char *last,
+                                         const BigNumContext &ctx) const {
+        return unpack().to_pretty_chars(first, last, ctx);
+    }
+    std::to_chars_result
+    to_pretty_chars(char *first, char *last,
+                    const unsigned int &precision =
+                        DefaultBigNumContext.print_precision) const {
+        return unpack().to_pretty_chars(first, last, precision);
+    }
+    std::string to_string(const BigNumContext &ctx) const {
+        return unpack().to_string(ctx);
+    }
+    std::string to_string(const unsigned int &precision =
+                              DefaultBigNumContext.print_precision) const {
+        return unpack().to_string(precision);
+    }
+    std::string to_pretty_string(const BigNumContext &ctx) const {
+        return unpack().to_pretty_string(ctx);
+    }
+    std::string to_pretty_string(const unsigned int &precision =
+                                     DefaultBigNumContext.print_precision) const {
+        return unpack().to_pretty_string(precision);
+    }
+    std::string serialize() const { return unpack().serialize(); }
+    static BigNum64 deserialize(const std::string_view &str) {
+        return BigNum64(BigNum::deserialize(str));
+    }
+    static std::from_chars_result
+    from_chars(const char *first, const char *last, BigNum64 &value,
+               const BigNumContext &ctx = DefaultBigNumContext) noexcept {
+        BigNum parsed;
+        auto result = BigNum::from_chars(first, last, parsed, ctx);
+        if (result.ec == std::errc()) {
+            value = BigNum64(parsed);
+        }
+        return result;
+    }
+    MAYBE_CONSTEXPR std::optional<intmax_t> to_number() const {
+        return unpack().to_number();
+    }
+
+    // Mathematical operations
+    MAYBE_CONSTEXPR std::optional<double> log10() const { return unpack().log10(); }
+    MAYBE_CONSTEXPR BigNum64 pow(double power) const {
+        return BigNum64(unpack().pow(power));
+    }
+    MAYBE_CONSTEXPR BigNum64 pow(intmax_t power) const {
+        return BigNum64(unpack().pow(power));
+    }
+    MAYBE_CONSTEXPR BigNum64 root(intmax_t n) const { return BigNum64(unpack().root(n)); }
+    MAYBE_CONSTEXPR BigNum64 sqrt() const { return root(2); }
+};
+
+inline std::ostream &operator<<(std::ostream &os, const BigNum64 &bn) {
+    os << BigNum(bn);
+    return os;
+}
+
+inline std::istream &operator>>(std::istream &is, BigNum64 &bn) {
+    BigNum parsed;
+    if (is >> parsed) {
+        bn = BigNum64(parsed);
+    }
+    return is;
+}
+
+static_assert(sizeof(BigNum64) == sizeof(std::uint64_t));
+static_assert(std::totally_ordered<BigNum64>);
+static_assert(std::regular<BigNum64>);
+
+// Log-domain companion of BigNum: stores log10(|x|) and a sign
+// Multiplication and division become additions, and pow/root become a
+// single scalar multiply, which makes long multiplicative chains cheap
+// The relative precision of x is about |log10(x)| * 5e-16, so values with
+// huge exponents carry fewer significant digits than BigNum
+class BigLog {
+    using man_t = double;
+    using exp_t = uintmax_t;
+
+    double l = -std::numeric_limits<double>::infinity(); // log10(|x|)
+    bool negative = false;
+
+    // log10(1 + 10^d) and log10(1 - 10^d) for d <= 0
+    static double log10_1p_exp10(double d) {
+        return std::log1p(std::pow(10.0, d)) / std::numbers::ln10;
+    }
+    static double log10_1m_exp10(double d) {
+        return std::log1p(-std::pow(10.0, d)) / std::numbers::ln10;
+    }
+
+  public:
+    BigLog() = default;
+    BigLog(const man_t value) : l(std::log10(std::abs(value))), negative(value < 0) {}
+    explicit BigLog(const BigNum &value)
+        : l(std::log10(std::abs(value.m)) + static_cast<double>(value.e)),
+          negative(value.m < 0) {}
+
+    static BigLog from_log10(const double log, const bool negative = false) {
+        BigLog v;
+        v.l = log;
+        v.negative = negative;
+        return v;
+    }
+    static BigLog nan() { return from_log10(std::numeric_limits<double>::quiet_NaN()); }
+
+    // Values past BigNum's range are clamped to BigNum::max()/min()
+    BigNum to_bignum() const {
+        const man_t sign = negative ? -1.0 : 1.0;
+        if (std::isnan(l)) {
+            return BigNum::nan();
+        }
+        if (l == std::numeric_limits<double>::infinity()) {
+            return negative ? -BigNum::inf() : BigNum::inf();
+        }
+        if (l < 0) {
+            return BigNum(sign * std::pow(10.0, l));
+        }
+        if (l >= static_cast<double>(std::numeric_limits<exp_t>::max())) {
+            return negative ? BigNum::min() : BigNum::max();
+        }
+        double whole = std::floor(l);
+        auto e = static_cast<exp_t>(whole);
+        man_t m = sign * std::pow(10.0, l - whole);
+        if (e < std::numeric_limits<man_t>::max_digits10 || std::abs(m) >= 10) {
+            return BigNum(m, e);
+        }
+        return BigNum(m, e, false);
+    }
+    explicit operator BigNum() const { return to_bignum(); }
+
+    double log10() const { return l; }
+    bool is_positive() const { return !negative; }
+    bool is_negative() const { return negative && !is_zero(); }
+    bool is_zero() const { return l == -std::numeric_limits<double>::infinity(); }
+    bool is_inf() const { return l == std::numeric_limits<double>::infinity(); }
+    bool is_nan() const { return std::isnan(l); }
+
+    // Arithmetic operations
+    BigLog mul(const BigLog &b) const { return from_log10(l + b.l, negative != b.negative); }
+    BigLog div(const BigLog &b) const { return from_log10(l - b.l, negative != b.negative); }
+
+    // Log-sum-exp in base 10, using log1p for the correction term
+    BigLog add(const BigLog &b) const {
+        if (is_nan() || b.is_nan()) {
+            return from_log10(std::numeric_limits<double>::quiet_NaN());
+        }
+        const BigLog &big = l >= b.l ? *this : b;
+        const BigLog &small = l >= b.l ? b : *this;
+        if (small.is_zero() || big.is_inf()) {
+            if (big.is_inf() && small.is_inf() && big.negative != small.negative) {
+                return from_log10(std::numeric_limits<double>::quiet_NaN());
+            }
+            return big;
+        }
+        const double d = small.l - big.l;
+        if (big.negative == small.negative) {
+            return from_log10(big.l + log10_1p_exp10(d), big.negative);
+        }
+        if (d == 0) {
+            return BigLog();
+        }
+        return from_log10(big.l + log10_1m_exp10(d), big.negative);
+    }
+    BigLog sub(const BigLog &b) const { return add(b.negate()); }
+    BigLog abs() const { return from_log10(l, false); }
+    BigLog negate() const { return from_log10(l, !negative); }
+
+    // Returns num^power
+    BigLog pow(const double power) const {
+        if (power == 0.0) {
+            return BigLog(1.0);
+        }
+        if (is_zero() && power < 0) {
+            if constexpr (USE_EXCEPTIONS) {
+                BIGNUM_FATAL(std::domain_error("Cannot raise 0 to a negative power"));
+            } else {
+                return nan();
+            }
+        }
+        bool odd = false;
+        if (is_negative()) {
+            if (std::abs(power - std::round(power)) >= 1e-10) {
+                if constexpr (USE_EXCEPTIONS) {
+                    BIGNUM_FATAL(std::domain_error("Non-integer powers of negative "
+                                                   "numbers result in complex values"));
+                } else {
+                    return nan();
+                }
+            }
+            odd = std::fmod(std::round(power), 2.0) != 0.0;
+        }
+        return from_log10(l * power, odd);
+    }
+    BigLog pow(const intmax_t power) const { return pow(static_cast<double>(power)); }
+
+    // Returns num^(1/n), aka the nth root
+    BigLog root(const intmax_t n) const {
+        if (n == 0) {
+            if constexpr (USE_EXCEPTIONS) {
+                BIGNUM_FATAL(std::domain_error("Cannot take the zeroth root"));
+            } else {
+                return nan();
+            }
+        }
+        if (is_negative() && n % 2 == 0) {
+            if constexpr (USE_EXCEPTIONS) {
+                BIGNUM_FATAL(std::domain_error("Even root of a negative number is not defined"));
+            } else {
+                return nan();
+            }
+        }
+        return from_log10(l / static_cast<double>(n), is_negative());
+    }
+    BigLog sqrt() const { return root(2); }
+
+    BigLog operator+(const BigLog &other) const { return add(other); }
+    BigLog operator+(const man_t other) const { return add(BigLog(other)); }
+    BigLog operator-(const BigLog &other) const { return sub(other); }
+    BigLog operator-(const man_t other) const { return sub(BigLog(other)); }
+    BigLog operator*(const BigLog &other) const { return mul(other); }
+    BigLog operator*(const man_t other) const { return mul(BigLog(other)); }
+    BigLog operator/(const BigLog &other) const { return div(other); }
+    BigLog operator/(const man_t other) const { return div(BigLog(other)); }
+    BigLog operator-() const { return negate(); }
+    BigLog &operator+=(const BigLog &b) { return *this = add(b); }
+    BigLog &operator+=(const man_t b) { return *this = add(BigLog(b)); }
+    BigLog &operator-=(const BigLog &b) { return *this = sub(b); }
+    BigLog &operator-=(const man_t b) { return *this = sub(BigLog(b)); }
+    BigLog &operator*=(const BigLog &b) { return *this = mul(b); }
+    BigLog &operator*=(const man_t b) { return *this = mul(BigLog(b)); }
+    BigLog &operator/=(const BigLog &b) { return *this = div(b); }
+    BigLog &operator/=(const man_t b) { return *this = div(BigLog(b)); }
+
+    // Comparison operators
+    std::partial_ordering operator<=>(const BigLog &b) const {
+        if (is_nan() || b.is_nan()) {
+            return std::partial_ordering::unordered;
+        }
+        if (is_zero() && b.is_zero()) {
+            return std::partial_ordering::equivalent;
+        }
+        if (is_negative() != b.is_negative()) {
+            return is_negative() ? std::partial_ordering::less
+                                 : std::partial_ordering::greater;
+        }
+        return is_negative() ? b.l <=> l : l <=> b.l;
+    }
+    bool operator==(const BigLog &other) const { return (*this <=> other) == 0; }
+    std::partial_ordering operator<=>(const man_t other) const {
+        return *this <=> BigLog(other);
+    }
+    bool operator==(const man_t other) const { return (*this <=> other) == 0; }
+
+    // Conversion methods
+    std::string to_string(const BigNumContext &ctx) const {
+        return to_bignum().to_string(ctx);
+    }
+    std::string to_string(const unsigned int &precision =
+                              DefaultBigNumContext.print_precision) const {
+        return to_bignum().to_string(precision);
+    }
+};
+
+inline std::ostream &operator<<(std::ostream &os, const BigLog &bl) {
+    os << bl.to_bignum();
+    return os;
+}
+
+// Structure-of-arrays container for large amounts of BigNums
+// Mantissas and exponents live in separate contiguous columns, and the batch
+// kernels below produce bit-for-bit the same results as the scalar operators
+class BigNumArray {
+  public:
+    using man_t = BigNum::man_t;
+    using exp_t = BigNum::exp_t;
+
+    // Mutable view over a range of mantissa/exponent columns
+    struct Span {
+        std::span<man_t> m;
+        std::span<exp_t> e;
+
+        std::size_t size() const { return m.size(); }
+        BigNum operator[](std::size_t i) const { return BigNum(m[i], e[i], false); }
+        void set(std::size_t i, const BigNum &v) const {
+            m[i] = v.m;
+            e[i] = v.e;
+        }
+        Span subspan(std::size_t offset, std::size_t count) const {
+            return {m.subspan(offset, count), e.subspan(offset, count)};
+        }
+    };
+
+    // Read-only view over a range of mantissa/exponent columns
+    struct ConstSpan {
+        std::span<const man_t> m;
+        std::span<const exp_t> e;
+
+        ConstSpan(std::span<const man_t> mantissas,
+                  std::span<const exp_t> exponents)
+            : m(mantissas), e(exponents) {}
+        ConstSpan(const Span &s) : m(s.m), e(s.e) {}
+
+        std::size_t size() const { return m.size(); }
+        BigNum operator[](std::size_t i) const { return BigNum(m[i], e[i], false); }
+        ConstSpan subspan(std::size_t offset, std::size_t count) const {
+            return {m.subspan(offset, count), e.subspan(offset, count)};
+        }
+    };
+
+  private:
+    std::vector<man_t> ms;
+    std::vector<exp_t> es;
+
+    enum class Op { Add, Sub, Mul, Div };
+
+    // Right hand side of a kernel: either a column or a single broadcast value
+    struct Operand {
+        const man_t *m;
+        const exp_t *e;
+        std::size_t stride;
+
+        man_t mat(std::size_t i) const { return m[i * stride]; }
+        exp_t eat(std::size_t i) const { return e[i * stride]; }
+    };
+
+    template <Op op>
+    static void scalar(const man_t am, const exp_t ae, const man_t bm,
+                       const exp_t be, man_t &om, exp_t &oe) {
+        const BigNum a(am, ae, false);
+        const BigNum b(bm, be, false);
+        BigNum r;
+        if constexpr (op == Op::Add) {
+            r = a.add(b);
+        } else if constexpr (op == Op::Sub) {
+            r = a.sub(b);
+        } else if constexpr (op == Op::Mul) {
+            r = a.mul(b);
+        } else {
+            r = a.div(b);
+        }
+        om = r.m;
+        oe = r.e;
+    }
+
+#ifdef BIGNUM_SIMD
+#ifdef __AVX512F__
+    struct SimdOps {
+        static constexpr std::size_t width = 8;
+        using vd = __m512d;
+        using vi = __m512i;
+        using mask = __mmask8;
+
+        static vd load(const man_t *p) { return _mm512_loadu_pd(p); }
+        static vi loadi(const exp_t *p) { return _mm512_loadu_si512(p); }
+        static void store(man_t *p, vd v) { _mm512_storeu_pd(p, v); }
+        static void storei(exp_t *p, vi v) { _mm512_storeu_si512(p, v); }
+        static vd set1(man_t x) { return _mm512_set1_pd(x); }
+        static vi set1i(exp_t x) {
+            return _mm512_set1_epi64(static_cast<long long>(x));
+        }
+
+        static vd add(vd a, vd b) { return _mm512_add_pd(a, b); }
+        static vd sub(vd a, vd b) { return _mm512_sub_pd(a, b); }
+        static vd mul(vd a, vd b) { return _mm512_mul_pd(a, b); }
+        static vd div(vd a, vd b) { return _mm512_div_pd(a, b); }
+        static vd abs(vd a) { return _mm512_abs_pd(a); }
+        static vd neg(vd a) {
+            return _mm512_castsi512_pd(
+                _mm512_xor_si512(_mm512_castpd_si512(a),
+                                 _mm512_castpd_si512(_mm512_set1_pd(-0.0))));
+        }
+        static vi addi(vi a, vi b) { return _mm512_add_epi64(a, b); }
+        static vi subi(vi a, vi b) { return _mm512_sub_epi64(a, b); }
+        static vi andi(vi a, vi b) { return _mm512_and_si512(a, b); }
+        static vi ori(vi a, vi b) { return _mm512_or_si512(a, b); }
+        template <unsigned n> static vi srli(vi a) {
+            return _mm512_mask_srli_epi64(a, 0xFF, a, n);
+        }
+        static vi as_int(vd a) { return _mm512_castpd_si512(a); }
+        static vd as_double(vi a) { return _mm512_castsi512_pd(a); }
+
+        static mask all() { return 0xFF; }
+        static mask land(mask a, mask b) { return a & b; }
+        static mask ge(vd a, vd b) { return _mm512_cmp_pd_mask(a, b, _CMP_GE_OQ); }
+        static mask lt(vd a, vd b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+        static mask ne(vd a, vd b) {
+            return _mm512_cmp_pd_mask(a, b, _CMP_NEQ_OQ);
+        }
+        static mask lei(vi a, vi b) { return _mm512_cmple_epu64_mask(a, b); }
+        static mask small(vi e) {
+            return _mm512_cmplt_epu64_mask(e, set1i(exp_t(1) << 62));
+        }
+        static mask gei(vi a, vi b) { return _mm512_cmpge_epu64_mask(a, b); }
+        static vd blend(mask k, vd a, vd b) { return _mm512_mask_blend_pd(k, b, a); }
+        static vi inc(vi n, mask k) {
+            return _mm512_mask_add_epi64(n, k, n, _mm512_set1_epi64(1));
+        }
+        static vd pow10(vi n) {
+            return _mm512_mask_i64gather_pd(
+                set1(1.0), all(), n,
+                Pow10::Pow10Table.data() + Pow10TableOffset, 8);
+        }
+        static vd gather(const double *table, vi n) {
+            return _mm512_mask_i64gather_pd(set1(0.0), all(), n, table, 8);
+        }
+        static unsigned bits(mask k) { return k; }
+    };
+#else
+    struct SimdOps {
+        static constexpr std::size_t width = 4;
+        using vd = __m256d;
+        using vi = __m256i;
+        using mask = __m256d; // all-ones lanes
+
+        static vd load(const man_t *p) { return _mm256_loadu_pd(p); }
+        static vi loadi(const exp_t *p) {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        }
+        static void store(man_t *p, vd v) { _mm256_storeu_pd(p, v); }
+        static void storei(exp_t *p, vi v) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+        }
+        static vd set1(man_t x) { return _mm256_set1_pd(x); }
+        static vi set1i(exp_t x) {
+            return _mm256_set1_epi64x(static_cast<long long>(x));
+        }
+
+        static vd add(vd a, vd b) { return _mm256_add_pd(a, b); }
+        static vd sub(vd a, vd b) { return _mm256_sub_pd(a, b); }
+        static vd mul(vd a, vd b) { return _mm256_mul_pd(a, b); }
+        static vd div(vd a, vd b) { return _mm256_div_pd(a, b); }
+        static vd abs(vd a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+        static vd neg(vd a) { return _mm256_xor_pd(a, _mm256_set1_pd(-0.0)); }
+        static vi addi(vi a, vi b) { return _mm256_add_epi64(a, b); }
+        static vi subi(vi a, vi b) { return _mm256_sub_epi64(a, b); }
+        static vi andi(vi a, vi b) { return _mm256_and_si256(a, b); }
+        static vi ori(vi a, vi b) { return _mm256_or_si256(a, b); }
+        template <unsigned n> static vi srli(vi a) { return _mm256_srli_epi64(a, n); }
+        static vi as_int(vd a) { return _mm256_castpd_si256(a); }
+        static vd as_double(vi a) { return _mm256_castsi256_pd(a); }
+
+        static mask all() { return _mm256_castsi256_pd(_mm256_set1_epi64x(-1)); }
+        static mask land(mask a, mask b) { return _mm256_and_pd(a, b); }
+        static mask ge(vd a, vd b) { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+        static mask lt(vd a, vd b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+        static mask ne(vd a, vd b) { return _mm256_cmp_pd(a, b, _CMP_NEQ_OQ); }
+        // Signed compares, only valid for exponents below 2^63
+        static mask lei(vi a, vi b) {
+            return _mm256_andnot_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(a, b)),
+                                    all());
+        }
+        static mask gei(vi a, vi b) { return lei(b, a); }
+        static mask small(vi e) {
+            return _mm256_castsi256_pd(_mm256_cmpeq_epi64(
+                _mm256_srli_epi64(e, 62), _mm256_setzero_si256()));
+        }
+        static vd blend(mask k, vd a, vd b) { return _mm256_blendv_pd(b, a, k); }
+        static vi inc(vi n, mask k) {
+            return _mm256_sub_epi64(n, _mm256_castpd_si256(k));
+        }
+        static vd pow10(vi n) {
+            return _mm256_mask_i64gather_pd(
+                set1(1.0), Pow10::Pow10Table.data() + Pow10TableOffset, n,
+                all(), 8);
+        }
+        static vd gather(const double *table, vi n) {
+            return _mm256_i64gather_pd(table, n, 8);
+        }
+        static unsigned bits(mask k) {
+            return static_cast<unsigned>(_mm256_movemask_pd(k));
+        }
+    };
+#endif
+
+    using vd = SimdOps::vd;
+    using vi = SimdOps::vi;
+    using mask = SimdOps::mask;
+    static constexpr std::size_t W = SimdOps::width;
+
+    // Exponents below 2^62 can be added without wrapping and never belong to
+    // max() or min()
+    static mask small(vi e) { return SimdOps::small(e); }
+
+    // Vector counterpart of BigNum::normalize(). Lanes it cannot reproduce
+    // exactly (special values, huge exponents, and results that still need the
+    // final rounding step) are cleared from the returned mask
+    static mask normalize_lanes(vd &m, vi &e, mask ok) {
+        using O = SimdOps;
+        const vd zero = O::set1(0.0);
+        const vd ten = O::set1(10.0);
+        ok = O::land(ok, O::land(O::ne(m, zero), small(e)));
+        ok = O::land(ok, O::lt(O::abs(m),
+                               O::set1(std::numeric_limits<man_t>::infinity())));
+
+        // Same repeated division and multiplication as _log10, so boundary
+        // cases agree. n counts divisions, k multiplications
+        const vd one = O::set1(1.0);
+        vd x = O::blend(ok, O::abs(m), one);
+        vi n = O::set1i(0);
+        vi k = O::set1i(0);
+        for (mask active = O::ge(x, ten); O::bits(active) != 0;
+             active = O::ge(x, ten)) {
+            x = O::blend(active, O::div(x, ten), x);
+            n = O::inc(n, active);
+        }
+        for (mask active = O::lt(x, one); O::bits(active) != 0;
+             active = O::lt(x, one)) {
+            x = O::blend(active, O::mul(x, ten), x);
+            k = O::inc(k, active);
+        }
+        m = O::mul(O::div(m, O::pow10(n)), O::pow10(k));
+        e = O::subi(O::addi(e, n), k);
+
+        // Lanes that would borrow more than their exponent wrap around and
+        // fail small(), leaving the clamp to the scalar path. So do mantissas
+        // that the rounded powers of ten put an ulp outside [1, 10)
+        const vd a = O::abs(m);
+        ok = O::land(ok, O::land(O::ge(a, one), O::lt(a, ten)));
+        return O::land(
+            O::land(ok, small(e)),
+            O::gei(e, O::set1i(std::numeric_limits<man_t>::max_digits10)));
+    }
+
+    // Vector FastMath::exp10() and FastMath::log10(), same formulas. Lanes
+    // outside the table range are cleared from ok and left to the scalar kernel
+    static vd exp10_lanes(vd x, mask &ok) {
+        using O = SimdOps;
+        using F = FastMath;
+        ok = O::lt(O::abs(x), O::set1(1.0));
+        x = O::blend(ok, x, O::set1(0.0));
+        const vd magic = O::set1(F::ROUND_MAGIC);
+        const vd x64 = O::mul(x, O::set1(64.0));
+        const vd t = O::add(x64, magic);
+        const vd jd = O::sub(t, magic);
+        const vd r = O::mul(O::sub(x64, jd), O::set1(1.0 / 64));
+        vd p = O::set1(F::EXP10_C7);
+        for (double c : {F::EXP10_C6, F::EXP10_C5, F::EXP10_C4, F::EXP10_C3,
+                         F::EXP10_C2, F::EXP10_C1}) {
+            p = O::add(O::set1(c), O::mul(r, p));
+        }
+        p = O::mul(r, p);
+        // The low mantissa bits of t hold 2^51 + j
+        const vi j = O::subi(O::andi(O::as_int(t), O::set1i((exp_t(1) << 52) - 1)),
+                             O::set1i((exp_t(1) << 51) - 64));
+        const vd table = O::gather(F::Exp10Table.data(), j);
+        return O::add(table, O::mul(table, p));
+    }
+
+    static vd log10_lanes(vd x, mask &ok) {
+        using O = SimdOps;
+        using F = FastMath;
+        const vd one = O::set1(1.0);
+        ok = O::land(O::ge(x, O::set1(std::numeric_limits<double>::min())),
+                     O::lt(x, O::set1(std::numeric_limits<double>::infinity())));
+        x = O::blend(ok, x, one);
+        const vi bits = O::as_int(x);
+        const vd m = O::as_double(O::ori(O::andi(bits, O::set1i(0x000FFFFFFFFFFFFF)),
+                                         O::set1i(0x3FF0000000000000)));
+        const vd magic = O::set1(F::ROUND_MAGIC);
+        const vd t = O::add(O::mul(O::sub(m, one), O::set1(64.0)), magic);
+        const vd jd = O::sub(t, magic);
+        const vi j = O::andi(O::as_int(t), O::set1i(127));
+        const vd c = O::add(one, O::mul(jd, O::set1(1.0 / 64)));
+        // The binary exponent as a double, the same way round
+        const vi k = O::subi(O::srli<52>(bits), O::set1i(1023));
+        vd kd = O::sub(O::as_double(O::addi(O::as_int(magic), k)), magic);
+        kd = O::add(kd, O::blend(O::ge(jd, O::set1(27.0)), one, O::set1(0.0)));
+        const vd s = O::div(O::sub(m, c), O::add(m, c));
+        const vd s2 = O::mul(s, s);
+        vd series = O::set1(F::LOG10_A7);
+        for (double a : {F::LOG10_A5, F::LOG10_A3}) {
+            series = O::add(O::set1(a), O::mul(s2, series));
+        }
+        series = O::add(O::set1(F::LOG10_A1_LO), O::mul(s2, series));
+        series = O::add(O::mul(s, O::set1(F::LOG10_A1)), O::mul(s, series));
+        const vd table = O::gather(F::Log10Table.data(), j);
+        return O::add(O::mul(kd, O::set1(F::LOG10_2_HI)),
+                      O::add(O::add(O::mul(kd, O::set1(F::LOG10_2_LO)), table),
+                             series));
+    }
+
+    // Processes whole blocks of W elements, returns the index of the first
+    // element left for the scalar loop
+    template <Op op>
+    static std::size_t simd_run(ConstSpan a, Operand b, Span out) {
+        using O = SimdOps;
+        const std::size_t n = a.size();
+        const unsigned full = (1u << W) - 1;
+        alignas(64) man_t bm_in[W], tm[W], um[W];
+        alignas(64) exp_t be_in[W], te[W], ue[W];
+
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) {
+            const vd am = O::load(a.m.data() + i);
+            const vi ae = O::loadi(a.e.data() + i);
+            vd bm;
+            vi be;
+            if (b.stride == 0) {
+                bm = O::set1(*b.m);
+                be = O::set1i(*b.e);
+            } else {
+                bm = O::load(b.m + i);
+                be = O::loadi(b.e + i);
+            }
+            O::store(bm_in, bm);
+            O::storei(be_in, be);
+
+            vd m;
+            vi e;
+            mask ok = O::land(small(ae), small(be));
+            if constexpr (op == Op::Mul) {
+                m = O::mul(am, bm);
+                e = O::addi(ae, be);
+            } else if constexpr (op == Op::Div) {
+                ok = O::land(ok, O::land(O::ne(bm, O::set1(0.0)),
+                                         O::lei(be, ae)));
+                m = O::div(am, bm);
+                e = O::subi(ae, be);
+            } else {
+                if constexpr (op == Op::Sub) {
+                    // sub() adds the normalized negation of b
+                    bm = O::neg(bm);
+                    ok = normalize_lanes(bm, be, ok);
+                }
+                const vd inf = O::set1(std::numeric_limits<man_t>::infinity());
+                ok = O::land(ok, O::land(O::lt(O::abs(am), inf),
+                                         O::lt(O::abs(bm), inf)));
+
+                // Alignment goes through the scalar helper so that any
+                // floating point contraction matches BigNum::add exactly
+                O::store(tm, am);
+                O::storei(te, ae);
+                O::store(um, bm);
+                O::storei(ue, be);
+                for (std::size_t l = 0; l < W; ++l) {
+                    BigNum::align_add(tm[l], te[l], um[l], ue[l], tm[l], te[l]);
+                }
+                m = O::load(tm);
+                e = O::loadi(te);
+            }
+            ok = normalize_lanes(m, e, ok);
+
+            // Keep the inputs of rejected lanes, out may alias a
+            unsigned bad = ~O::bits(ok) & full;
+            if (bad != 0) {
+                O::store(tm, am);
+                O::storei(te, ae);
+            }
+            O::store(out.m.data() + i, m);
+            O::storei(out.e.data() + i, e);
+            while (bad != 0) {
+                const unsigned l = std::countr_zero(bad);
+                scalar<op>(tm[l], te[l], bm_in[l], be_in[l], out.m[i + l],
+                           out.e[i + l]);
+                bad &= bad - 1;
+            }
+        }
+        return i;
+    }
+#endif // BIGNUM_SIMD
+
+    template <Op op> static void run(ConstSpan a, Operand b, Span out) {
+        assert(a.m.size() == a.e.size() && out.m.size() == out.e.size() &&
+               "Mantissa and exponent columns must have the same length");
+        assert(out.size() == a.size() && "Output must match input length");
+        std::size_t i = 0;
+#ifdef BIGNUM_SIMD
+        i = simd_run<op>(a, b, out);
+#endif
+        for (; i < a.size(); ++i) {
+            scalar<op>(a.m[i], a.e[i], b.mat(i), b.eat(i), out.m[i], out.e[i]);
+        }
+    }
+
+    /* Fused kernels: out[i] = c[i] + a[i] * b[i], with the same results as
+     * fallback(i), which computes one element with the scalar operation.
+     * b_offset marks a broadcast b whose exponent is a negative offset stored
+     * wrapped around, as for scaled_add() factors below 1. Lanes the vector
+     * path cannot reproduce exactly are recomputed by fallback(i)
+     */
+    template <typename Fallback>
+    static void run_fused(ConstSpan a, Operand b, bool b_offset, ConstSpan c,
+                          Span out, Fallback &&fallback) {
+        assert(a.m.size() == a.e.size() && c.m.size() == c.e.size() &&
+               out.m.size() == out.e.size() &&
+               "Mantissa and exponent columns must have the same length");
+        assert(c.size() == a.size() && out.size() == a.size() &&
+               "Operands and output must have the same length");
+        std::size_t i = 0;
+#ifdef BIGNUM_SIMD
+        using O = SimdOps;
+        const std::size_t n = a.size();
+        const unsigned full = (1u << W) - 1;
+        const vd one = O::set1(1.0);
+        const vd ten = O::set1(10.0);
+        const vd hundred = O::set1(100.0);
+        const vd inf = O::set1(std::numeric_limits<man_t>::infinity());
+        alignas(64) man_t tm[W], um[W], fm[W];
+        alignas(64) exp_t te[W], ue[W], fe[W];
+        for (; i + W <= n; i += W) {
+            const vd am = O::load(a.m.data() + i);
+            const vi ae = O::loadi(a.e.data() + i);
+            const vd cm = O::load(c.m.data() + i);
+            const vi ce = O::loadi(c.e.data() + i);
+            vd bm;
+            vi be;
+            if (b.stride == 0) {
+                bm = O::set1(*b.m);
+                be = O::set1i(*b.e);
+            } else {
+                bm = O::load(b.m + i);
+                be = O::loadi(b.e + i);
+            }
+
+            // Product and its one-step fix-up, as in BigNum::fused_add()
+            vd pm = O::mul(am, bm);
+            vi pe = O::addi(ae, be);
+            const vd pa = O::abs(pm);
+            mask ok = O::land(O::land(O::ge(pa, one), O::lt(pa, hundred)),
+                              O::land(small(ae), small(pe)));
+            ok = O::land(ok, O::land(small(ce), O::lt(O::abs(cm), inf)));
+            if (!b_offset) {
+                ok = O::land(ok, small(be));
+            }
+            const mask big = O::ge(pa, ten);
+            pm = O::blend(big, O::div(pm, ten), pm);
+            pe = O::inc(pe, big);
+
+            O::store(tm, pm);
+            O::storei(te, pe);
+            O::store(um, cm);
+            O::storei(ue, ce);
+            for (std::size_t l = 0; l < W; ++l) {
+                BigNum::align_add(tm[l], te[l], um[l], ue[l], tm[l], te[l]);
+            }
+            vd m = O::load(tm);
+            vi e = O::loadi(te);
+            ok = normalize_lanes(m, e, ok);
+
+            // Recompute rejected lanes before storing, out may alias a or c
+            unsigned bad = ~O::bits(ok) & full;
+            for (unsigned k = bad; k != 0; k &= k - 1) {
+                const unsigned l = std::countr_zero(k);
+                const BigNum r = fallback(i + l);
+                fm[l] = r.m;
+                fe[l] = r.e;
+            }
+            O::store(out.m.data() + i, m);
+            O::storei(out.e.data() + i, e);
+            for (; bad != 0; bad &= bad - 1) {
+                const unsigned l = std::countr_zero(bad);
+                out.m[i + l] = fm[l];
+                out.e[i + l] = fe[l];
+            }
+        }
+#else
+        (void)b;
+        (void)b_offset;
+#endif
+        for (; i < a.size(); ++i) {
+            const BigNum r = fallback(i);
+            out.m[i] = r.m;
+            out.e[i] = r.e;
+        }
+    }
+
+    static Operand operand(ConstSpan b, std::size_t n) {
+        assert(b.size() == n && "Operands must have the same length");
+        (void)n;
+        return {b.m.data(), b.e.data(), 1};
+    }
+    static Operand operand(const BigNum &b) { return {&b.m, &b.e, 0}; }
+
+    // out[i] = a[i] * 10^log for growth (log >= 0): a plain multiplication by
+    // a broadcast unnormalized BigNum, exactly what BigNum::mul_pow10() does.
+    // Returns false when the scalar operation has to handle the range
+    static bool mul_pow10(ConstSpan a, const double log, Span out) {
+        if (!(std::isfinite(log) && log >= 0 &&
+              log < static_cast<double>(BigNum::FUSED_MAX_E))) {
+            return false;
+        }
+        const double whole = std::floor(log);
+        const BigNum scale(std::pow(10.0, log - whole), static_cast<exp_t>(whole),
+                           false);
+        run<Op::Mul>(a, operand(scale), out);
+        return true;
+    }
+
+    // out[i] = FastMath::log10(x[i]) or FastMath::exp10(x[i]), out may be x
+    template <bool Log>
+    static void fast_math(std::span<const double> x, std::span<double> out) {
+        std::size_t i = 0;
+#ifdef BIGNUM_SIMD
+        const unsigned full = (1u << W) - 1;
+        alignas(64) double in[W];
+        for (; i + W <= x.size(); i += W) {
+            const vd v = SimdOps::load(x.data() + i);
+            mask ok;
+            const vd y = Log ? log10_lanes(v, ok) : exp10_lanes(v, ok);
+            SimdOps::store(in, v);
+            SimdOps::store(out.data() + i, y);
+            for (unsigned bad = ~SimdOps::bits(ok) & full; bad != 0; bad &= bad - 1) {
+                const unsigned l = std::countr_zero(bad);
+                out[i + l] = Log ? FastMath::log10(in[l]) : FastMath::exp10(in[l]);
+            }
+        }
+#endif
+        for (; i < x.size(); ++i) {
+            out[i] = Log ? FastMath::log10(x[i]) : FastMath::exp10(x[i]);
+        }
+    }
+
+    /* Batch fast_pow()/fast_root(): per chunk, the log10 of the mantissas and
+     * 10^x of the fractional part of the new logarithm run through the vector
+     * kernels. new_log(v, log10(v.m)) returns the result's log10 when it is
+     * in [0, 2^63), or nullopt to leave the element to fallback(i)
+     */
+    template <typename NewLog, typename Fallback>
+    static void run_log_domain(ConstSpan a, Span out, NewLog &&new_log,
+                               Fallback &&fallback) {
+        assert(a.m.size() == a.e.size() && out.m.size() == out.e.size() &&
+               "Mantissa and exponent columns must have the same length");
+        assert(out.size() == a.size() && "Output must match input length");
+        constexpr std::size_t CHUNK = 256;
+        alignas(64) double x[CHUNK], y[CHUNK];
+        exp_t whole[CHUNK];
+        bool slow[CHUNK];
+        for (std::size_t begin = 0; begin < a.size(); begin += CHUNK) {
+            const std::size_t n = std::min(CHUNK, a.size() - begin);
+            for (std::size_t i = 0; i < n; ++i) {
+                x[i] = a.m[begin + i] > 0 ? a.m[begin + i] : 1.0;
+            }
+            fast_math<true>({x, n}, {y, n});
+            for (std::size_t i = 0; i < n; ++i) {
+                const std::optional<double> log = new_log(a[begin + i], y[i]);
+                slow[i] = !log;
+                x[i] = log ? std::fmod(*log, 1.0) : 0.0;
+                whole[i] = log ? static_cast<exp_t>(std::floor(*log)) : 0;
+            }
+            fast_math<false>({x, n}, {y, n});
+            for (std::size_t i = 0; i < n; ++i) {
+                out.set(begin + i, slow[i] ? fallback(begin + i) : BigNum(y[i], whole[i]));
+            }
+        }
+    }
+
+  public:
+    BigNumArray() = default;
+    explicit BigNumArray(std::size_t n) : ms(n, 0), es(n, 0) {}
+    BigNumArray(std::span<const BigNum> values) {
+        reserve(values.size());
+        for (const BigNum &v : values) {
+            push_back(v);
+        }
+    }
+
+    std::size_t size() const { return ms.size(); }
+    bool empty() const { return ms.empty(); }
+    void reserve(std::size_t n) {
+        ms.reserve(n);
+        es.reserve(n);
+    }
+    void resize(std::size_t n) {
+        ms.resize(n, 0);
+        es.resize(n, 0);
+    }
+    void clear() {
+        ms.clear();
+        es.clear();
+    }
+    void push_back(const BigNum &v) {
+        ms.push_back(v.m);
+        es.push_back(v.e);
+    }
+
+    BigNum operator[](std::size_t i) const { return BigNum(ms[i], es[i], false); }
+    void set(std::size_t i, const BigNum &v) {
+        ms[i] = v.m;
+        es[i] = v.e;
+    }
+
+    std::span<man_t> mantissas() { return ms; }
+    std::span<const man_t> mantissas() const { return ms; }
+    std::span<exp_t> exponents() { return es; }
+    std::span<const exp_t> exponents() const { return es; }
+    Span span() { return {ms, es}; }
+    ConstSpan span() const { return {ms, es}; }
+    operator Span() { return span(); }
+    operator ConstSpan() const { return span(); }
+
+    // Batch kernels: out[i] = a[i] op b[i] (or op b for a single BigNum)
+    // out may be the same range as a
+    static void add(ConstSpan a, ConstSpan b, Span out) {
+        run<Op::Add>(a, operand(b, a.size()), out);
+    }
+    static void add(ConstSpan a, const BigNum &b, Span out) {
+        run<Op::Add>(a, operand(b), out);
+    }
+    static void sub(ConstSpan a, ConstSpan b, Span out) {
+        run<Op::Sub>(a, operand(b, a.size()), out);
+    }
+    static void sub(ConstSpan a, const BigNum &b, Span out) {
+        run<Op::Sub>(a, operand(b), out);
+    }
+    static void mul(ConstSpan a, ConstSpan b, Span out) {
+        run<Op::Mul>(a, operand(b, a.size()), out);
+    }
+    static void mul(ConstSpan a, const BigNum &b, Span out) {
+        run<Op::Mul>(a, operand(b), out);
+    }
+    static void div(ConstSpan a, ConstSpan b, Span out) {
+        run<Op::Div>(a, operand(b, a.size()), out);
+    }
+    static void div(ConstSpan a, const BigNum &b, Span out) {
+        run<Op::Div>(a, operand(b), out);
+    }
+
+    // Fused kernels, element by element the same as BigNum::fma(),
+    // scaled_add() and mul_pow(). out may be the same range as any input
+    static void fma(ConstSpan a, ConstSpan b, ConstSpan c, Span out) {
+        run_fused(a, operand(b, a.size()), false, c, out, [&](std::size_t i) {
+            return BigNum::fma(a[i], b[i], c[i]);
+        });
+    }
+    static void fma(ConstSpan a, const BigNum &b, ConstSpan c, Span out) {
+        run_fused(a, operand(b), false, c, out, [&](std::size_t i) {
+            return BigNum::fma(a[i], b, c[i]);
+        });
+    }
+    // out[i] = a[i] + x[i] * factor
+    static void scaled_add(ConstSpan a, ConstSpan x, const man_t factor, Span out) {
+        man_t fm = 0;
+        int fe = 0;
+        if (!BigNum::split_pow10(factor, fm, fe)) {
+            for (std::size_t i = 0; i < a.size(); ++i) {
+                out.set(i, a[i].scaled_add(x[i], factor));
+            }
+            return;
+        }
+        // A negative offset is stored wrapped around, and adding it to the
+        // exponents in the kernel wraps it back
+        const exp_t offset = static_cast<exp_t>(static_cast<std::intmax_t>(fe));
+        run_fused(x, {&fm, &offset, 0}, true, a, out, [&](std::size_t i) {
+            return a[i].scaled_add(x[i], factor, fm, fe);
+        });
+    }
+    // out[i] = a[i] * base^power
+    static void mul_pow(ConstSpan a, const BigNum &base, const double power,
+                        Span out) {
+        if (base.m > 0 && base.fusable() &&
+            mul_pow10(a, power * (std::log10(base.m) + static_cast<double>(base.e)),
+                      out)) {
+            return;
+        }
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            out.set(i, a[i].mul_pow(base, power));
+        }
+    }
+    static void mul_pow(ConstSpan a, const man_t base, const double power,
+                        Span out) {
+        if (base > 0 && mul_pow10(a, power * std::log10(base), out)) {
+            return;
+        }
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            out.set(i, a[i].mul_pow(base, power));
+        }
+    }
+
+    /* Batch fast_pow(), fast_root() and fast_log10(), with the FastMath
+     * kernels vectorized. Results are within the kernels' error bounds of the
+     * scalar functions, but may differ from them in the last bit, since
+     * contraction into FMA differs between scalar and vector code. out may be
+     * the same range as a
+     */
+    static void pow(ConstSpan a, const double power, Span out) {
+        run_log_domain(
+            a, out,
+            [&](const BigNum &v, const double lm) -> std::optional<double> {
+                const double log = (static_cast<double>(v.e) + lm) * power;
+                if (!(power != 0 && v.m > 0 && log >= 0 && log < 0x1p63)) {
+                    return std::nullopt;
+                }
+                return log;
+            },
+            [&](std::size_t i) { return a[i].fast_pow(power); });
+    }
+    static void root(ConstSpan a, const intmax_t n, Span out) {
+        run_log_domain(
+            a, out,
+            [&](const BigNum &v, const double lm) -> std::optional<double> {
+                const double log = (lm + static_cast<double>(v.e)) / static_cast<double>(n);
+                if (!(n > 0 && v.m > 0 && log >= 0 && log < 0x1p63)) {
+                    return std::nullopt;
+                }
+                return log;
+            },
+            [&](std::size_t i) { return a[i].fast_root(n); });
+    }
+    // out[i] = a[i].fast_log10(), NaN where that is nullopt
+    static void log10(ConstSpan a, std::span<double> out) {
+        assert(out.size() == a.size() && "Output must match input length");
+        fast_math<true>(a.m, out);
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            const double e = static_cast<double>(a.e[i]);
+            out[i] = std::numeric_limits<double>::max() - e < out[i]
+                         ? std::numeric_limits<double>::quiet_NaN()
+                         : e + out[i];
+        }
+    }
+
+    // Same as calling BigNum::normalize() on every element
+    static void normalize(Span v) {
+        assert(v.m.size() == v.e.size() &&
+               "Mantissa and exponent columns must have the same length");
+        // Counted before the loops, so that GCC can tell the scalar tail
+        // starts at most at n and does not warn that it could run past it
+        const std::size_t n = v.size();
+        std::size_t i = 0;
+#ifdef BIGNUM_SIMD
+        for (const std::size_t simd_end = n - n % W; i < simd_end; i += W) {
+            vd m = SimdOps::load(v.m.data() + i);
+            vi e = SimdOps::loadi(v.e.data() + i);
+            alignas(64) man_t m_in[W];
+            alignas(64) exp_t e_in[W];
+            SimdOps::store(m_in, m);
+            SimdOps::storei(e_in, e);
+            unsigned bad = ~SimdOps::bits(normalize_lanes(m, e, SimdOps::all())) &
+                           ((1u << W) - 1);
+            SimdOps::store(v.m.data() + i, m);
+            SimdOps::storei(v.e.data() + i, e);
+            while (bad != 0) {
+                const unsigned l = std::countr_zero(bad);
+                BigNum x(m_in[l], e_in[l], false);
+                x.normalize();
+                v.m[i + l] = x.m;
+                v.e[i + l] = x.e;
+                bad &= bad - 1;
+            }
+        }
+#endif
+        for (; i < n; ++i) {
+            BigNum x(v.m[i], v.e[i], false);
+            x.normalize();
+            v.m[i] = x.m;
+            v.e[i] = x.e;
+        }
+    }
+    void normalize() { normalize(span()); }
+
+    BigNumArray &operator+=(const BigNumArray &b) {
+        add(*this, b, *this);
+        return *this;
+    }
+    BigNumArray &operator+=(const BigNum &b) {
+        add(*this, b, *this);
+        return *this;
+    }
+    BigNumArray &operator-=(const BigNumArray &b) {
+        sub(*this, b, *this);
+        return *this;
+    }
+    BigNumArray &operator-=(const BigNum &b) {
+        sub(*this, b, *this);
+        return *this;
+    }
+    BigNumArray &operator*=(const BigNumArray &b) {
+        mul(*this, b, *this);
+        return *this;
+    }
+    BigNumArray &operator*=(const BigNum &b) {
+        mul(*this, b, *this);
+        return *this;
+    }
+    BigNumArray &operator/=(const BigNumArray &b) {
+        div(*this, b, *this);
+        return *this;
+    }
+    BigNumArray &operator/=(const BigNum &b) {
+        div(*this, b, *this);
+        return *this;
+    }
+};
+
+/* Hashing for unordered containers
+ * std::hash<BigNum> (below) agrees with operator==: 0 and -0 hash alike, and
+ * every NaN hashes the same
+ * BigNumQuantizedHash and BigNumQuantizedEqual treat two values as equal when
+ * they have the same sign, the same exponent and the same first `digits`
+ * mantissa digits (truncated, 1 to 15), e.g. to let near-identical inputs
+ * share a memoization cache entry. Use both with the same digits. Unlike
+ * operator==, every NaN is quantized-equal to every other NaN
+ */
+namespace detail {
+// splitmix64 finalizer
+inline std::size_t mix_hash(std::uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EB;
+    x ^= x >> 31;
+    return static_cast<std::size_t>(x);
+}
+
+// Sign, decimal exponent and leading digits of a value. Fractions below 1
+// count their leading zeros in shift, as their exponent is already 0
+struct QuantizedBigNum {
+    enum class Kind : unsigned char { Zero, Finite, Inf, NaN } kind;
+    bool negative;
+    std::uintmax_t e;
+    int shift;
+    std::uint64_t digits;
+
+    bool operator==(const QuantizedBigNum &) const = default;
+
+    QuantizedBigNum(const BigNum &v, unsigned int precision)
+        : kind(Kind::Finite), negative(v.getM() < 0), e(v.getE()), shift(0),
+          digits(0) {
+        double m = std::abs(v.getM());
+        if (v.is_nan()) {
+            kind = Kind::NaN;
+            negative = false;
+            return;
+        }
+        if (v.is_inf() || m == 0) {
+            kind = v.is_inf() ? Kind::Inf : Kind::Zero;
+            negative = negative && kind == Kind::Inf;
+            return;
+        }
+        if (m < 1) {
+            shift = -static_cast<int>(std::floor(std::log10(m)));
+            // Subnormals need more than one step of the table
+            for (int rest = shift; rest > 0; rest -= Pow10TableOffset) {
+                m *= *Pow10::get(std::min(rest, Pow10TableOffset));
+            }
+            if (m < 1) {
+                m *= 10; // log10 rounded up at a power of ten
+                ++shift;
+            }
+        }
+        precision = std::clamp(precision, 1u, 15u);
+        digits = static_cast<std::uint64_t>(
+            m * *Pow10::get(static_cast<int>(precision) - 1));
+    }
+};
+} // namespace detail
+
+struct BigNumQuantizedHash {
+    unsigned int digits = 6;
+
+    std::size_t operator()(const BigNum &v) const {
+        const detail::QuantizedBigNum q(v, digits);
+        const std::uint64_t sign_kind =
+            (static_cast<std::uint64_t>(q.kind) << 1) | q.negative;
+        std::uint64_t h = detail::mix_hash(q.e ^ (sign_kind << 60));
+        h = detail::mix_hash(h ^ q.digits ^ (static_cast<std::uint64_t>(q.shift) << 50));
+        return h;
+    }
+};
+
+struct BigNumQuantizedEqual {
+    unsigned int digits = 6;
+
+    bool operator()(const BigNum &a, const BigNum &b) const {
+        return detail::QuantizedBigNum(a, digits) == detail::QuantizedBigNum(b, digits);
+    }
+};
+
+#if BIGNUM_CONSTEXPR
+// Compile-time BigNum literals, e.g. 1.5e300_bn or 1e5000_bn
+inline namespace literals {
+template <char... Chars> consteval BigNum operator""_bn() {
+    constexpr char str[] = {Chars...};
+    return BigNum(std::string_view(str, sizeof...(Chars)));
+}
+} // namespace literals
+#endif
+
+} // namespace BigNumber
+
+// Expose BigNum to the global namespace
+using BigNumber::BigNum;
+#if BIGNUM_CONSTEXPR
+using BigNumber::literals::operator""_bn;
+#endif
+using BigNumber::BigNum64;
+using BigNumber::BigLog;
+using BigNumber::BigNumArray;
+using BigNumber::UnnormalizedBigNum;
+using BigNumber::BigNumAccumulator;
+using BigNumber::BigNumContext;
+using BigNumber::BigNumError;
+using BigNumber::ScopedBigNumContext;
+using BigNumber::BigNumQuantizedEqual;
+using BigNumber::BigNumQuantizedHash;
+using BigNumber::FastMath;
+
+template <> struct std::hash<BigNumber::BigNum> {
+    std::size_t operator()(const BigNumber::BigNum &v) const noexcept {
+        // The sort key already maps -0 to 0 and every NaN to one key
+        const BigNumber::BigNum::SortKey key = v.sort_key();
+        return BigNumber::detail::mix_hash(BigNumber::detail::mix_hash(key.hi) ^ key.lo);
+    }
+};
+
+#ifdef __cpp_lib_format
+/* std::format support: {:[[fill]align][width][.precision][p]}
+ * precision is forwarded to to_string(), and 'p' selects to_pretty_string()
+ * Text is produced with to_chars() into a stack buffer, so formatting does not
+ * allocate unless max_chars() exceeds the buffer
+ */
+template <> struct std::formatter<BigNumber::BigNum, char> {
+    // Read only when has_precision is set. std::format constructs the
+    // formatter in a constant expression to check the format string, so the
+    // thread_local context is not read until format()
+    unsigned int precision = 0;
+    bool has_precision = false;
+    bool pretty = false;
+    char fill = ' ';
+    char align = '>';
+    size_t width = 0;
+
+    constexpr auto parse(std::format_parse_context &ctx) {
+        auto it = ctx.begin();
+        auto end = ctx.end();
+        auto is_align = [](char c) { return c == '<' || c == '>' || c == '^'; };
+        auto parse_uint = [&](auto &value) {
+            value = 0;
+            while (it != end && *it >= '0' && *it <= '9') {
+                value = value * 10 + static_cast<unsigned>(*it - '0');
+                ++it;
+            }
+        };
+
+        // "{}" ends here, and whatever follows is literal text, even '<'
+        if (it == end || *it == '}') {
+            return it;
+        }
+        if (it + 1 != end && is_align(it[1])) {
+            // A '}' would have ended the field above
+            if (*it == '{') {
+                BIGNUM_FATAL(std::format_error("Invalid fill character for BigNum"));
+            }
+            fill = it[0];
+            align = it[1];
+            it += 2;
+        } else if (is_align(*it)) {
+            align = *it++;
+        }
+        parse_uint(width);
+        if (it != end && *it == '.') {
+            ++it;
+            if (it == end || *it < '0' || *it > '9') {
+                BIGNUM_FATAL(std::format_error("Missing precision for BigNum"));
+            }
+            parse_uint(precision);
+            has_precision = true;
+        }
+        if (it != end && *it == 'p') {
+            pretty = true;
+            ++it;
+        }
+        if (it != end && *it != '}') {
+            BIGNUM_FATAL(std::format_error("Invalid format specifier for BigNum"));
+        }
+        return it;
+    }
+
+    template <typename FormatContext>
+    auto format(const BigNumber::BigNum &bn, FormatContext &ctx) const {
+        // The thread's default context is read when formatting, like
+        // to_string()
+        BigNumber::BigNumContext bctx = BigNumber::DefaultBigNumContext;
+        if (has_precision) {
+            bctx.print_precision = precision;
+        }
+
+        char buffer[128];
+        std::string fallback;
+        std::string_view text;
+        auto result = pretty ? bn.to_pretty_chars(buffer, buffer + sizeof(buffer), bctx)
+                             : bn.to_chars(buffer, buffer + sizeof(buffer), bctx);
+        if (result.ec == std::errc()) {
+            text = std::string_view(buffer, result.ptr);
+        } else {
+            fallback = pretty ? bn.to_pretty_string(bctx) : bn.to_string(bctx);
+            text = fallback;
+        }
+
+        size_t padding = width > text.size() ? width - text.size() : 0;
+        size_t before = align == '<' ? 0 : align == '^' ? padding / 2 : padding;
+        auto out = std::fill_n(ctx.out(), before, fill);
+        out = std::copy(text.begin(), text.end(), out);
+        return std::fill_n(out, padding - before, fill);
+    }
+};
+
+// BigNum64 formats exactly like the BigNum it converts to
+template <>
+struct std::formatter<BigNumber::BigNum64, char>
+    : std::formatter<BigNumber::BigNum, char> {
+    template <typename FormatContext>
+    auto format(const BigNumber::BigNum64 &bn, FormatContext &ctx) const {
+        return std::formatter<BigNumber::BigNum, char>::format(bn.to_bignum(), ctx);
+    }
+};
+#endif // __cpp_lib_format
@@ -0,0 +1,197 @@
+/*
+BigNumAtomic: a BigNum shared between threads without a mutex
+A BigNum is 16 bytes (mantissa, exponent), too wide for std::atomic to be
+lock-free. On x86-64 with GCC or Clang, AtomicBigNum swaps both words with a
+single lock cmpxchg16b, so every operation is lock-free. On other targets, or
+with BIGNUM_NO_CMPXCHG16B defined, it falls back to a mutex
+
+Read-modify-write operations are CAS loops: read the value, compute the
+normalized result with the ordinary BigNum operation, and retry if another
+thread changed the value in between. Values are compared bit for bit, and
+every operation is sequentially consistent
+
+load() reads both words with one aligned 16-byte vector load when compiled
+for AVX, where such loads are guaranteed atomic. Without AVX it has to use
+cmpxchg16b too, which always writes: loads then take the cache line
+exclusively like stores, so readers slow down writers under contention, and
+the object cannot live in read-only memory
+*/
+
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+#include "BigNum.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) &&      \
+    !defined(BIGNUM_NO_CMPXCHG16B)
+#define BIGNUM_CMPXCHG16B
+#else
+#include <mutex>
+#endif
+
+namespace BigNumber {
+
+class AtomicBigNum {
+  private:
+    using man_t = BigNumArray::man_t;
+    using exp_t = BigNumArray::exp_t;
+
+    // Mantissa bits and exponent, aligned as cmpxchg16b requires
+    struct alignas(16) Words {
+        std::uint64_t m;
+        std::uint64_t e;
+
+        bool operator==(const Words &) const = default;
+    };
+    static_assert(sizeof(man_t) == 8 && sizeof(exp_t) == 8,
+                  "AtomicBigNum assumes 64-bit mantissa and exponent");
+
+    static Words pack(const BigNum &v) {
+        return {std::bit_cast<std::uint64_t>(v.m), v.e};
+    }
+    static BigNum unpack(const Words &w) {
+        return BigNum(std::bit_cast<man_t>(w.m), w.e, false);
+    }
+
+    // Mutable so that load() can use cmpxchg16b without AVX, which always
+    // writes
+    mutable Words value{};
+
+#ifdef BIGNUM_CMPXCHG16B
+    // If value equals expected, replaces it with desired and returns true.
+    // Otherwise loads the current value into expected and returns false
+    bool cas(Words &expected, const Words &desired) const {
+        bool ok;
+        asm volatile("lock cmpxchg16b %1"
+                     : "=@ccz"(ok), "+m"(value), "+a"(expected.m),
+                       "+d"(expected.e)
+                     : "b"(desired.m), "c"(desired.e)
+                     : "memory");
+        return ok;
+    }
+
+    // Each word read atomically on its own. The pair may be torn, which is
+    // fine as the first guess of a CAS loop: cas() then fails and reloads
+    Words guess() const {
+        return {__atomic_load_n(&value.m, __ATOMIC_RELAXED),
+                __atomic_load_n(&value.e, __ATOMIC_RELAXED)};
+    }
+
+#ifdef __AVX__
+    // Intel and AMD guarantee that aligned 16-byte loads are atomic on
+    // processors with AVX. Stores are all lock cmpxchg16b, so a plain load
+    // is also sequentially consistent
+    Words load_words() const {
+        using Vector = long long __attribute__((vector_size(16)));
+        Vector v;
+        asm volatile("vmovdqa %1, %0" : "=x"(v) : "m"(value) : "memory");
+        return std::bit_cast<Words>(v);
+    }
+#else
+    Words load_words() const {
+        // Comparing with a guess and writing the guess back leaves the value
+        // unchanged either way, and returns it atomically
+        Words w{};
+        cas(w, w);
+        return w;
+    }
+#endif
+#else
+    mutable std::mutex lock;
+#endif
+
+    // Replaces the value with f(old) and returns old
+    template <typename F> BigNum update(F &&f) {
+#ifdef BIGNUM_CMPXCHG16B
+        Words old = guess();
+        for (;;) {
+            // Also when next == old, since only a successful cas() proves
+            // that old was not torn
+            if (cas(old, pack(f(unpack(old))))) {
+                return unpack(old);
+            }
+        }
+#else
+        std::lock_guard guard(lock);
+        const BigNum old = unpack(value);
+        value = pack(f(old));
+        return old;
+#endif
+    }
+
+  public:
+#ifdef BIGNUM_CMPXCHG16B
+    static inline constexpr bool is_always_lock_free = true;
+#else
+    static inline constexpr bool is_always_lock_free = false;
+#endif
+
+    AtomicBigNum() = default;
+    AtomicBigNum(const BigNum &v) : value(pack(v)) {}
+    AtomicBigNum(const AtomicBigNum &) = delete;
+    AtomicBigNum &operator=(const AtomicBigNum &) = delete;
+
+    bool is_lock_free() const { return is_always_lock_free; }
+
+    BigNum load() const {
+#ifdef BIGNUM_CMPXCHG16B
+        return unpack(load_words());
+#else
+        std::lock_guard guard(lock);
+        return unpack(value);
+#endif
+    }
+    void store(const BigNum &v) { exchange(v); }
+    BigNum exchange(const BigNum &v) {
+        return update([&](const BigNum &) { return v; });
+    }
+    operator BigNum() const { return load(); }
+    AtomicBigNum &operator=(const BigNum &v) {
+        store(v);
+        return *this;
+    }
+
+    // Replaces the value with desired if it is bit for bit equal to expected.
+    // Otherwise loads the current value into expected and returns false
+    bool compare_exchange_strong(BigNum &expected, const BigNum &desired) {
+        Words old = pack(expected);
+#ifdef BIGNUM_CMPXCHG16B
+        if (cas(old, pack(desired))) {
+            return true;
+        }
+#else
+        std::lock_guard guard(lock);
+        if (value == old) {
+            value = pack(desired);
+            return true;
+        }
+        old = value;
+#endif
+        expected = unpack(old);
+        return false;
+    }
+
+    // Read-modify-write operations, returning the previous value
+    BigNum fetch_add(const BigNum &v) {
+        return update([&](const BigNum &old) { return old + v; });
+    }
+    BigNum fetch_sub(const BigNum &v) {
+        return update([&](const BigNum &old) { return old - v; });
+    }
+    BigNum fetch_mul(const BigNum &v) {
+        return update([&](const BigNum &old) { return old * v; });
+    }
+    // A NaN argument never replaces the value
+    BigNum fetch_max(const BigNum &v) {
+        return update([&](const BigNum &old) { return v > old ? v : old; });
+    }
+    BigNum fetch_min(const BigNum &v) {
+        return update([&](const BigNum &old) { return v < old ? v : old; });
+    }
+};
+
+} // namespace BigNumber
+
+using BigNumber::AtomicBigNum;
@@ -0,0 +1,882 @@
+/*
+Microbenchmarks for BigNum++
+Every operation is measured over several input distributions, and each result
+is printed as one machine-readable line (CSV by default, JSON lines with
+--json) so runs from different commits can be diffed or plotted
+
+Usage: benchbignum [--json] [--min-time <ms>] [filter]
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <new>
+#include <numeric>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "BigNum.hpp"
+#include "BigNumAtomic.hpp"
+#include "BigNumDD.hpp"
+#include "BigNumExpr.hpp"
+#include "BigNumGenerators.hpp"
+#include "BigNumLeaderboard.hpp"
+#include "BigNumNotation.hpp"
+#include "BigNumParallel.hpp"
+#include "BigNumSort.hpp"
+#if __has_include(<sys/mman.h>)
+#include "BigNumStore.hpp"
+#endif
+
+// Allocation counting: every replaceable global operator new bumps this
+// counter. The matching operator deletes are replaced too, so each pair
+// allocates and frees through the same functions
+static std::atomic<std::uint64_t> allocation_count{0};
+
+static void *counted_alloc(std::size_t size, std::size_t alignment = 0) noexcept {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) {
+        size = 1;
+    }
+    if (alignment <= alignof(std::max_align_t)) {
+        return std::malloc(size);
+    }
+    // aligned_alloc wants a multiple of the alignment
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+static void *counted_alloc_or_throw(std::size_t size, std::size_t alignment = 0) {
+    if (void *p = counted_alloc(size, alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size) { return counted_alloc_or_throw(size); }
+void *operator new[](std::size_t size) { return counted_alloc_or_throw(size); }
+void *operator new(std::size_t size, std::align_val_t al) {
+    return counted_alloc_or_throw(size, static_cast<std::size_t>(al));
+}
+void *operator new[](std::size_t size, std::align_val_t al) {
+    return counted_alloc_or_throw(size, static_cast<std::size_t>(al));
+}
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return counted_alloc(size);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return counted_alloc(size);
+}
+void *operator new(std::size_t size, std::align_val_t al, const std::nothrow_t &) noexcept {
+    return counted_alloc(size, static_cast<std::size_t>(al));
+}
+void *operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t &) noexcept {
+    return counted_alloc(size, static_cast<std::size_t>(al));
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept {
+    std::free(p);
+}
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+// Keep the optimizer from discarding benchmarked results
+template <typename T> inline void do_not_optimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r"(&value) : "memory");
+#else
+    static volatile const T *sink;
+    sink = &value;
+#endif
+}
+
+struct Options {
+    bool json = false;
+    double min_time_ms = 100.0;
+    std::string_view filter;
+};
+Options options;
+
+constexpr std::size_t INPUTS = 4096; // power of two, cycled with a mask
+
+// Runs f(i) repeatedly until min_time has passed, and prints one result line
+// items is how many BigNum operations a single call performs
+template <typename F>
+void bench(std::string_view op, std::string_view dist, F &&f,
+           std::size_t items = 1) {
+    std::string name = std::string(op) + "/" + std::string(dist);
+    if (!options.filter.empty() && !name.contains(options.filter)) {
+        return;
+    }
+    using clock = std::chrono::steady_clock;
+
+    // Warm up and calibrate
+    std::size_t iterations = 64;
+    double elapsed_ns = 0;
+    std::uint64_t allocations = 0;
+    for (;;) {
+        std::uint64_t alloc_before = allocation_count.load();
+        auto start = clock::now();
+        for (std::size_t i = 0; i < iterations; ++i) {
+            f(i & (INPUTS - 1));
+        }
+        elapsed_ns = std::chrono::duration<double, std::nano>(clock::now() -
+                                                              start)
+                         .count();
+        allocations = allocation_count.load() - alloc_before;
+        if (elapsed_ns >= options.min_time_ms * 1e6 ||
+            iterations >= (std::size_t(1) << 40)) {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    double ops = static_cast<double>(iterations) * static_cast<double>(items);
+    double ns_per_op = elapsed_ns / ops;
+    double ops_per_s = 1e9 / ns_per_op;
+    double allocs_per_op = static_cast<double>(allocations) / ops;
+    if (options.json) {
+        std::printf("{\"op\":\"%.*s\",\"dist\":\"%.*s\",\"ns_per_op\":%.3f,"
+                    "\"ops_per_s\":%.0f,\"allocs_per_op\":%.3f}\n",
+                    static_cast<int>(op.size()), op.data(),
+                    static_cast<int>(dist.size()), dist.data(), ns_per_op,
+                    ops_per_s, allocs_per_op);
+    } else {
+        std::printf("%.*s,%.*s,%.3f,%.0f,%.3f\n", static_cast<int>(op.size()),
+                    op.data(), static_cast<int>(dist.size()), dist.data(),
+                    ns_per_op, ops_per_s, allocs_per_op);
+    }
+    std::fflush(stdout);
+}
+
+// Input distributions
+struct Distribution {
+    std::string_view name;
+    std::vector<BigNum> a;
+    std::vector<BigNum> b;
+};
+
+std::vector<Distribution> make_distributions() {
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> mant(1.0, 10.0);
+    auto sign = [&] { return (rng() & 1) ? 1.0 : -1.0; };
+
+    std::vector<Distribution> dists;
+    auto generate = [&](std::string_view name, auto &&gen_a, auto &&gen_b) {
+        Distribution d{name, {}, {}};
+        d.a.reserve(INPUTS);
+        d.b.reserve(INPUTS);
+        for (std::size_t i = 0; i < INPUTS; ++i) {
+            d.a.push_back(gen_a());
+            d.b.push_back(gen_b());
+        }
+        dists.push_back(std::move(d));
+    };
+
+    // Small values that never leave e == 0
+    auto small = [&] { return BigNum(sign() * mant(rng) * 100.0); };
+    generate("small_e0", small, small);
+
+    // Exponents close enough for add() to align them (delta <= 14)
+    generate(
+        "delta_le14",
+        [&] { return BigNum(sign() * mant(rng), 1000 + rng() % 8); },
+        [&] { return BigNum(sign() * mant(rng), 1000 + rng() % 14); });
+
+    // Exponents far enough apart for add() to drop the smaller one
+    generate(
+        "delta_gt14",
+        [&] { return BigNum(sign() * mant(rng), 1000 + rng() % 100); },
+        [&] { return BigNum(sign() * mant(rng), 1200 + rng() % 100); });
+
+    // Values near max() and min(), exercising the clamping paths
+    auto huge = [&] {
+        switch (rng() % 4) {
+        case 0:
+            return BigNum::max();
+        case 1:
+            return BigNum::min();
+        default:
+            return BigNum(sign() * mant(rng),
+                          std::numeric_limits<uintmax_t>::max() - rng() % 16);
+        }
+    };
+    generate("near_max", huge, huge);
+
+    // NaN and infinities mixed with regular values
+    auto special = [&] {
+        switch (rng() % 4) {
+        case 0:
+            return BigNum::nan();
+        case 1:
+            return BigNum::inf();
+        case 2:
+            return -BigNum::inf();
+        default:
+            return BigNum(sign() * mant(rng), rng() % 1000);
+        }
+    };
+    generate("nan_inf", special, special);
+
+    return dists;
+}
+
+void bench_scalar(const Distribution &d) {
+    const auto &a = d.a;
+    const auto &b = d.b;
+
+    bench("add", d.name, [&](std::size_t i) { do_not_optimize(a[i] + b[i]); });
+    bench("sub", d.name, [&](std::size_t i) { do_not_optimize(a[i] - b[i]); });
+    bench("mul", d.name, [&](std::size_t i) { do_not_optimize(a[i] * b[i]); });
+    bench("div", d.name, [&](std::size_t i) { do_not_optimize(a[i] / b[i]); });
+    bench("add_assign", d.name, [&, acc = a[0]](std::size_t i) mutable {
+        acc += b[i];
+        do_not_optimize(acc);
+    });
+    bench("accumulator_add", d.name, [&, acc = BigNumAccumulator(a[0])](
+                                         std::size_t i) mutable {
+        acc += b[i];
+        do_not_optimize(acc);
+    });
+    bench("accumulator_add_kahan", d.name,
+          [&, acc = BigNumAccumulator(a[0], true)](std::size_t i) mutable {
+              acc += b[i];
+              do_not_optimize(acc);
+          });
+    bench("compare", d.name,
+          [&](std::size_t i) { do_not_optimize(a[i] < b[i]); });
+    bench("hash", d.name,
+          [&](std::size_t i) { do_not_optimize(std::hash<BigNum>()(a[i])); });
+    bench("quantized_hash", d.name, [&](std::size_t i) {
+        do_not_optimize(BigNumQuantizedHash{4}(a[i]));
+    });
+
+    // Construction from an unnormalized mantissa runs a full normalize()
+    bench("normalize", d.name, [&](std::size_t i) {
+        do_not_optimize(BigNum(a[i].getM() * 123.456, a[i].getE()));
+    });
+
+    std::vector<std::string> strings;
+    for (const BigNum &v : a) {
+        strings.push_back(v.to_string(9));
+    }
+    bench("to_string", d.name,
+          [&](std::size_t i) { do_not_optimize(a[i].to_string()); });
+    bench("to_pretty_string", d.name,
+          [&](std::size_t i) { do_not_optimize(a[i].to_pretty_string()); });
+    bench("parse", d.name, [&](std::size_t i) {
+        do_not_optimize(BigNum(std::string_view(strings[i])));
+    });
+    bench("from_chars", d.name, [&](std::size_t i) {
+        BigNum v;
+        const std::string &s = strings[i];
+        do_not_optimize(BigNum::from_chars(s.data(), s.data() + s.size(), v));
+        do_not_optimize(v);
+    });
+
+    // Malformed client input: the number followed by garbage
+    std::vector<std::string> malformed;
+    for (const std::string &s : strings) {
+        malformed.push_back("x" + s);
+    }
+    bench("from_chars_invalid", d.name, [&](std::size_t i) {
+        BigNum v;
+        const std::string &s = malformed[i];
+        do_not_optimize(BigNum::from_chars(s.data(), s.data() + s.size(), v));
+    });
+
+    // Packed 8-byte values: every operation widens to BigNum and packs back
+    std::vector<BigNum64> a64(a.begin(), a.end()), b64(b.begin(), b.end());
+    bench("bignum64_add", d.name,
+          [&](std::size_t i) { do_not_optimize(a64[i] + b64[i]); });
+    bench("bignum64_mul", d.name,
+          [&](std::size_t i) { do_not_optimize(a64[i] * b64[i]); });
+    bench("bignum64_compare", d.name,
+          [&](std::size_t i) { do_not_optimize(a64[i] < b64[i]); });
+    bench("bignum64_pack", d.name,
+          [&](std::size_t i) { do_not_optimize(BigNum64(a[i])); });
+
+    std::byte buffer[BigNum::SERIAL_MAX_SIZE];
+    bench("serialize_to", d.name,
+          [&](std::size_t i) { do_not_optimize(a[i].serialize_to(buffer)); });
+    bench("serialize_to_compact", d.name, [&](std::size_t i) {
+        do_not_optimize(
+            a[i].serialize_to(buffer, BigNum::SerialFormat::Compact));
+    });
+
+    // pow() and root() reject negative bases with fractional exponents. The
+    // magnitudes are taken up front so that only the operation is timed
+    std::vector<BigNum> abs_a;
+    for (const BigNum &v : a) {
+        abs_a.push_back(v.abs());
+    }
+    bench("pow", d.name,
+          [&](std::size_t i) { do_not_optimize(abs_a[i].pow(1.5)); });
+    bench("root", d.name,
+          [&](std::size_t i) { do_not_optimize(abs_a[i].root(3)); });
+    bench("log10", d.name,
+          [&](std::size_t i) { do_not_optimize(abs_a[i].log10()); });
+    bench("fast_pow", d.name,
+          [&](std::size_t i) { do_not_optimize(abs_a[i].fast_pow(1.5)); });
+    bench("fast_root", d.name,
+          [&](std::size_t i) { do_not_optimize(abs_a[i].fast_root(3)); });
+    bench("fast_log10", d.name,
+          [&](std::size_t i) { do_not_optimize(abs_a[i].fast_log10()); });
+
+#ifdef __cpp_lib_expected
+    // Signed bases, where pow(1.5) fails for every negative one: the error
+    // code API against wrapping each call in try/catch
+    bench("try_pow", d.name, [&](std::size_t i) {
+        do_not_optimize(a[i].try_pow(1.5).value_or(BigNum::nan()));
+    });
+    bench("pow_try_catch", d.name, [&](std::size_t i) {
+        try {
+            do_not_optimize(a[i].pow(1.5));
+        } catch (const std::domain_error &) {
+            do_not_optimize(BigNum::nan());
+        }
+    });
+    bench("try_parse_invalid", d.name, [&](std::size_t i) {
+        do_not_optimize(BigNum::try_parse(malformed[i]).value_or(BigNum::nan()));
+    });
+    bench("parse_invalid_try_catch", d.name, [&](std::size_t i) {
+        try {
+            do_not_optimize(BigNum(std::string_view(malformed[i])));
+        } catch (const std::invalid_argument &) {
+            do_not_optimize(BigNum::nan());
+        }
+    });
+#endif
+}
+
+void bench_batch(const Distribution &d) {
+    BigNumArray a(d.a), b(d.b), out(INPUTS), raw(INPUTS);
+    for (std::size_t i = 0; i < INPUTS; ++i) {
+        raw.mantissas()[i] = a.mantissas()[i] * 123.456;
+        raw.exponents()[i] = a.exponents()[i];
+    }
+    bench(
+        "batch_add", d.name,
+        [&](std::size_t) { BigNumArray::add(a, b, out); }, INPUTS);
+    bench(
+        "batch_sub", d.name,
+        [&](std::size_t) { BigNumArray::sub(a, b, out); }, INPUTS);
+    bench(
+        "batch_mul", d.name,
+        [&](std::size_t) { BigNumArray::mul(a, b, out); }, INPUTS);
+    bench(
+        "batch_div", d.name,
+        [&](std::size_t) { BigNumArray::div(a, b, out); }, INPUTS);
+    std::vector<std::byte> bytes(INPUTS * BigNum::SERIAL_MAX_SIZE);
+    std::vector<BigNum> values(INPUTS);
+    for (auto format :
+         {BigNum::SerialFormat::Fixed, BigNum::SerialFormat::Compact}) {
+        bool fixed = format == BigNum::SerialFormat::Fixed;
+        std::size_t size = BigNum::serialize_to(d.a, bytes, format);
+        bench(
+            fixed ? "batch_serialize" : "batch_serialize_compact", d.name,
+            [&](std::size_t) {
+                do_not_optimize(BigNum::serialize_to(d.a, bytes, format));
+            },
+            INPUTS);
+        bench(
+            fixed ? "batch_deserialize" : "batch_deserialize_compact", d.name,
+            [&](std::size_t) {
+                do_not_optimize(BigNum::deserialize_from(
+                    std::span(bytes).first(size), values, format));
+            },
+            INPUTS);
+    }
+    BigNumArray positive(INPUTS);
+    for (std::size_t i = 0; i < INPUTS; ++i) {
+        positive.set(i, d.a[i].abs());
+    }
+    std::vector<double> logs(INPUTS);
+    bench(
+        "batch_pow", d.name,
+        [&](std::size_t) { BigNumArray::pow(positive, 1.5, out); }, INPUTS);
+    bench(
+        "batch_root", d.name,
+        [&](std::size_t) { BigNumArray::root(positive, 3, out); }, INPUTS);
+    bench(
+        "batch_log10", d.name,
+        [&](std::size_t) {
+            BigNumArray::log10(positive, logs);
+            do_not_optimize(logs[0]);
+        },
+        INPUTS);
+    bench(
+        "batch_normalize", d.name,
+        [&](std::size_t) {
+            out = raw;
+            BigNumArray::normalize(out);
+            do_not_optimize(out.mantissas()[0]);
+        },
+        INPUTS);
+}
+
+// base * mult1 * mult2 * mult3 + bonus, with and without deferred
+// normalization
+void bench_chains(const Distribution &d) {
+    const auto &a = d.a;
+    const auto &b = d.b;
+    auto next = [](std::size_t i) { return (i + 1) & (INPUTS - 1); };
+    bench("chain_bignum", d.name, [&](std::size_t i) {
+        BigNum r = a[i] * b[i] * a[next(i)] * b[next(i)] + a[i];
+        do_not_optimize(r);
+    });
+    bench("chain_unnormalized", d.name, [&](std::size_t i) {
+        BigNum r = UnnormalizedBigNum(a[i]) * b[i] * a[next(i)] * b[next(i)] +
+                   a[i];
+        do_not_optimize(r);
+    });
+    bench("chain_expr", d.name, [&](std::size_t i) {
+        BigNum r = lazy(a[i]) * b[i] * a[next(i)] * b[next(i)] + a[i];
+        do_not_optimize(r);
+    });
+
+    // a * b + c * d - e, and the same with scalar operands
+    bench("expr_eager", d.name, [&](std::size_t i) {
+        BigNum r = a[i] * b[i] + a[next(i)] * b[next(i)] - a[i];
+        do_not_optimize(r);
+    });
+    bench("expr_lazy", d.name, [&](std::size_t i) {
+        BigNum r = lazy(a[i]) * b[i] + lazy(a[next(i)]) * b[next(i)] - a[i];
+        do_not_optimize(r);
+    });
+    bench("expr_scalar_eager", d.name, [&](std::size_t i) {
+        BigNum r = a[i] * 2.0 + b[i] * 0.5 - 1e5;
+        do_not_optimize(r);
+    });
+    bench("expr_scalar_lazy", d.name, [&](std::size_t i) {
+        BigNum r = lazy(a[i]) * 2.0 + lazy(b[i]) * 0.5 - 1e5;
+        do_not_optimize(r);
+    });
+}
+
+// Tick kernel: balance += rate * multiplier * dt, and compounding
+void bench_fused(const Distribution &d) {
+    const auto &a = d.a;
+    const auto &b = d.b;
+    const BigNum multiplier(2.5, 3);
+    const double dt = 0.016;
+    bench("tick_unfused", d.name, [&](std::size_t i) {
+        do_not_optimize(a[i] + b[i] * multiplier * BigNum(dt));
+    });
+    bench("tick_fused", d.name, [&](std::size_t i) {
+        do_not_optimize(a[i].scaled_add(b[i] * multiplier, dt));
+    });
+    const BigNum rate_scale = multiplier * BigNum(dt);
+    bench("tick_unfused_premul", d.name, [&](std::size_t i) {
+        do_not_optimize(a[i] + b[i] * rate_scale);
+    });
+    bench("tick_fma", d.name, [&](std::size_t i) {
+        do_not_optimize(BigNum::fma(b[i], rate_scale, a[i]));
+    });
+    bench("mul_pow_unfused", d.name, [&](std::size_t i) {
+        do_not_optimize(a[i] * BigNum(3.0).pow(12.5));
+    });
+    bench("mul_pow", d.name,
+          [&](std::size_t i) { do_not_optimize(a[i].mul_pow(3.0, 12.5)); });
+
+    BigNumArray balance(a), rate(b), tmp(INPUTS);
+    bench(
+        "batch_tick_unfused", d.name,
+        [&](std::size_t) {
+            BigNumArray::mul(rate, rate_scale, tmp);
+            BigNumArray::add(balance, tmp, tmp);
+            do_not_optimize(tmp.mantissas()[0]);
+        },
+        INPUTS);
+    bench(
+        "batch_tick_fused", d.name,
+        [&](std::size_t) {
+            BigNumArray::fma(rate, rate_scale, balance, tmp);
+            do_not_optimize(tmp.mantissas()[0]);
+        },
+        INPUTS);
+    bench(
+        "batch_scaled_add", d.name,
+        [&](std::size_t) {
+            BigNumArray::scaled_add(balance, rate, dt, tmp);
+            do_not_optimize(tmp.mantissas()[0]);
+        },
+        INPUTS);
+    bench(
+        "batch_mul_pow", d.name,
+        [&](std::size_t) {
+            BigNumArray::mul_pow(balance, 3.0, 12.5, tmp);
+            do_not_optimize(tmp.mantissas()[0]);
+        },
+        INPUTS);
+}
+
+// Offline progress for one hour: closed form vs one tick per second
+void bench_offline(const Distribution &d) {
+    constexpr std::size_t TIERS = 8;
+    constexpr std::size_t PLAYERS = INPUTS / TIERS;
+    std::vector<BigNum> rates(TIERS - 1, BigNum(2.0));
+    const GeneratorChain chain(rates);
+    std::vector<BigNum> amounts(d.a.begin(), d.a.end());
+    for (BigNum &v : amounts) {
+        v = v.abs();
+    }
+    std::vector<double> seconds(PLAYERS, 3600.0);
+    std::vector<BigNum> work(amounts.size());
+    bench(
+        "offline_closed_form", d.name,
+        [&](std::size_t) {
+            work = amounts;
+            chain.advance(work, seconds);
+            do_not_optimize(work[0]);
+        },
+        PLAYERS);
+    bench("offline_ticks", d.name, [&](std::size_t i) {
+        std::size_t p = i % PLAYERS;
+        BigNum a[TIERS];
+        std::copy_n(amounts.begin() + p * TIERS, TIERS, a);
+        for (int tick = 0; tick < 3600; ++tick) {
+            for (std::size_t k = 0; k + 1 < TIERS; ++k) {
+                a[k] += rates[k] * a[k + 1];
+            }
+        }
+        do_not_optimize(a[0]);
+    });
+}
+
+// Double-double mantissas, against the BigNum add/mul/div/to_string above
+void bench_double_double(const Distribution &d) {
+    std::vector<BigNumDD> a(d.a.begin(), d.a.end()), b(d.b.begin(), d.b.end());
+    bench("dd_add", d.name, [&](std::size_t i) { do_not_optimize(a[i] + b[i]); });
+    bench("dd_mul", d.name, [&](std::size_t i) { do_not_optimize(a[i] * b[i]); });
+    bench("dd_div", d.name, [&](std::size_t i) { do_not_optimize(a[i] / b[i]); });
+    bench("dd_add_assign", d.name, [&, acc = a[0]](std::size_t i) mutable {
+        acc += b[i];
+        do_not_optimize(acc);
+    });
+    bench("dd_to_string", d.name,
+          [&](std::size_t i) { do_not_optimize(a[i].to_string()); });
+    std::vector<std::string> strings;
+    for (const BigNumDD &v : a) {
+        strings.push_back(v.serialize());
+    }
+    bench("dd_parse", d.name, [&](std::size_t i) {
+        BigNumDD v;
+        const std::string &s = strings[i];
+        do_not_optimize(BigNumDD::from_chars(s.data(), s.data() + s.size(), v));
+        do_not_optimize(v);
+    });
+}
+
+// Suffix notations into a stack buffer, against BigNum::to_chars
+void bench_notation(const Distribution &d) {
+    const auto &a = d.a;
+    char buf[256];
+    bench("to_chars", d.name, [&](std::size_t i) {
+        do_not_optimize(a[i].to_chars(buf, buf + sizeof(buf)));
+        do_not_optimize(buf);
+    });
+    auto notation = [&](Notation n) {
+        return [&, n](std::size_t i) {
+            do_not_optimize(to_notation_chars(buf, buf + sizeof(buf), a[i], n));
+            do_not_optimize(buf);
+        };
+    };
+    bench("notation_short", d.name, notation(Notation::ShortScale));
+    bench("notation_long", d.name, notation(Notation::LongScale));
+    bench("notation_engineering", d.name, notation(Notation::Engineering));
+    bench("notation_letters", d.name, notation(Notation::Letters));
+}
+
+// Prestige-style chains of pow/root/mul, in BigNum and in the log domain
+void bench_log_chains(const Distribution &d) {
+    std::vector<BigNum> a, b;
+    for (std::size_t i = 0; i < INPUTS; ++i) {
+        a.push_back(d.a[i].abs());
+        b.push_back(d.b[i].abs());
+    }
+    std::vector<BigLog> la, lb;
+    for (std::size_t i = 0; i < INPUTS; ++i) {
+        la.push_back(BigLog(a[i]));
+        lb.push_back(BigLog(b[i]));
+    }
+    // Each round is one pow, one mul and one root
+    for (std::size_t rounds : {4, 33}) {
+        std::string suffix = std::to_string(3 * rounds);
+        bench(
+            "pow_chain_" + suffix + "_bignum", d.name,
+            [&](std::size_t i) {
+                BigNum r = a[i];
+                for (std::size_t k = 0; k < rounds; ++k) {
+                    r = (r.pow(1.5) * b[i]).root(2);
+                }
+                do_not_optimize(r);
+            },
+            3 * rounds);
+        bench(
+            "pow_chain_" + suffix + "_biglog", d.name,
+            [&](std::size_t i) {
+                BigLog r = la[i];
+                for (std::size_t k = 0; k < rounds; ++k) {
+                    r = (r.pow(1.5) * lb[i]).root(2);
+                }
+                do_not_optimize(r);
+            },
+            3 * rounds);
+    }
+}
+
+// "Buy max": closed form vs buying one item at a time
+void bench_series(const Distribution &d) {
+    std::vector<BigNum> budget, price;
+    for (std::size_t i = 0; i < INPUTS; ++i) {
+        budget.push_back(d.a[i].abs() * 1000.0);
+        price.push_back(d.b[i].abs());
+    }
+    bench("afford_geometric", d.name, [&](std::size_t i) {
+        do_not_optimize(BigNum::afford_geometric_series(budget[i], price[i], 1.07));
+    });
+    bench("afford_arithmetic", d.name, [&](std::size_t i) {
+        do_not_optimize(BigNum::afford_arithmetic_series(budget[i], price[i], price[i]));
+    });
+    bench("afford_geometric_loop", d.name, [&](std::size_t i) {
+        BigNum next = price[i], left = budget[i], n;
+        for (std::size_t k = 0; k < 10000 && next <= left; ++k) {
+            left -= next;
+            next *= 1.07;
+            n += 1.0;
+        }
+        do_not_optimize(n);
+    });
+}
+
+// Server-wide totals over a large range: serial fold vs parallel reductions
+void bench_reductions(const Distribution &d) {
+    constexpr std::size_t N = 64 * INPUTS;
+    std::vector<BigNum> values;
+    values.reserve(N);
+    for (std::size_t i = 0; i < N; ++i) {
+        values.push_back(d.a[i & (INPUTS - 1)]);
+    }
+    bench(
+        "accumulate", d.name,
+        [&](std::size_t) {
+            do_not_optimize(std::accumulate(values.begin(), values.end(), BigNum()));
+        },
+        N);
+    for (std::size_t threads : {1, 0}) {
+        std::string suffix = threads == 1 ? "_1t" : "_all";
+        bench(
+            "reduce_sum" + suffix, d.name,
+            [&](std::size_t) { do_not_optimize(reduce_sum(values, threads)); }, N);
+        bench(
+            "reduce_max" + suffix, d.name,
+            [&](std::size_t) { do_not_optimize(reduce_max(values, threads)); }, N);
+    }
+}
+
+// Leaderboard sort: std::sort with operator< against radix_sort. Each call
+// sorts a fresh copy, so both include the copy
+void bench_sort(const Distribution &d) {
+    constexpr std::size_t N = 64 * INPUTS;
+    std::vector<BigNum> values;
+    values.reserve(N);
+    std::mt19937_64 rng(7);
+    for (std::size_t i = 0; i < N; ++i) {
+        values.push_back(d.a[rng() & (INPUTS - 1)]);
+    }
+    std::vector<BigNum> work(N);
+    bench(
+        "std_sort", d.name,
+        [&](std::size_t) {
+            work = values;
+            // NaNs last, as operator< alone is not a strict weak order
+            std::sort(work.begin(), work.end(), [](const BigNum &a, const BigNum &b) {
+                return !a.is_nan() && (b.is_nan() || a < b);
+            });
+            do_not_optimize(work[N / 2]);
+        },
+        N);
+    bench(
+        "radix_sort", d.name,
+        [&](std::size_t) {
+            work = values;
+            radix_sort(work);
+            do_not_optimize(work[N / 2]);
+        },
+        N);
+    bench(
+        "sort_key", d.name,
+        [&](std::size_t i) { do_not_optimize(d.a[i & (INPUTS - 1)].sort_key()); });
+}
+
+// Leaderboard of N players: score updates and rank queries, against finding
+// a rank by counting better scores in a plain array
+void bench_leaderboard(const Distribution &d) {
+    constexpr std::size_t N = 64 * INPUTS;
+    BigNumLeaderboard<std::uint64_t> board(
+        BigNumLeaderboard<std::uint64_t>::NaNPolicy::Last);
+    std::vector<BigNum> scores(N);
+    for (std::size_t i = 0; i < N; ++i) {
+        scores[i] = d.a[i & (INPUTS - 1)];
+        board.insert(i, scores[i]);
+    }
+    std::mt19937_64 rng(3);
+    std::vector<std::uint64_t> ids(INPUTS);
+    for (std::uint64_t &id : ids) {
+        id = rng() % N;
+    }
+    bench("leaderboard_update", d.name, [&](std::size_t i) {
+        board.update(ids[i & (INPUTS - 1)], d.b[i & (INPUTS - 1)]);
+    });
+    bench("leaderboard_rank", d.name, [&](std::size_t i) {
+        do_not_optimize(board.rank(ids[i & (INPUTS - 1)]));
+    });
+    bench("leaderboard_at_rank", d.name, [&](std::size_t i) {
+        do_not_optimize(board.at_rank(ids[i & (INPUTS - 1)]));
+    });
+    bench("leaderboard_top100", d.name,
+          [&](std::size_t) { do_not_optimize(board.top(100)); });
+    bench("count_rank", d.name, [&](std::size_t i) {
+        const BigNum &score = scores[ids[i & (INPUTS - 1)]];
+        do_not_optimize(std::count_if(scores.begin(), scores.end(),
+                                      [&](const BigNum &x) { return x > score; }));
+    });
+}
+
+// Shared counter updated from 1 to 64 threads: AtomicBigNum against a BigNum
+// behind a mutex. One call runs every thread to completion
+void bench_contention(const Distribution &d) {
+    constexpr std::size_t UPDATES = 16384; // per thread and call
+    for (std::size_t threads : {1, 2, 4, 8, 16, 32, 64}) {
+        std::string suffix = "_" + std::to_string(threads) + "t";
+        auto run = [&](auto &&update) {
+            std::vector<std::jthread> pool;
+            pool.reserve(threads);
+            for (std::size_t t = 0; t < threads; ++t) {
+                pool.emplace_back([&, t] {
+                    for (std::size_t i = 0; i < UPDATES; ++i) {
+                        update(d.a[(t * UPDATES + i) & (INPUTS - 1)]);
+                    }
+                });
+            }
+        };
+        AtomicBigNum atomic;
+        bench(
+            "atomic_fetch_add" + suffix, d.name,
+            [&](std::size_t) {
+                run([&](const BigNum &x) { atomic.fetch_add(x); });
+                do_not_optimize(atomic.load());
+            },
+            threads * UPDATES);
+        std::mutex lock;
+        BigNum locked;
+        bench(
+            "mutex_add" + suffix, d.name,
+            [&](std::size_t) {
+                run([&](const BigNum &x) {
+                    std::lock_guard guard(lock);
+                    locked += x;
+                });
+                do_not_optimize(locked);
+            },
+            threads * UPDATES);
+    }
+}
+
+#if __has_include(<sys/mman.h>)
+// Cold start: mapping a column file vs parsing one text value per row
+void bench_store(const Distribution &d) {
+    std::string path =
+        (std::filesystem::temp_directory_path() / "benchbignum.bnc").string();
+    BigNumStore::create(path, INPUTS).append(d.a);
+    std::vector<std::string> strings;
+    for (const BigNum &v : d.a) {
+        strings.push_back(v.serialize());
+    }
+    bench(
+        "store_open", d.name,
+        [&](std::size_t) {
+            BigNumStore store = BigNumStore::open(path, false, false);
+            do_not_optimize(store[INPUTS - 1]);
+        },
+        INPUTS);
+    bench(
+        "store_open_verify", d.name,
+        [&](std::size_t) {
+            BigNumStore store = BigNumStore::open(path);
+            do_not_optimize(store[INPUTS - 1]);
+        },
+        INPUTS);
+    bench(
+        "deserialize_text", d.name,
+        [&](std::size_t) {
+            BigNumArray values;
+            values.reserve(INPUTS);
+            for (const std::string &s : strings) {
+                values.push_back(BigNum::deserialize(s));
+            }
+            do_not_optimize(values[INPUTS - 1]);
+        },
+        INPUTS);
+    std::filesystem::remove(path);
+}
+#endif
+
+} // namespace
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--json") {
+            options.json = true;
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            options.min_time_ms = std::atof(argv[++i]);
+        } else {
+            options.filter = arg;
+        }
+    }
+
+    if (!options.json) {
+        std::printf("op,dist,ns_per_op,ops_per_s,allocs_per_op\n");
+    }
+    for (const Distribution &d : make_distributions()) {
+        bench_scalar(d);
+        bench_batch(d);
+        bench_chains(d);
+        bench_fused(d);
+        bench_offline(d);
+        bench_double_double(d);
+        bench_notation(d);
+        bench_log_chains(d);
+        bench_series(d);
+        bench_reductions(d);
+        bench_sort(d);
+        bench_leaderboard(d);
+        bench_contention(d);
+#if __has_include(<sys/mman.h>)
+        bench_store(d);
+#endif
+    }
+    return 0;
+}
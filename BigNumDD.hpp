@@ -0,0 +1,914 @@
+/*
+BigNumDD: BigNum with a double-double mantissa, for ledgers that must not
+drift
+ExtendedBigNum<Mantissa> is BigNum with the mantissa type as a parameter:
+the same m * 10^e layout, normalization rules, operators, comparisons and
+formatting, with the precision of the mantissa type. MantissaTraits<Mantissa>
+is the extension point; this header ships two of them:
+- BigNumDD = ExtendedBigNum<DoubleDouble>: hi + lo, about 106 bits, so values
+  keep 30 significant digits, integers are exact below 10^30, and add() keeps
+  operands up to 29 orders of magnitude smaller (BigNum: 15, 10^17 and 14)
+- BigNumLD = ExtendedBigNum<long double>: the platform's long double (18
+  digits with x87, the same as BigNum where long double is double)
+
+Double-double arithmetic relies on exactly rounded IEEE operations and
+std::fma, so it must not be compiled with -ffast-math. It costs a few times
+a BigNum operation (see the dd_* benchmarks), still far below a software
+bignum. Conversions from BigNum are exact, conversions back round to nearest
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <charconv>
+#include <cmath>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include "BigNum.hpp"
+
+namespace BigNumber {
+
+// Unevaluated sum hi + lo with |lo| <= ulp(hi) / 2. The algorithms are the
+// usual error-free transformations (Dekker, Knuth); inf and NaN are only
+// meaningful in hi
+struct DoubleDouble {
+    double hi = 0;
+    double lo = 0;
+
+    constexpr DoubleDouble() = default;
+    constexpr DoubleDouble(const double x) : hi(x) {}
+    constexpr DoubleDouble(const double h, const double l) : hi(h), lo(l) {}
+
+    // a + b as an exact double-double
+    static DoubleDouble two_sum(const double a, const double b) {
+        const double s = a + b;
+        const double bb = s - a;
+        return {s, (a - (s - bb)) + (b - bb)};
+    }
+    // Same, for |a| >= |b|
+    static DoubleDouble quick_two_sum(const double a, const double b) {
+        const double s = a + b;
+        return {s, b - (s - a)};
+    }
+    // a * b as an exact double-double
+    static DoubleDouble two_prod(const double a, const double b) {
+        const double p = a * b;
+        return {p, std::fma(a, b, -p)};
+    }
+
+    explicit operator double() const { return hi + lo; }
+
+    friend DoubleDouble operator+(const DoubleDouble &a, const DoubleDouble &b) {
+        DoubleDouble s = two_sum(a.hi, b.hi);
+        const DoubleDouble t = two_sum(a.lo, b.lo);
+        s = quick_two_sum(s.hi, s.lo + t.hi);
+        return quick_two_sum(s.hi, s.lo + t.lo);
+    }
+    friend DoubleDouble operator-(const DoubleDouble &a) { return {-a.hi, -a.lo}; }
+    friend DoubleDouble operator-(const DoubleDouble &a, const DoubleDouble &b) {
+        return a + -b;
+    }
+    friend DoubleDouble operator*(const DoubleDouble &a, const DoubleDouble &b) {
+        const DoubleDouble p = two_prod(a.hi, b.hi);
+        return quick_two_sum(p.hi, p.lo + (a.hi * b.lo + a.lo * b.hi));
+    }
+    friend DoubleDouble operator*(const DoubleDouble &a, const double b) {
+        const DoubleDouble p = two_prod(a.hi, b);
+        return quick_two_sum(p.hi, p.lo + a.lo * b);
+    }
+    // Long division with three double quotient digits
+    friend DoubleDouble operator/(const DoubleDouble &a, const DoubleDouble &b) {
+        const double q1 = a.hi / b.hi;
+        DoubleDouble r = a - b * q1;
+        const double q2 = r.hi / b.hi;
+        r = r - b * q2;
+        const double q3 = r.hi / b.hi;
+        return quick_two_sum(q1, q2) + q3;
+    }
+    DoubleDouble &operator+=(const DoubleDouble &b) { return *this = *this + b; }
+    DoubleDouble &operator-=(const DoubleDouble &b) { return *this = *this - b; }
+    DoubleDouble &operator*=(const DoubleDouble &b) { return *this = *this * b; }
+    DoubleDouble &operator/=(const DoubleDouble &b) { return *this = *this / b; }
+
+    friend std::partial_ordering operator<=>(const DoubleDouble &a,
+                                             const DoubleDouble &b) {
+        const std::partial_ordering c = a.hi <=> b.hi;
+        return c != 0 ? c : a.lo <=> b.lo;
+    }
+    friend bool operator==(const DoubleDouble &a, const DoubleDouble &b) {
+        return a.hi == b.hi && a.lo == b.lo;
+    }
+};
+
+/* What ExtendedBigNum needs from a mantissa type besides + - * / and
+ * comparisons:
+ * digits10           significant decimal digits that survive normalization
+ * pow10(n)           10^n for |n| <= Pow10TableOffset
+ * floor_log10(x)     floor(log10(x)) for finite x > 0
+ * round(x), trunc(x) to an integer, halfway cases away from zero
+ * sqrt(x), to_double(x), isnan(x), isinf(x)
+ * write_integer(n, out, count)
+ *                    the count digits of the integer 0 <= n < 10^count,
+ *                    count <= digits10, zero-padded
+ */
+template <typename Mantissa> struct MantissaTraits;
+
+template <> struct MantissaTraits<DoubleDouble> {
+    using M = DoubleDouble;
+    // 106 bits hold 31.9 digits; one is kept as a guard so that
+    // normalization and digit output round correctly
+    static inline constexpr int digits10 = 30;
+
+    static const M &pow10(const int n) {
+        assert(n >= -Pow10TableOffset && n <= Pow10TableOffset &&
+               "Power of ten out of range");
+        static const std::array<M, Pow10TableSize> table = [] {
+            std::array<M, Pow10TableSize> t{};
+            // Exact up to 10^44, whose odd part 5^44 still fits in 106 bits
+            for (int i = 0; i <= 22; ++i) {
+                t[Pow10TableOffset + i] = M(*Pow10::get(i));
+            }
+            for (int i = 23; i <= 44; ++i) {
+                t[Pow10TableOffset + i] = M::two_prod(1e22, *Pow10::get(i - 22));
+            }
+            for (int i = 45; i <= Pow10TableOffset; ++i) {
+                t[Pow10TableOffset + i] = t[Pow10TableOffset + i - 44] * t[Pow10TableOffset + 44];
+            }
+            for (int i = 1; i <= Pow10TableOffset; ++i) {
+                t[Pow10TableOffset - i] = M(1.0) / t[Pow10TableOffset + i];
+            }
+            return t;
+        }();
+        return table[Pow10TableOffset + n];
+    }
+
+    static int floor_log10(const M &x) {
+        int k = static_cast<int>(std::floor(std::log10(x.hi)));
+        if (std::abs(k) < Pow10TableOffset) {
+            if (x < pow10(k)) {
+                --k;
+            } else if (x >= pow10(k + 1)) {
+                ++k;
+            }
+        }
+        return k;
+    }
+
+    static M trunc(const M &x) {
+        const double hi = std::trunc(x.hi);
+        if (hi != x.hi) {
+            return M(hi);
+        }
+        // hi is an integer, so is the sum; lo decides the direction
+        return M::quick_two_sum(hi, x.hi > 0 ? std::floor(x.lo) : std::ceil(x.lo));
+    }
+    static M round(const M &x) {
+        return x.hi < 0 ? -trunc(-x + M(0.5)) : trunc(x + M(0.5));
+    }
+    // One Newton step from the double square root
+    static M sqrt(const M &x) {
+        if (!(x.hi > 0) || std::isinf(x.hi)) {
+            return M(std::sqrt(x.hi));
+        }
+        const double s = std::sqrt(x.hi);
+        const M r = x - M::two_prod(s, s);
+        return M::quick_two_sum(s, r.hi / (2 * s));
+    }
+    static double to_double(const M &x) { return x.hi + x.lo; }
+    static bool isnan(const M &x) { return std::isnan(x.hi); }
+    static bool isinf(const M &x) { return std::isinf(x.hi); }
+
+    // Splits n into two 15-digit halves that fit a double exactly
+    static void write_integer(const M &n, char *out, const int count) {
+        constexpr double HALF = 1e15;
+        double q = std::floor(n.hi / HALF);
+        M r = n - M::two_prod(q, HALF);
+        while (r < M(0.0)) {
+            q -= 1;
+            r += M(HALF);
+        }
+        while (r >= M(HALF)) {
+            q += 1;
+            r -= M(HALF);
+        }
+        auto low = static_cast<std::uint64_t>(to_double(r));
+        auto high = static_cast<std::uint64_t>(q);
+        for (int i = count - 1; i >= 0; --i) {
+            const bool in_low = i >= count - 15;
+            std::uint64_t &part = in_low ? low : high;
+            out[i] = static_cast<char>('0' + part % 10);
+            part /= 10;
+        }
+    }
+};
+
+template <> struct MantissaTraits<long double> {
+    using M = long double;
+    static inline constexpr int digits10 = std::numeric_limits<M>::digits10;
+
+    static M pow10(const int n) {
+        static const std::array<M, Pow10TableSize> table = [] {
+            std::array<M, Pow10TableSize> t{};
+            for (int i = -Pow10TableOffset; i <= Pow10TableOffset; ++i) {
+                t[Pow10TableOffset + i] = std::pow(10.0L, static_cast<M>(i));
+            }
+            return t;
+        }();
+        return table[Pow10TableOffset + n];
+    }
+    static int floor_log10(const M x) {
+        int k = static_cast<int>(std::floor(std::log10(x)));
+        if (std::abs(k) < Pow10TableOffset) {
+            if (x < pow10(k)) {
+                --k;
+            } else if (x >= pow10(k + 1)) {
+                ++k;
+            }
+        }
+        return k;
+    }
+    static M trunc(const M x) { return std::trunc(x); }
+    static M round(const M x) { return std::round(x); }
+    static M sqrt(const M x) { return std::sqrt(x); }
+    static double to_double(const M x) { return static_cast<double>(x); }
+    static bool isnan(const M x) { return std::isnan(x); }
+    static bool isinf(const M x) { return std::isinf(x); }
+    static void write_integer(const M n, char *out, const int count) {
+        auto v = static_cast<std::uint64_t>(n);
+        for (int i = count - 1; i >= 0; --i) {
+            out[i] = static_cast<char>('0' + v % 10);
+            v /= 10;
+        }
+    }
+};
+
+template <typename Mantissa> class ExtendedBigNum {
+  public:
+    using man_t = Mantissa;
+    using exp_t = uintmax_t;
+    using Traits = MantissaTraits<Mantissa>;
+
+    // Significant digits kept. Values below 10^DIGITS are rounded to
+    // integers, and add() drops operands more than DIGITS - 1 orders of
+    // magnitude smaller
+    static inline constexpr int DIGITS = Traits::digits10;
+
+  private:
+    static inline constexpr exp_t MAX_DIV_DIFF = 308;
+    static inline constexpr exp_t MAX_E = std::numeric_limits<exp_t>::max();
+
+    man_t m = man_t(0.0); // mantissa
+    exp_t e = 0;          // exponent (base 10)
+
+    ExtendedBigNum(const man_t &mantissa, const exp_t exponent, bool normalize)
+        : m(mantissa), e(exponent) {
+        if (normalize) {
+            this->normalize();
+        }
+    }
+
+    static bool negative(const man_t &x) { return x < man_t(0.0); }
+    static man_t abs(const man_t &x) { return negative(x) ? -x : x; }
+    bool at_limit() const { return *this == max() || *this == min(); }
+    static ExtendedBigNum saturated(const bool negative) {
+        return negative ? min() : max();
+    }
+
+    // x * 10^n for any n >= 0, in steps the pow10() table covers
+    static man_t scale_up(man_t x, exp_t n) {
+        for (; n > static_cast<exp_t>(Pow10TableOffset); n -= Pow10TableOffset) {
+            x = x * Traits::pow10(Pow10TableOffset);
+        }
+        return x * Traits::pow10(static_cast<int>(n));
+    }
+    static man_t scale_down(man_t x, exp_t n) {
+        for (; n > static_cast<exp_t>(Pow10TableOffset); n -= Pow10TableOffset) {
+            x = x * Traits::pow10(-Pow10TableOffset);
+        }
+        return x * Traits::pow10(-static_cast<int>(n));
+    }
+
+    // Rounds |m| != 0 to DIGITS significant digits d0.d1d2... * 10^p, writes
+    // them to out and returns p. p is 0 for normalized mantissas, or 1 when
+    // rounding carried into the next power of ten (9.99... -> 10)
+    int significant_digits(char *out) const {
+        int p = Traits::floor_log10(abs(m));
+        const int shift = DIGITS - 1 - p;
+        const man_t scaled = Traits::round(
+            shift <= Pow10TableOffset ? abs(m) * Traits::pow10(shift)
+                                      : scale_up(abs(m), static_cast<exp_t>(shift)));
+        if (scaled >= Traits::pow10(DIGITS)) {
+            out[0] = '1';
+            std::fill_n(out + 1, DIGITS - 1, '0');
+            return p + 1;
+        }
+        Traits::write_integer(scaled, out, DIGITS);
+        return p;
+    }
+
+    static std::to_chars_result put(char *&first, char *last, std::string_view text) {
+        if (last - first < static_cast<std::ptrdiff_t>(text.size())) {
+            return {last, std::errc::value_too_large};
+        }
+        first = std::copy(text.begin(), text.end(), first);
+        return {first, std::errc()};
+    }
+
+    // to_chars() with '.' as the decimal separator
+    std::to_chars_result to_chars_point(char *first, char *last,
+                                        const BigNumContext &ctx) const {
+        const std::to_chars_result too_large{last, std::errc::value_too_large};
+        if (is_inf() || is_nan()) {
+            return put(first, last, is_nan() ? "nan" : negative(m) ? "-inf" : "inf");
+        }
+        if (negative(m) && put(first, last, "-").ec != std::errc()) {
+            return too_large;
+        }
+
+        if (m == man_t(0.0)) {
+            return put(first, last, "0");
+        }
+        char digits[DIGITS];
+        const int p = significant_digits(digits);
+
+        // Small numbers in fixed notation, truncated to print_precision
+        // fractional digits
+        if (e == 0 && p < 0) {
+            // 0.00ddd: -p - 1 zeros, then the digits
+            const auto precision = static_cast<std::size_t>(ctx.print_precision);
+            const auto zeros = static_cast<std::size_t>(-p - 1);
+            std::size_t kept = precision > zeros ? std::min<std::size_t>(precision - zeros, DIGITS) : 0;
+            while (kept > 0 && digits[kept - 1] == '0') {
+                --kept;
+            }
+            if (kept == 0) {
+                return put(first, last, "0");
+            }
+            if (put(first, last, "0.").ec != std::errc() ||
+                static_cast<std::size_t>(last - first) < zeros + kept) {
+                return too_large;
+            }
+            first = std::fill_n(first, zeros, '0');
+            return {std::copy_n(digits, kept, first), std::errc()};
+        }
+        const exp_t exponent = e + static_cast<exp_t>(p);
+
+        // Integers up to max_digits long, rounded to the last digit shown
+        const unsigned int max_digits = std::max(ctx.print_precision + 1, ctx.max_digits);
+        if (e < max_digits - 1) {
+            const auto length = static_cast<std::size_t>(exponent + 1);
+            const std::size_t kept = std::min<std::size_t>(length, DIGITS);
+            if (static_cast<std::size_t>(last - first) < length) {
+                return too_large;
+            }
+            first = std::copy_n(digits, kept, first);
+            return {std::fill_n(first, length - kept, '0'), std::errc()};
+        }
+
+        // Otherwise scientific notation, with the digits truncated to
+        // print_precision
+        const auto precision = static_cast<std::size_t>(ctx.print_precision);
+        const std::size_t kept = std::min<std::size_t>(precision, DIGITS - 1);
+        if (static_cast<std::size_t>(last - first) < precision + 2 ||
+            put(first, last, std::string_view(digits, 1)).ec != std::errc()) {
+            return too_large;
+        }
+        if (precision > 0) {
+            *first++ = '.';
+            first = std::copy_n(digits + 1, kept, first);
+            first = std::fill_n(first, precision - kept, '0');
+        }
+        if (first == last) {
+            return too_large;
+        }
+        *first++ = 'e';
+        const auto result = std::to_chars(first, last, exponent);
+        return result.ec == std::errc() ? result : too_large;
+    }
+
+    // The context that serialize() writes and deserialize() reads: every
+    // significant digit, '.' and no grouping
+    static BigNumContext serial_context() {
+        return BigNumContext{10, DIGITS - 1, '.', ','};
+    }
+    static BigNumContext with_precision(unsigned int precision) {
+        BigNumContext ctx = DefaultBigNumContext;
+        ctx.print_precision = precision;
+        return ctx;
+    }
+
+  public:
+    static ExtendedBigNum inf() {
+        return ExtendedBigNum(man_t(std::numeric_limits<double>::infinity()), 0, false);
+    }
+    static ExtendedBigNum nan() {
+        return ExtendedBigNum(man_t(std::numeric_limits<double>::quiet_NaN()), 0, false);
+    }
+    static ExtendedBigNum max() {
+        return ExtendedBigNum(man_t(std::nextafter(10.0, 0.0)), MAX_E, false);
+    }
+    static ExtendedBigNum min() {
+        return ExtendedBigNum(man_t(std::nextafter(-10.0, 0.0)), MAX_E, false);
+    }
+
+    ExtendedBigNum() = default;
+    template <typename T>
+        requires std::is_arithmetic_v<T>
+    ExtendedBigNum(const T value) : ExtendedBigNum(man_t(value), 0) {}
+    explicit ExtendedBigNum(const man_t &mantissa, const exp_t exponent = 0)
+        : m(mantissa), e(exponent) {
+        normalize();
+    }
+    // Exact: every BigNum is representable
+    ExtendedBigNum(const BigNum &value)
+        : ExtendedBigNum(man_t(value.getM()), value.getE()) {}
+    ExtendedBigNum(const std::string_view &str) {
+        const char *last = str.data() + str.size();
+        auto [ptr, ec] = from_chars(str.data(), last, *this);
+        if (ec != std::errc() || ptr != last) {
+            *this = nan();
+            if constexpr (USE_EXCEPTIONS) {
+                BIGNUM_FATAL(std::invalid_argument("Failed to parse number: " + std::string(str)));
+            }
+        }
+    }
+
+    const man_t &getM() const { return m; }
+    exp_t getE() const { return e; }
+
+    // Rounds the mantissa to a double
+    BigNum to_bignum() const {
+        if (is_nan()) {
+            return BigNum::nan();
+        }
+        if (is_inf()) {
+            return negative(m) ? -BigNum::inf() : BigNum::inf();
+        }
+        if (e == MAX_E) {
+            return negative(m) ? BigNum::min() : BigNum::max();
+        }
+        return BigNum(Traits::to_double(m), e);
+    }
+    explicit operator BigNum() const { return to_bignum(); }
+
+    // Same rules as BigNum::normalize(): |m| in [1, 10), except for
+    // fractions with e == 0, integers below 10^DIGITS, and max()/min()
+    // for everything beyond the exponent range
+    void normalize() {
+        if (Traits::isnan(m) || Traits::isinf(m)) {
+            m = man_t(Traits::to_double(m)); // drop a NaN low part
+            e = 0;
+            return;
+        }
+        if (m == man_t(0.0)) {
+            e = 0;
+            return;
+        }
+        if (at_limit() || (abs(m) < man_t(1.0) && e == 0)) {
+            return;
+        }
+
+        const int n_log = Traits::floor_log10(abs(m));
+        if (n_log >= 0) {
+            if (e > MAX_E - static_cast<exp_t>(n_log)) {
+                *this = saturated(negative(m));
+                return;
+            }
+            m = m / Traits::pow10(n_log);
+            e += static_cast<exp_t>(n_log);
+        } else {
+            // Mantissa under 1: borrow from the exponent, but never below 0
+            const exp_t k = std::min(static_cast<exp_t>(-n_log), e);
+            m = scale_up(m, k);
+            e -= k;
+        }
+        if (abs(m) >= man_t(10.0)) {
+            m = m / man_t(10.0);
+            if (e++ == MAX_E) {
+                *this = saturated(negative(m));
+                return;
+            }
+        }
+        if (e == MAX_E && abs(m) > max().m) {
+            *this = saturated(negative(m));
+            return;
+        }
+
+        if (e < static_cast<exp_t>(DIGITS)) {
+            const man_t scale = Traits::pow10(static_cast<int>(e));
+            m = Traits::round(m * scale) / scale;
+            // Rounding can carry into the next power of ten (9.9 -> 10)
+            if (abs(m) >= man_t(10.0)) {
+                m = m / man_t(10.0);
+                ++e;
+            }
+        }
+    }
+
+    // Arithmetic operations
+    ExtendedBigNum add(const ExtendedBigNum &b) const {
+        if (is_nan() || b.is_nan()) {
+            return nan();
+        }
+        if (is_inf() || b.is_inf()) {
+            if (is_inf() && b.is_inf() && negative(m) != negative(b.m)) {
+                return nan();
+            }
+            return is_inf() ? *this : b;
+        }
+        // Saturated values absorb anything with the same sign
+        if ((at_limit() || b.at_limit()) && negative(m) == negative(b.m)) {
+            return at_limit() ? *this : b;
+        }
+        if (e == 0 && b.e == 0) {
+            return ExtendedBigNum(m + b.m, 0);
+        }
+
+        const bool this_is_bigger = e > b.e;
+        const exp_t delta = this_is_bigger ? e - b.e : b.e - e;
+        if (delta >= static_cast<exp_t>(DIGITS)) {
+            return this_is_bigger ? *this : b;
+        }
+        const int d = static_cast<int>(delta);
+        if (this_is_bigger) {
+            return ExtendedBigNum(m * Traits::pow10(d) + b.m, b.e);
+        }
+        return ExtendedBigNum(m + b.m * Traits::pow10(d), e);
+    }
+    ExtendedBigNum sub(const ExtendedBigNum &b) const { return add(b.negate()); }
+
+    ExtendedBigNum mul(const ExtendedBigNum &b) const {
+        if (is_nan() || b.is_nan() || is_inf() || b.is_inf() || m == man_t(0.0) ||
+            b.m == man_t(0.0)) {
+            return ExtendedBigNum(m * b.m, 0);
+        }
+        if (e > MAX_E - b.e) {
+            return saturated(negative(m) != negative(b.m));
+        }
+        return ExtendedBigNum(m * b.m, e + b.e);
+    }
+
+    ExtendedBigNum div(const ExtendedBigNum &b) const {
+        if (b.m == man_t(0.0) || is_nan() || b.is_nan()) {
+            return nan();
+        }
+        // Divisor is significantly larger than dividend, result is 0
+        if (b.e > e && b.e - e >= MAX_DIV_DIFF) {
+            return ExtendedBigNum();
+        }
+        // Result below 10^0: fold the exponent difference into the mantissa
+        if (b.e > e) {
+            return ExtendedBigNum(scale_down(m / b.m, b.e - e), 0);
+        }
+        return ExtendedBigNum(m / b.m, e - b.e);
+    }
+
+    ExtendedBigNum abs() const { return ExtendedBigNum(abs(m), e, false); }
+    ExtendedBigNum negate() const { return ExtendedBigNum(-m, e, false); }
+
+    // Returns num^power by repeated squaring, so integer powers stay within
+    // a few units of the last digit
+    ExtendedBigNum pow(const intmax_t power) const {
+        auto n = static_cast<uintmax_t>(power < 0 ? -(power + 1) : power) +
+                 (power < 0 ? 1 : 0);
+        ExtendedBigNum result(1), base = *this;
+        for (; n != 0; n >>= 1) {
+            if (n & 1) {
+                result = result.mul(base);
+            }
+            if (n > 1) {
+                base = base.mul(base);
+            }
+        }
+        return power < 0 ? ExtendedBigNum(1).div(result) : result;
+    }
+
+    ExtendedBigNum sqrt() const {
+        if (is_negative()) {
+            if constexpr (USE_EXCEPTIONS) {
+                BIGNUM_FATAL(std::domain_error("Even root of a negative number is not defined"));
+            } else {
+                return nan();
+            }
+        }
+        if (is_nan() || is_inf()) {
+            return *this;
+        }
+        // Make the exponent even, so that it halves exactly
+        const bool odd = e % 2 == 1;
+        return ExtendedBigNum(Traits::sqrt(odd ? m * man_t(10.0) : m), e / 2);
+    }
+
+    double log10() const {
+        return std::log10(std::abs(Traits::to_double(m))) + static_cast<double>(e);
+    }
+
+    // Operator overloads
+    ExtendedBigNum operator+(const ExtendedBigNum &other) const { return add(other); }
+    ExtendedBigNum operator-(const ExtendedBigNum &other) const { return sub(other); }
+    ExtendedBigNum operator*(const ExtendedBigNum &other) const { return mul(other); }
+    ExtendedBigNum operator/(const ExtendedBigNum &other) const { return div(other); }
+    ExtendedBigNum operator-() const { return negate(); }
+    ExtendedBigNum &operator+=(const ExtendedBigNum &b) { return *this = add(b); }
+    ExtendedBigNum &operator-=(const ExtendedBigNum &b) { return *this = sub(b); }
+    ExtendedBigNum &operator*=(const ExtendedBigNum &b) { return *this = mul(b); }
+    ExtendedBigNum &operator/=(const ExtendedBigNum &b) { return *this = div(b); }
+    ExtendedBigNum &operator++() { return *this = add(ExtendedBigNum(1)); }
+    ExtendedBigNum operator++(int) {
+        ExtendedBigNum temp(*this);
+        ++*this;
+        return temp;
+    }
+    ExtendedBigNum &operator--() { return *this = sub(ExtendedBigNum(1)); }
+    ExtendedBigNum operator--(int) {
+        ExtendedBigNum temp(*this);
+        --*this;
+        return temp;
+    }
+
+    // Comparison operations
+    bool is_positive() const { return m >= man_t(0.0); }
+    bool is_negative() const { return negative(m); }
+    bool is_inf() const { return Traits::isinf(m); }
+    bool is_nan() const { return Traits::isnan(m); }
+
+    std::partial_ordering operator<=>(const ExtendedBigNum &b) const {
+        if (is_nan() || b.is_nan()) {
+            return std::partial_ordering::unordered;
+        }
+        // Infinities are stored with e == 0, so order them by mantissa alone
+        if (is_inf() || b.is_inf()) {
+            return (is_inf() ? m : man_t(0.0)) <=> (b.is_inf() ? b.m : man_t(0.0));
+        }
+        if (is_positive() != b.is_positive()) {
+            return is_positive() ? std::partial_ordering::greater
+                                 : std::partial_ordering::less;
+        }
+        if (e != b.e) {
+            return is_positive() == (e > b.e) ? std::partial_ordering::greater
+                                              : std::partial_ordering::less;
+        }
+        return m <=> b.m;
+    }
+    bool operator==(const ExtendedBigNum &other) const {
+        return m == other.m && e == other.e;
+    }
+
+    // Conversion methods, with the same layout as BigNum's: integers up to
+    // max_digits long, scientific notation truncated to print_precision
+    // digits above that, and fractions truncated to print_precision digits
+
+    static unsigned int max_chars(const BigNumContext &ctx) {
+        return std::max(ctx.print_precision, ctx.max_digits) + 32;
+    }
+
+    std::to_chars_result to_chars(char *first, char *last,
+                                  const BigNumContext &ctx) const {
+        auto result = to_chars_point(first, last, ctx);
+        if (result.ec == std::errc() && ctx.decimal_separator != '.') {
+            std::replace(first, result.ptr, '.', ctx.decimal_separator);
+        }
+        return result;
+    }
+    std::to_chars_result to_chars(
+        char *first, char *last,
+        const unsigned int &precision = DefaultBigNumContext.print_precision) const {
+        return to_chars(first, last, with_precision(precision));
+    }
+
+    std::string to_string(const BigNumContext &ctx) const {
+        std::string str(max_chars(ctx), '\0');
+        auto result = to_chars(str.data(), str.data() + str.size(), ctx);
+        str.resize(result.ptr - str.data());
+        return str;
+    }
+    std::string to_string(
+        const unsigned int &precision = DefaultBigNumContext.print_precision) const {
+        return to_string(with_precision(precision));
+    }
+
+    // Pretty string: 1234567 -> 1,234,567
+    std::to_chars_result to_pretty_chars(char *first, char *last,
+                                         const BigNumContext &ctx) const {
+        auto result = to_chars(first, last, ctx);
+        if (result.ec != std::errc()) {
+            return result;
+        }
+        std::string_view str(first, result.ptr);
+        if (str.contains('e') || str.contains(ctx.decimal_separator) ||
+            str.length() < 4) {
+            return result;
+        }
+        const size_t first_digit = str[0] == '-' ? 1 : 0;
+        const size_t separators = (str.length() - first_digit - 1) / 3;
+        if (static_cast<size_t>(last - result.ptr) < separators) {
+            return {last, std::errc::value_too_large};
+        }
+        char *src = result.ptr;
+        char *dst = result.ptr + separators;
+        for (size_t i = 0; i < separators; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                *--dst = *--src;
+            }
+            *--dst = ctx.thousands_separator;
+        }
+        return {result.ptr + separators, std::errc()};
+    }
+    std::to_chars_result to_pretty_chars(
+        char *first, char *last,
+        const unsigned int &precision = DefaultBigNumContext.print_precision) const {
+        return to_pretty_chars(first, last, with_precision(precision));
+    }
+
+    std::string to_pretty_string(const BigNumContext &ctx) const {
+        std::string str(max_chars(ctx) * 4 / 3, '\0');
+        auto result = to_pretty_chars(str.data(), str.data() + str.size(), ctx);
+        str.resize(result.ptr - str.data());
+        return str;
+    }
+    std::string to_pretty_string(
+        const unsigned int &precision = DefaultBigNumContext.print_precision) const {
+        return to_pretty_string(with_precision(precision));
+    }
+
+    // Round-trips every significant digit, e.g. for audit logs
+    std::string serialize() const { return to_string(serial_context()); }
+    static ExtendedBigNum deserialize(const std::string_view &str) {
+        ExtendedBigNum value;
+        const char *last = str.data() + str.size();
+        auto [ptr, ec] = from_chars(str.data(), last, value, serial_context());
+        if (ec != std::errc() || ptr != last) {
+            if constexpr (USE_EXCEPTIONS) {
+                BIGNUM_FATAL(std::invalid_argument("Failed to parse number: " + std::string(str)));
+            } else {
+                return nan();
+            }
+        }
+        return value;
+    }
+
+    /* Parses the same syntax as BigNum::from_chars(), keeping the first
+     * DIGITS significant digits, rounded half up on the next one
+     * Never throws or allocates
+     */
+    static std::from_chars_result
+    from_chars(const char *first, const char *last, ExtendedBigNum &value,
+               const BigNumContext &ctx = DefaultBigNumContext) noexcept {
+        auto is_digit = [](char c) { return c >= '0' && c <= '9'; };
+        const char *it = first;
+        const bool minus = it != last && *it == '-';
+        if (minus) {
+            ++it;
+        }
+
+        // Special values
+        if (it != last && (*it == 'i' || *it == 'I' || *it == 'n' || *it == 'N')) {
+            double special;
+            auto result = std::from_chars(first, last, special);
+            if (result.ec == std::errc()) {
+                value = ExtendedBigNum(man_t(special), 0, false);
+            }
+            return result;
+        }
+
+        // Integer part, optionally grouped by thousands separators
+        const char *int_begin = it;
+        size_t int_digits = 0;
+        for (; it != last && is_digit(*it); ++it) {
+            ++int_digits;
+        }
+        while (int_digits > 0 && last - it >= 4 && *it == ctx.thousands_separator &&
+               is_digit(it[1]) && is_digit(it[2]) && is_digit(it[3]) &&
+               (last - it == 4 || !is_digit(it[4]))) {
+            int_digits += 3;
+            it += 4;
+        }
+        const char *int_end = it;
+
+        // Fraction part
+        const char *frac_begin = it;
+        size_t frac_digits = 0;
+        if (it != last && *it == ctx.decimal_separator &&
+            (int_digits > 0 || (last - it >= 2 && is_digit(it[1])))) {
+            frac_begin = ++it;
+            for (; it != last && is_digit(*it); ++it) {
+                ++frac_digits;
+            }
+        }
+        if (int_digits == 0 && frac_digits == 0) {
+            return {first, std::errc::invalid_argument};
+        }
+        const char *frac_end = it;
+
+        exp_t exponent = 0;
+        if (last - it >= 2 && (*it == 'e' || *it == 'E') && is_digit(it[1])) {
+            auto result = std::from_chars(it + 1, last, exponent);
+            if (result.ec != std::errc()) {
+                return result;
+            }
+            it = result.ptr;
+        }
+
+        // Accumulate the significant digits into an integer, exact in the
+        // mantissa type. shift counts dropped integer digits, scale the
+        // fraction digits that were kept
+        man_t digits(0.0);
+        int kept = 0;
+        bool round_up = false;
+        exp_t shift = 0;
+        exp_t scale = 0;
+        auto take = [&](char c, bool fraction) {
+            if (kept == 0 && c == '0') {
+                scale += fraction; // leading zero
+            } else if (kept < DIGITS) {
+                digits = digits * man_t(10.0) + man_t(static_cast<double>(c - '0'));
+                ++kept;
+                scale += fraction;
+            } else {
+                round_up = round_up || (kept == DIGITS && c >= '5');
+                kept = DIGITS + 1; // only the first dropped digit rounds
+                shift += !fraction;
+            }
+        };
+        for (const char *p = int_begin; p != int_end; ++p) {
+            if (is_digit(*p)) {
+                take(*p, false);
+            }
+        }
+        for (const char *p = frac_begin; p != frac_end; ++p) {
+            take(*p, true);
+        }
+        if (round_up) {
+            digits = digits + man_t(1.0);
+        }
+
+        if (exponent > MAX_E - shift) {
+            return {it, std::errc::result_out_of_range};
+        }
+        ExtendedBigNum v(digits, 0);
+        const exp_t up = exponent + shift;
+        if (v.e > MAX_E - up) {
+            return {it, std::errc::result_out_of_range};
+        }
+        if (v.e + up >= scale) {
+            v = ExtendedBigNum(v.m, v.e + up - scale);
+        } else {
+            const exp_t down = scale - (v.e + up);
+            v = down > 2 * static_cast<exp_t>(Pow10TableOffset)
+                    ? ExtendedBigNum()
+                    : ExtendedBigNum(scale_down(v.m, down), 0);
+        }
+        value = minus ? v.negate() : v;
+        return {it, std::errc()};
+    }
+};
+
+template <typename Mantissa>
+std::ostream &operator<<(std::ostream &os, const ExtendedBigNum<Mantissa> &bn) {
+    os << bn.to_string();
+    return os;
+}
+
+using BigNumDD = ExtendedBigNum<DoubleDouble>;
+using BigNumLD = ExtendedBigNum<long double>;
+
+static_assert(std::regular<BigNumDD>);
+static_assert(std::totally_ordered<BigNumDD>);
+
+} // namespace BigNumber
+
+using BigNumber::BigNumDD;
+using BigNumber::BigNumLD;
+using BigNumber::DoubleDouble;
+using BigNumber::ExtendedBigNum;
+
+#ifdef __cpp_lib_format
+// Same format specifiers as BigNum
+template <typename Mantissa>
+struct std::formatter<BigNumber::ExtendedBigNum<Mantissa>, char>
+    : std::formatter<BigNumber::BigNum, char> {
+    template <typename FormatContext>
+    auto format(const BigNumber::ExtendedBigNum<Mantissa> &bn, FormatContext &ctx) const {
+        BigNumber::BigNumContext bctx = BigNumber::DefaultBigNumContext;
+        if (has_precision) {
+            bctx.print_precision = precision;
+        }
+        const std::string text = pretty ? bn.to_pretty_string(bctx) : bn.to_string(bctx);
+        size_t padding = width > text.size() ? width - text.size() : 0;
+        size_t before = align == '<' ? 0 : align == '^' ? padding / 2 : padding;
+        auto out = std::fill_n(ctx.out(), before, fill);
+        out = std::copy(text.begin(), text.end(), out);
+        return std::fill_n(out, padding - before, fill);
+    }
+};
+#endif // __cpp_lib_format
@@ -0,0 +1,160 @@
+/*
+BigNumExpr: expression templates that evaluate a whole BigNum expression with
+a single normalization
+lazy(a) * b + lazy(c) * d - e builds a tree of operations instead of one
+normalized BigNum per operator. The tree is evaluated when it is converted to a
+BigNum, on assignment or by eval(): every node is computed with
+UnnormalizedBigNum arithmetic, so each addition aligns exponents once and only
+the result is normalized. total += lazy(a) * b folds total into the same pass
+
+Scalar operands are folded in as raw mantissas instead of being constructed and
+normalized as BigNums, so fractional factors such as 2.5 are applied exactly
+rather than rounded onto BigNum's integer grid. Scalars past the drift window
+of UnnormalizedBigNum are split into mantissa and exponent like its results.
+String operands are parsed when the expression is built. Operands are held by
+value, so an expression can be stored and evaluated after its operands are gone
+
+Results can differ from the eager expression in the last digits, since
+intermediate values are not rounded
+*/
+
+#pragma once
+
+#include <concepts>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+
+#include "BigNum.hpp"
+
+namespace BigNumber {
+
+template <typename Node> class BigNumExpr;
+
+namespace detail {
+
+// A BigNum, an UnnormalizedBigNum or a scalar mantissa
+template <typename T> struct ExprLeaf {
+    T value;
+    MAYBE_CONSTEXPR UnnormalizedBigNum eval() const { return UnnormalizedBigNum(value); }
+};
+
+// Op is std::plus<>, std::minus<>, std::multiplies<> or std::divides<>
+template <typename Op, typename L, typename R> struct ExprBinary {
+    L lhs;
+    R rhs;
+    MAYBE_CONSTEXPR UnnormalizedBigNum eval() const {
+        return Op{}(lhs.eval(), rhs.eval());
+    }
+};
+
+template <typename E> struct ExprNegate {
+    E operand;
+    MAYBE_CONSTEXPR UnnormalizedBigNum eval() const { return operand.eval().negate(); }
+};
+
+template <typename T> struct is_expr : std::false_type {};
+template <typename Node> struct is_expr<BigNumExpr<Node>> : std::true_type {};
+
+template <typename T>
+concept ExprOperand = is_expr<T>::value || std::same_as<T, BigNum> ||
+                      std::same_as<T, UnnormalizedBigNum> || std::is_arithmetic_v<T> ||
+                      std::is_convertible_v<const T &, std::string_view>;
+
+// At least one side must already be an expression, so that plain BigNum
+// operators keep their eager meaning
+template <typename A, typename B>
+concept ExprOperands =
+    (is_expr<A>::value || is_expr<B>::value) && ExprOperand<A> && ExprOperand<B>;
+
+// The node an operand contributes to the tree
+template <typename T> MAYBE_CONSTEXPR auto expr_node(const T &operand) {
+    if constexpr (is_expr<T>::value) {
+        return operand.node();
+    } else if constexpr (std::same_as<T, BigNum> || std::same_as<T, UnnormalizedBigNum>) {
+        return ExprLeaf<T>{operand};
+    } else if constexpr (std::is_arithmetic_v<T>) {
+        using man_t = UnnormalizedBigNum::man_t;
+        return ExprLeaf<man_t>{static_cast<man_t>(operand)};
+    } else {
+        return ExprLeaf<BigNum>{BigNum(std::string_view(operand))};
+    }
+}
+
+template <typename Op, typename A, typename B>
+MAYBE_CONSTEXPR auto make_expr(const A &a, const B &b) {
+    using Node = ExprBinary<Op, decltype(expr_node(a)), decltype(expr_node(b))>;
+    return BigNumExpr<Node>(Node{expr_node(a), expr_node(b)});
+}
+
+} // namespace detail
+
+template <typename Node> class BigNumExpr {
+  private:
+    Node tree;
+
+  public:
+    MAYBE_CONSTEXPR explicit BigNumExpr(const Node &node) : tree(node) {}
+
+    MAYBE_CONSTEXPR const Node &node() const { return tree; }
+
+    // Evaluates the whole tree, normalizing once
+    MAYBE_CONSTEXPR BigNum eval() const { return tree.eval().normalized(); }
+    MAYBE_CONSTEXPR operator BigNum() const { return eval(); }
+};
+
+// Starts an expression, e.g. BigNum r = lazy(a) * b + lazy(c) * d - e
+inline MAYBE_CONSTEXPR BigNumExpr<detail::ExprLeaf<BigNum>> lazy(const BigNum &value) {
+    return BigNumExpr(detail::ExprLeaf<BigNum>{value});
+}
+inline MAYBE_CONSTEXPR BigNumExpr<detail::ExprLeaf<UnnormalizedBigNum>>
+lazy(const UnnormalizedBigNum &value) {
+    return BigNumExpr(detail::ExprLeaf<UnnormalizedBigNum>{value});
+}
+
+template <typename A, typename B>
+    requires detail::ExprOperands<A, B>
+MAYBE_CONSTEXPR auto operator+(const A &a, const B &b) {
+    return detail::make_expr<std::plus<>>(a, b);
+}
+template <typename A, typename B>
+    requires detail::ExprOperands<A, B>
+MAYBE_CONSTEXPR auto operator-(const A &a, const B &b) {
+    return detail::make_expr<std::minus<>>(a, b);
+}
+template <typename A, typename B>
+    requires detail::ExprOperands<A, B>
+MAYBE_CONSTEXPR auto operator*(const A &a, const B &b) {
+    return detail::make_expr<std::multiplies<>>(a, b);
+}
+template <typename A, typename B>
+    requires detail::ExprOperands<A, B>
+MAYBE_CONSTEXPR auto operator/(const A &a, const B &b) {
+    return detail::make_expr<std::divides<>>(a, b);
+}
+template <typename Node>
+MAYBE_CONSTEXPR BigNumExpr<detail::ExprNegate<Node>> operator-(const BigNumExpr<Node> &a) {
+    return BigNumExpr(detail::ExprNegate<Node>{a.node()});
+}
+
+// Compound assignment evaluates lhs op expression in one pass
+template <typename Node>
+MAYBE_CONSTEXPR BigNum &operator+=(BigNum &lhs, const BigNumExpr<Node> &rhs) {
+    return lhs = (lazy(lhs) + rhs).eval();
+}
+template <typename Node>
+MAYBE_CONSTEXPR BigNum &operator-=(BigNum &lhs, const BigNumExpr<Node> &rhs) {
+    return lhs = (lazy(lhs) - rhs).eval();
+}
+template <typename Node>
+MAYBE_CONSTEXPR BigNum &operator*=(BigNum &lhs, const BigNumExpr<Node> &rhs) {
+    return lhs = (lazy(lhs) * rhs).eval();
+}
+template <typename Node>
+MAYBE_CONSTEXPR BigNum &operator/=(BigNum &lhs, const BigNumExpr<Node> &rhs) {
+    return lhs = (lazy(lhs) / rhs).eval();
+}
+
+} // namespace BigNumber
+
+using BigNumber::BigNumExpr;
@@ -0,0 +1,154 @@
+/*
+BigNumGenerators: closed-form offline progress for chained generator tiers
+Tier k produces tier k - 1 at rate r_k per unit per second, as in Antimatter
+Dimensions, and tier 0 is the resource itself. With constant rates the system
+is a nilpotent linear ODE, so after t seconds each tier is a polynomial in t:
+
+    a_j(t) = sum over k >= j of a_k(0) * r_{j+1} * ... * r_k * t^(k-j) / (k-j)!
+
+This is the limit of simulating infinitely small ticks, at O(tiers^2) BigNum
+operations per player no matter how long they were away
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "BigNum.hpp"
+
+namespace BigNumber {
+
+class GeneratorChain {
+  private:
+    std::size_t n = 1;
+    /* Coefficients r_{j+1} * ... * r_k / (k-j)! at [j * n + k], k > j, as
+     * log10 of the magnitude and a sign (0 once a rate is zero). Terms are
+     * built as a_k * 10^(log + (k-j) * log10(t)) directly, which never rounds
+     * intermediate values onto BigNum's integer grid below 1e17
+     */
+    std::vector<double> log_coef;
+    std::vector<signed char> sign;
+    bool finite_rates = true; // only false with BIGNUM_NO_EXCEPTIONS
+
+    void advance_one(std::span<BigNum> amounts, double seconds) const {
+        if (!(seconds >= 0)) {
+            if constexpr (USE_EXCEPTIONS) {
+                BIGNUM_FATAL(std::domain_error("Elapsed time must not be negative"));
+            } else {
+                std::ranges::fill(amounts, BigNum::nan());
+                return;
+            }
+        }
+        if (!finite_rates) {
+            std::ranges::fill(amounts, BigNum::nan());
+            return;
+        }
+        if (seconds == 0) {
+            return;
+        }
+        const double log_t = std::log10(seconds);
+
+        // Lower tiers first: a_j only reads a_k for k > j, still at time 0
+        for (std::size_t j = 0; j < n; ++j) {
+            BigNumAccumulator sum(amounts[j]);
+            for (std::size_t k = j + 1; k < n; ++k) {
+                const int s = sign[j * n + k];
+                if (s == 0 || amounts[k].getM() == 0) {
+                    continue;
+                }
+                const double log = log_coef[j * n + k] +
+                                   static_cast<double>(k - j) * log_t;
+                // Out of the fused range the term is either negligible or
+                // saturates
+                const BigNum beyond = log < 0                   ? BigNum()
+                                      : amounts[k].getM() > 0 ? BigNum::max()
+                                                              : BigNum::min();
+                const BigNum term = amounts[k].mul_pow10(log).value_or(beyond);
+                sum += s > 0 ? term : -term;
+            }
+            amounts[j] = sum.value();
+        }
+    }
+
+    // rate(i) returns (log10 |r|, sign of r) for the rate into tier i
+    template <typename Rate> void init(Rate &&rate) {
+        for (std::size_t j = 0; j < n; ++j) {
+            double log = 0;
+            int s = 1;
+            for (std::size_t k = j + 1; k < n; ++k) {
+                const auto [log_r, sign_r] = rate(k - 1);
+                s *= sign_r;
+                if (s != 0) {
+                    log += log_r - std::log10(static_cast<double>(k - j));
+                }
+                log_coef[j * n + k] = log;
+                sign[j * n + k] = static_cast<signed char>(s);
+            }
+        }
+    }
+
+  public:
+    // rates[k] is what one unit of tier k + 1 produces of tier k per second,
+    // so the chain has rates.size() + 1 tiers
+    explicit GeneratorChain(std::span<const BigNum> rates)
+        : n(rates.size() + 1), log_coef(n * n), sign(n * n),
+          finite_rates(std::ranges::none_of(
+              rates, [](const BigNum &r) { return r.is_nan() || r.is_inf(); })) {
+        if (!finite_rates) {
+            if constexpr (USE_EXCEPTIONS) {
+                BIGNUM_FATAL(std::invalid_argument("Generator rates must be finite"));
+            }
+        } else {
+            init([&](std::size_t i) {
+                const BigNum &r = rates[i];
+                const int s = r.getM() > 0 ? 1 : r.getM() < 0 ? -1 : 0;
+                return std::pair(s != 0 ? *r.abs().log10() : 0.0, s);
+            });
+        }
+    }
+    // Rates as doubles, for fractional rates such as 1.5 that BigNum would
+    // round onto its integer grid
+    explicit GeneratorChain(std::span<const double> rates)
+        : n(rates.size() + 1), log_coef(n * n), sign(n * n),
+          finite_rates(std::ranges::all_of(rates, [](double r) { return std::isfinite(r); })) {
+        if (!finite_rates) {
+            if constexpr (USE_EXCEPTIONS) {
+                BIGNUM_FATAL(std::invalid_argument("Generator rates must be finite"));
+            }
+        } else {
+            init([&](std::size_t i) {
+                const double r = rates[i];
+                const int s = r > 0 ? 1 : r < 0 ? -1 : 0;
+                return std::pair(s != 0 ? std::log10(std::abs(r)) : 0.0, s);
+            });
+        }
+    }
+
+    std::size_t tiers() const { return n; }
+
+    // Advances one player: amounts[k] is the amount of tier k
+    void advance(std::span<BigNum> amounts, double seconds) const {
+        assert(amounts.size() == n && "One amount per tier");
+        advance_one(amounts, seconds);
+    }
+
+    // Advances a batch of players with the same rates. amounts holds
+    // seconds.size() consecutive groups of tiers() values, one per player
+    void advance(std::span<BigNum> amounts, std::span<const double> seconds) const {
+        assert(amounts.size() == n * seconds.size() && "One amount per tier");
+        for (std::size_t p = 0; p < seconds.size(); ++p) {
+            advance_one(amounts.subspan(p * n, n), seconds[p]);
+        }
+    }
+};
+
+} // namespace BigNumber
+
+using BigNumber::GeneratorChain;
@@ -0,0 +1,301 @@
+/*
+BigNumLeaderboard: scores keyed by player id, with rank queries
+Entries are kept ordered in a treap whose nodes count their subtree, so
+insert, erase, update, rank(id) and at_rank(r) all take O(log n) expected
+time, and range(first, last) O(log n + last - first). Rank 0 is the highest
+score; equal scores are ordered by ascending id, so every entry has exactly
+one rank
+
+Scores are compared by BigNum::sort_key(), i.e. like operator<=>, with 0 and
+-0 tied. NaN has no place in that order, so the NaNPolicy decides: Reject
+makes insert() and update() refuse NaN scores, Last ranks them below -inf
+
+Readers share a lock and writers take it exclusively, so any number of
+threads can query while updates are applied one at a time
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "BigNum.hpp"
+
+namespace BigNumber {
+
+template <typename Id = std::uint64_t> class BigNumLeaderboard {
+  public:
+    enum class NaNPolicy { Reject, Last };
+
+    struct Entry {
+        Id id;
+        BigNum score;
+    };
+
+  private:
+    static inline constexpr std::size_t NIL = static_cast<std::size_t>(-1);
+
+    // Position in the ranking: NaN last, then descending score, then id
+    struct Key {
+        bool nan;
+        BigNum::SortKey order; // complement of the score's sort key
+        Id id;
+    };
+
+    struct Node {
+        Key key;
+        BigNum score;
+        std::uint64_t priority;
+        std::size_t left = NIL;
+        std::size_t right = NIL;
+        std::size_t size = 1;
+    };
+
+    NaNPolicy nan_policy;
+    std::vector<Node> nodes;
+    std::vector<std::size_t> free_nodes;
+    std::unordered_map<Id, std::size_t> index;
+    std::size_t root = NIL;
+    std::mt19937_64 rng;
+    mutable std::shared_mutex lock;
+
+    static Key make_key(const Id &id, const BigNum &score) {
+        const BigNum::SortKey k = score.sort_key();
+        return {score.is_nan(), {~k.hi, ~k.lo}, id};
+    }
+
+    // Compares the score part only, so that ties can be counted
+    static bool score_before(const Key &a, const Key &b) {
+        return a.nan != b.nan ? b.nan : a.order < b.order;
+    }
+    static bool before(const Key &a, const Key &b) {
+        if (score_before(a, b) || score_before(b, a)) {
+            return score_before(a, b);
+        }
+        return a.id < b.id;
+    }
+
+    std::size_t count(std::size_t t) const { return t == NIL ? 0 : nodes[t].size; }
+    void pull(std::size_t t) {
+        nodes[t].size = 1 + count(nodes[t].left) + count(nodes[t].right);
+    }
+
+    // Splits t into the nodes before key and the rest
+    std::pair<std::size_t, std::size_t> split(std::size_t t, const Key &key) {
+        if (t == NIL) {
+            return {NIL, NIL};
+        }
+        if (before(nodes[t].key, key)) {
+            auto [l, r] = split(nodes[t].right, key);
+            nodes[t].right = l;
+            pull(t);
+            return {t, r};
+        }
+        auto [l, r] = split(nodes[t].left, key);
+        nodes[t].left = r;
+        pull(t);
+        return {l, t};
+    }
+
+    // Joins two treaps where every key of a comes before every key of b
+    std::size_t merge(std::size_t a, std::size_t b) {
+        if (a == NIL || b == NIL) {
+            return a == NIL ? b : a;
+        }
+        if (nodes[a].priority > nodes[b].priority) {
+            nodes[a].right = merge(nodes[a].right, b);
+            pull(a);
+            return a;
+        }
+        nodes[b].left = merge(a, nodes[b].left);
+        pull(b);
+        return b;
+    }
+
+    std::size_t erase_at(std::size_t t, const Key &key) {
+        if (before(key, nodes[t].key)) {
+            nodes[t].left = erase_at(nodes[t].left, key);
+        } else if (before(nodes[t].key, key)) {
+            nodes[t].right = erase_at(nodes[t].right, key);
+        } else {
+            free_nodes.push_back(t);
+            return merge(nodes[t].left, nodes[t].right);
+        }
+        pull(t);
+        return t;
+    }
+
+    void insert_new(const Id &id, const BigNum &score) {
+        std::size_t t;
+        if (free_nodes.empty()) {
+            t = nodes.size();
+            nodes.emplace_back();
+        } else {
+            t = free_nodes.back();
+            free_nodes.pop_back();
+        }
+        nodes[t] = Node{make_key(id, score), score, rng()};
+        auto [l, r] = split(root, nodes[t].key);
+        root = merge(merge(l, t), r);
+        index[id] = t;
+    }
+
+    // Number of entries whose key comes before key, under the given order
+    template <typename Before>
+    std::size_t count_before(const Key &key, Before &&precedes) const {
+        std::size_t n = 0;
+        for (std::size_t t = root; t != NIL;) {
+            if (precedes(nodes[t].key, key)) {
+                n += count(nodes[t].left) + 1;
+                t = nodes[t].right;
+            } else {
+                t = nodes[t].left;
+            }
+        }
+        return n;
+    }
+
+    // Appends the entries of subtree t with ranks in [first, last), where
+    // base is the rank of the subtree's first entry
+    void collect(std::size_t t, std::size_t base, std::size_t first,
+                 std::size_t last, std::vector<Entry> &out) const {
+        if (t == NIL || base >= last || base + nodes[t].size <= first) {
+            return;
+        }
+        const std::size_t self = base + count(nodes[t].left);
+        collect(nodes[t].left, base, first, last, out);
+        if (self >= first && self < last) {
+            out.push_back({nodes[t].key.id, nodes[t].score});
+        }
+        collect(nodes[t].right, self + 1, first, last, out);
+    }
+
+  public:
+    explicit BigNumLeaderboard(NaNPolicy policy = NaNPolicy::Reject,
+                               std::uint64_t seed = 0x9E3779B97F4A7C15)
+        : nan_policy(policy), rng(seed) {}
+    BigNumLeaderboard(const BigNumLeaderboard &) = delete;
+    BigNumLeaderboard &operator=(const BigNumLeaderboard &) = delete;
+
+    // Returns false if id is already present or score is a rejected NaN
+    bool insert(const Id &id, const BigNum &score) {
+        if (score.is_nan() && nan_policy == NaNPolicy::Reject) {
+            return false;
+        }
+        std::unique_lock guard(lock);
+        if (index.contains(id)) {
+            return false;
+        }
+        insert_new(id, score);
+        return true;
+    }
+
+    // Sets the score of id, inserting it if absent. Returns false, leaving
+    // the entry unchanged, if score is a rejected NaN
+    bool update(const Id &id, const BigNum &score) {
+        if (score.is_nan() && nan_policy == NaNPolicy::Reject) {
+            return false;
+        }
+        std::unique_lock guard(lock);
+        if (auto it = index.find(id); it != index.end()) {
+            root = erase_at(root, nodes[it->second].key);
+        }
+        insert_new(id, score);
+        return true;
+    }
+
+    bool erase(const Id &id) {
+        std::unique_lock guard(lock);
+        auto it = index.find(id);
+        if (it == index.end()) {
+            return false;
+        }
+        root = erase_at(root, nodes[it->second].key);
+        index.erase(it);
+        return true;
+    }
+
+    void clear() {
+        std::unique_lock guard(lock);
+        nodes.clear();
+        free_nodes.clear();
+        index.clear();
+        root = NIL;
+    }
+
+    std::size_t size() const {
+        std::shared_lock guard(lock);
+        return index.size();
+    }
+
+    std::optional<BigNum> score(const Id &id) const {
+        std::shared_lock guard(lock);
+        auto it = index.find(id);
+        if (it == index.end()) {
+            return std::nullopt;
+        }
+        return nodes[it->second].score;
+    }
+
+    // 0-based rank of id, or std::nullopt if absent
+    std::optional<std::size_t> rank(const Id &id) const {
+        std::shared_lock guard(lock);
+        auto it = index.find(id);
+        if (it == index.end()) {
+            return std::nullopt;
+        }
+        return count_before(nodes[it->second].key,
+                            [](const Key &a, const Key &b) { return before(a, b); });
+    }
+
+    // Number of entries with a strictly better score, i.e. the rank a new
+    // entry with this score would tie at
+    std::size_t rank_of(const BigNum &score) const {
+        std::shared_lock guard(lock);
+        return count_before(make_key(Id(), score), [](const Key &a, const Key &b) {
+            return score_before(a, b);
+        });
+    }
+
+    // Entry at rank r, or std::nullopt if r >= size()
+    std::optional<Entry> at_rank(std::size_t r) const {
+        std::shared_lock guard(lock);
+        for (std::size_t t = root; t != NIL;) {
+            const std::size_t left = count(nodes[t].left);
+            if (r < left) {
+                t = nodes[t].left;
+            } else if (r == left) {
+                return Entry{nodes[t].key.id, nodes[t].score};
+            } else {
+                r -= left + 1;
+                t = nodes[t].right;
+            }
+        }
+        return std::nullopt;
+    }
+
+    // Entries with ranks in [first, last), best first
+    std::vector<Entry> range(std::size_t first, std::size_t last) const {
+        std::shared_lock guard(lock);
+        std::vector<Entry> out;
+        if (first < last) {
+            out.reserve(std::min(last, count(root)) - std::min(first, count(root)));
+            collect(root, 0, first, last, out);
+        }
+        return out;
+    }
+
+    std::vector<Entry> top(std::size_t n) const { return range(0, n); }
+};
+
+} // namespace BigNumber
+
+using BigNumber::BigNumLeaderboard;
@@ -0,0 +1,236 @@
+/*
+BigNumNotation: suffix notations for display, e.g. "1.23 Qa" or "4.56 ab"
+    ShortScale   K, M, B, T, Qa, Qi, Sx, Sp, Oc, No, Dc, UDc, ..., Vg, ..., Ce
+    LongScale    K, M, Md, B, Bd, T, Td, ...: -illiards take a 'd'
+    Engineering  12.34e6: the exponent is a multiple of 3
+    Letters      K, M, B, T, then aa, ab, ..., zz, aaa, ...
+Values from 1000 up are written as mantissa in [1, 1000), with
+ctx.print_precision fractional digits rounded down, then the suffix of the
+power of 1000. Smaller values, inf and nan are written like BigNum::to_chars(),
+and so are values past the -illion tables (1e3003 for short scale, 1e6000 for
+long scale)
+
+Suffixes come from tables built at compile time, so to_notation_chars() writes
+the text in one pass without allocating
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include "BigNum.hpp"
+
+namespace BigNumber {
+
+enum class Notation { ShortScale, LongScale, Engineering, Letters };
+
+namespace detail {
+
+// K, M, B, T before the letters
+inline constexpr std::string_view LETTER_PREFIXES[] = {"", "K", "M", "B", "T"};
+
+// Letters past T: the length of the suffix of 1000^group, and the index of
+// group among the suffixes of that length. Two letters for the first 26^2
+// groups, then three, and so on
+struct LetterIndex {
+    std::size_t length;
+    std::uint64_t k;
+};
+constexpr LetterIndex letter_index(std::uint64_t group) {
+    std::uint64_t k = group - std::size(LETTER_PREFIXES);
+    std::size_t length = 2;
+    for (std::uint64_t count = 26 * 26; k >= count; count *= 26) {
+        k -= count;
+        ++length;
+        if (count > UINT64_MAX / 26) {
+            break; // k is now below the next count, which is past 2^64
+        }
+    }
+    return {length, k};
+}
+
+// The largest group is that of the largest exponent
+inline constexpr std::size_t MAX_SUFFIX_LENGTH =
+    letter_index(std::numeric_limits<decltype(BigNum().getE())>::max() / 3).length;
+
+struct NotationSuffix {
+    std::array<char, MAX_SUFFIX_LENGTH> text{};
+    std::size_t size = 0;
+
+    constexpr std::string_view view() const { return {text.data(), size}; }
+    constexpr void append(std::string_view s) {
+        for (char c : s) {
+            text[size++] = c;
+        }
+    }
+};
+
+// Abbreviation of the n-th -illion, i.e. of 10^(3n + 3) in short scale
+inline constexpr std::size_t ILLION_COUNT = 1000;
+inline constexpr auto ILLION_SUFFIXES = [] {
+    constexpr std::string_view first[] = {"",   "M",  "B",  "T",  "Qa",
+                                          "Qi", "Sx", "Sp", "Oc", "No"};
+    constexpr std::string_view units[] = {"",   "U",  "D",  "T",  "Qa",
+                                          "Qi", "Sx", "Sp", "Oc", "No"};
+    constexpr std::string_view tens[] = {"",    "Dc",  "Vg",  "Tg",  "Qag",
+                                         "Qig", "Sxg", "Spg", "Ocg", "Nog"};
+    constexpr std::string_view hundreds[] = {"",     "Ce",   "DCe",  "TCe",  "QaCe",
+                                             "QiCe", "SxCe", "SpCe", "OcCe", "NoCe"};
+    std::array<NotationSuffix, ILLION_COUNT> table{};
+    for (std::size_t n = 1; n < ILLION_COUNT; ++n) {
+        if (n < 10) {
+            table[n].append(first[n]);
+        } else {
+            table[n].append(units[n % 10]);
+            table[n].append(tens[n / 10 % 10]);
+            table[n].append(hundreds[n / 100]);
+        }
+    }
+    return table;
+}();
+static_assert(std::ranges::max(ILLION_SUFFIXES, {}, &NotationSuffix::size).size <
+                  MAX_SUFFIX_LENGTH,
+              "no room for the long scale 'd' after an -illion suffix");
+
+// Writes the suffix of 1000^group, or returns false if the notation has none
+inline bool write_suffix(NotationSuffix &suffix, Notation notation,
+                         std::uint64_t group) {
+    if (group == 1 && notation != Notation::Letters) {
+        suffix.append("K");
+        return true;
+    }
+    switch (notation) {
+    case Notation::ShortScale:
+        if (group - 1 >= ILLION_COUNT) {
+            return false;
+        }
+        suffix = ILLION_SUFFIXES[group - 1];
+        return true;
+    case Notation::LongScale:
+        if (group / 2 >= ILLION_COUNT) {
+            return false;
+        }
+        suffix = ILLION_SUFFIXES[group / 2];
+        if (group % 2 != 0) {
+            suffix.append("d");
+        }
+        return true;
+    case Notation::Letters: {
+        if (group < std::size(LETTER_PREFIXES)) {
+            suffix.append(LETTER_PREFIXES[group]);
+            return true;
+        }
+        auto [length, k] = letter_index(group);
+        suffix.size = length;
+        for (std::size_t i = length; i-- > 0; k /= 26) {
+            suffix.text[i] = static_cast<char>('a' + k % 26);
+        }
+        return true;
+    }
+    case Notation::Engineering:
+        break;
+    }
+    return false;
+}
+
+} // namespace detail
+
+// Upper bound for the length of to_notation_chars() output with this context
+inline unsigned int max_notation_chars(const BigNumContext &ctx = DefaultBigNumContext) {
+    return BigNum::max_chars(ctx) + 24;
+}
+
+// Writes value in the given notation into [first, last) without allocating.
+// Returns {end of text, std::errc()} on success, or
+// {last, std::errc::value_too_large} if the buffer is too small
+inline std::to_chars_result
+to_notation_chars(char *first, char *last, const BigNum &value, Notation notation,
+                  const BigNumContext &ctx = DefaultBigNumContext) {
+    const std::uint64_t group = value.getE() / 3;
+    const unsigned int precision = ctx.print_precision;
+    detail::NotationSuffix suffix;
+    if (group == 0 || value.is_inf() || value.is_nan() ||
+        precision > static_cast<unsigned int>(Pow10TableOffset) ||
+        (notation != Notation::Engineering &&
+         !detail::write_suffix(suffix, notation, group))) {
+        return value.to_chars(first, last, ctx);
+    }
+
+    // Mantissa scaled into [1, 1000), rounded down to the precision. The few
+    // ulps of slack keep 4.56 from showing as 4.55 when 456 is not exact, as
+    // long as they do not carry into another digit
+    const int shift = static_cast<int>(value.getE() % 3);
+    const double scale = *Pow10::get(static_cast<int>(precision));
+    const double scaled = value.getM() * *Pow10::get(shift);
+    double digits =
+        std::trunc(scaled * scale * (1.0 + 8 * std::numeric_limits<double>::epsilon()));
+    if (std::abs(digits) >= *Pow10::get(shift + 1) * scale) {
+        digits = std::trunc(scaled * scale);
+    }
+    const double truncated = digits / scale;
+    auto result = std::to_chars(first, last, truncated, std::chars_format::fixed,
+                                static_cast<int>(precision));
+    if (result.ec != std::errc()) {
+        return result;
+    }
+    char *end = result.ptr;
+    if (ctx.decimal_separator != '.') {
+        std::replace(first, end, '.', ctx.decimal_separator);
+    }
+
+    if (notation == Notation::Engineering) {
+        if (end == last) {
+            return {last, std::errc::value_too_large};
+        }
+        *end++ = 'e';
+        result = std::to_chars(end, last, value.getE() - value.getE() % 3);
+        if (result.ec != std::errc()) {
+            return {last, std::errc::value_too_large};
+        }
+        return result;
+    }
+    if (static_cast<std::size_t>(last - end) < suffix.size + 1) {
+        return {last, std::errc::value_too_large};
+    }
+    *end++ = ' ';
+    const std::string_view text = suffix.view();
+    return {std::copy(text.begin(), text.end(), end), std::errc()};
+}
+inline std::to_chars_result
+to_notation_chars(char *first, char *last, const BigNum &value, Notation notation,
+                  const unsigned int precision) {
+    BigNumContext ctx = DefaultBigNumContext;
+    ctx.print_precision = precision;
+    return to_notation_chars(first, last, value, notation, ctx);
+}
+
+inline std::string to_notation_string(const BigNum &value, Notation notation,
+                                      const BigNumContext &ctx = DefaultBigNumContext) {
+    std::string str(max_notation_chars(ctx), '\0');
+    auto [ptr, ec] = to_notation_chars(str.data(), str.data() + str.size(), value,
+                                       notation, ctx);
+    str.resize(ec == std::errc() ? ptr - str.data() : 0);
+    return str;
+}
+inline std::string to_notation_string(const BigNum &value, Notation notation,
+                                      const unsigned int precision) {
+    BigNumContext ctx = DefaultBigNumContext;
+    ctx.print_precision = precision;
+    return to_notation_string(value, notation, ctx);
+}
+
+} // namespace BigNumber
+
+using BigNumber::max_notation_chars;
+using BigNumber::Notation;
+using BigNumber::to_notation_chars;
+using BigNumber::to_notation_string;
@@ -0,0 +1,244 @@
+/*
+BigNumParallel: multithreaded reductions over large ranges of BigNums
+reduce_sum, reduce_product, reduce_min/reduce_max and argmin/argmax accept a
+std::span<const BigNum> or a BigNumArray::ConstSpan (e.g. a BigNumStore)
+
+Determinism: the input is cut into fixed-size chunks, independent of the thread
+count. Threads only decide who reduces which chunk; the partial results are
+merged in chunk order, so every thread count gives bit-identical results
+
+Sums are exponent-aware: instead of folding with add(), which drops any addend
+more than 14 orders of magnitude below the running total, each chunk scales
+its values to the largest exponent it contains and adds the mantissas with
+Neumaier compensation, and the chunk totals are merged the same way. Many small
+contributions therefore still add up, as long as together they reach the
+total's precision
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <span>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "BigNum.hpp"
+
+namespace BigNumber {
+
+namespace detail {
+
+// Fixed so that results do not depend on the number of threads
+inline constexpr std::size_t REDUCE_CHUNK = 4096;
+
+// Calls f(chunk) for every chunk of n elements, spread over the given number
+// of threads (0: one per hardware thread)
+template <typename F>
+void for_each_chunk(std::size_t n, std::size_t threads, F &&f) {
+    const std::size_t chunks = (n + REDUCE_CHUNK - 1) / REDUCE_CHUNK;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min(threads, chunks);
+    if (threads <= 1) {
+        for (std::size_t c = 0; c < chunks; ++c) {
+            f(c);
+        }
+        return;
+    }
+    std::atomic<std::size_t> next{0};
+    auto worker = [&] {
+        for (std::size_t c = next.fetch_add(1, std::memory_order_relaxed);
+             c < chunks; c = next.fetch_add(1, std::memory_order_relaxed)) {
+            f(c);
+        }
+    };
+    std::vector<std::jthread> pool;
+    pool.reserve(threads - 1);
+    for (std::size_t t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+}
+
+// Unnormalized partial sum: (m + c) * 10^e, where c is the rounding error
+// carried along by Neumaier summation, plus the sum of every inf/NaN term
+struct PartialSum {
+    double m = 0;
+    double c = 0;
+    std::uintmax_t e = 0;
+    double special = 0;
+
+    void add(double x) {
+        double t = m + x;
+        c += std::abs(m) >= std::abs(x) ? (m - t) + x : (x - t) + m;
+        m = t;
+    }
+};
+
+// Adds n terms (m, c, e) after scaling them all to the largest exponent
+template <typename At>
+PartialSum scaled_sum(std::size_t n, At &&at) {
+    PartialSum r;
+    for (std::size_t i = 0; i < n; ++i) {
+        auto [m, c, e] = at(i);
+        if (m != 0 && std::isfinite(m)) {
+            r.e = std::max(r.e, e);
+        }
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+        auto [m, c, e] = at(i);
+        if (!std::isfinite(m)) {
+            r.special += m;
+        } else if (r.e - e <= static_cast<std::uintmax_t>(Pow10TableOffset)) {
+            const double scale = *Pow10::get(-static_cast<int>(r.e - e));
+            r.add(m * scale);
+            r.add(c * scale);
+        }
+    }
+    return r;
+}
+
+// Product with the exponent saturating at max()/min() instead of wrapping
+inline BigNum saturating_mul(const BigNum &a, const BigNum &b) {
+    constexpr auto e_max = std::numeric_limits<std::uintmax_t>::max();
+    if (a.getE() != 0 && b.getE() != 0 && b.getE() >= e_max - a.getE()) {
+        return (a.getM() < 0) != (b.getM() < 0) ? BigNum::min() : BigNum::max();
+    }
+    return a * b;
+}
+
+// Index of the first element that is better than every other, skipping NaN
+template <typename View, typename Better>
+std::size_t arg_best(View values, std::size_t threads, Better better) {
+    const std::size_t n = values.size();
+    const std::size_t none = n;
+    std::vector<std::size_t> best((n + REDUCE_CHUNK - 1) / REDUCE_CHUNK, none);
+    for_each_chunk(n, threads, [&](std::size_t c) {
+        const std::size_t end = std::min(n, (c + 1) * REDUCE_CHUNK);
+        std::size_t k = none;
+        BigNum v;
+        for (std::size_t i = c * REDUCE_CHUNK; i < end; ++i) {
+            BigNum x = values[i];
+            if (!x.is_nan() && (k == none || better(x, v))) {
+                k = i;
+                v = x;
+            }
+        }
+        best[c] = k;
+    });
+    std::size_t k = none;
+    for (std::size_t c : best) {
+        if (c != none && (k == none || better(values[c], values[k]))) {
+            k = c;
+        }
+    }
+    return k;
+}
+
+template <typename View>
+BigNum reduce_sum(View values, std::size_t threads) {
+    const std::size_t n = values.size();
+    std::vector<PartialSum> partials((n + REDUCE_CHUNK - 1) / REDUCE_CHUNK);
+    for_each_chunk(n, threads, [&](std::size_t c) {
+        const std::size_t begin = c * REDUCE_CHUNK;
+        const std::size_t end = std::min(n, begin + REDUCE_CHUNK);
+        partials[c] = scaled_sum(end - begin, [&](std::size_t i) {
+            BigNum x = values[begin + i];
+            return std::tuple(x.getM(), 0.0, x.getE());
+        });
+    });
+    PartialSum total = scaled_sum(partials.size(), [&](std::size_t c) {
+        return std::tuple(partials[c].m, partials[c].c, partials[c].e);
+    });
+    for (const PartialSum &p : partials) {
+        total.special += p.special;
+    }
+    return finish_sum(total.special, total.m + total.c, total.e);
+}
+
+template <typename View>
+BigNum reduce_product(View values, std::size_t threads) {
+    const std::size_t n = values.size();
+    std::vector<BigNum> partials((n + REDUCE_CHUNK - 1) / REDUCE_CHUNK, BigNum(1.0));
+    for_each_chunk(n, threads, [&](std::size_t c) {
+        const std::size_t end = std::min(n, (c + 1) * REDUCE_CHUNK);
+        BigNum p(1.0);
+        for (std::size_t i = c * REDUCE_CHUNK; i < end; ++i) {
+            p = saturating_mul(p, values[i]);
+        }
+        partials[c] = p;
+    });
+    BigNum p(1.0);
+    for (const BigNum &x : partials) {
+        p = saturating_mul(p, x);
+    }
+    return p;
+}
+
+} // namespace detail
+
+/* Reductions. threads = 0 uses one thread per hardware thread, and inputs of a
+ * single chunk run on the calling thread
+ *
+ * reduce_sum: NaN if any value is NaN or both infinities appear, otherwise
+ * +-inf if any infinity appears. Saturates at max()/min()
+ * reduce_product: saturates at max()/min() instead of wrapping the exponent
+ * reduce_min/reduce_max: NaN values are skipped, NaN for an empty or all-NaN
+ * range. argmin/argmax return the index of the first extreme value, or
+ * values.size() for an empty or all-NaN range
+ */
+inline BigNum reduce_sum(std::span<const BigNum> values, std::size_t threads = 0) {
+    return detail::reduce_sum(values, threads);
+}
+inline BigNum reduce_sum(BigNumArray::ConstSpan values, std::size_t threads = 0) {
+    return detail::reduce_sum(values, threads);
+}
+
+inline BigNum reduce_product(std::span<const BigNum> values,
+                             std::size_t threads = 0) {
+    return detail::reduce_product(values, threads);
+}
+inline BigNum reduce_product(BigNumArray::ConstSpan values,
+                             std::size_t threads = 0) {
+    return detail::reduce_product(values, threads);
+}
+
+inline std::size_t argmax(std::span<const BigNum> values, std::size_t threads = 0) {
+    return detail::arg_best(values, threads, std::greater<>());
+}
+inline std::size_t argmax(BigNumArray::ConstSpan values, std::size_t threads = 0) {
+    return detail::arg_best(values, threads, std::greater<>());
+}
+inline std::size_t argmin(std::span<const BigNum> values, std::size_t threads = 0) {
+    return detail::arg_best(values, threads, std::less<>());
+}
+inline std::size_t argmin(BigNumArray::ConstSpan values, std::size_t threads = 0) {
+    return detail::arg_best(values, threads, std::less<>());
+}
+
+inline BigNum reduce_max(std::span<const BigNum> values, std::size_t threads = 0) {
+    std::size_t i = argmax(values, threads);
+    return i < values.size() ? values[i] : BigNum::nan();
+}
+inline BigNum reduce_max(BigNumArray::ConstSpan values, std::size_t threads = 0) {
+    std::size_t i = argmax(values, threads);
+    return i < values.size() ? values[i] : BigNum::nan();
+}
+inline BigNum reduce_min(std::span<const BigNum> values, std::size_t threads = 0) {
+    std::size_t i = argmin(values, threads);
+    return i < values.size() ? values[i] : BigNum::nan();
+}
+inline BigNum reduce_min(BigNumArray::ConstSpan values, std::size_t threads = 0) {
+    std::size_t i = argmin(values, threads);
+    return i < values.size() ? values[i] : BigNum::nan();
+}
+
+} // namespace BigNumber
@@ -0,0 +1,109 @@
+/*
+BigNumSort: LSD radix sort for ranges of BigNums
+radix_sort(values) sorts a std::span<BigNum> in ascending order, and
+radix_sort(keys, payload) sorts keys while moving payload[i] along with
+keys[i], e.g. scores and player ids of a leaderboard
+
+Values are sorted by BigNum::sort_key(), one byte per pass, so the order is
+the one of operator<=>, with every NaN at the end. Passes over a byte that
+is the same in every key are skipped; in practice only a few of the 16 are
+needed, since signs and exponents vary little. Both sorts are stable
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "BigNum.hpp"
+
+namespace BigNumber {
+
+namespace detail {
+
+// Below this size std::stable_sort beats the histogram passes
+inline constexpr std::size_t RADIX_MIN_SIZE = 256;
+
+struct RadixRecord {
+    BigNum::SortKey key;
+    std::size_t index;
+};
+
+inline std::uint8_t radix_digit(const BigNum::SortKey &key, unsigned pass) {
+    return static_cast<std::uint8_t>(pass < 8 ? key.lo >> (8 * pass)
+                                              : key.hi >> (8 * (pass - 8)));
+}
+
+// Returns the positions of keys in ascending key order, stable
+inline std::vector<std::size_t> radix_order(std::span<const BigNum> keys) {
+    const std::size_t n = keys.size();
+    std::vector<RadixRecord> records(n);
+    std::vector<std::array<std::size_t, 256>> counts(16);
+    for (std::size_t i = 0; i < n; ++i) {
+        records[i] = {keys[i].sort_key(), i};
+        for (unsigned pass = 0; pass < 16; ++pass) {
+            ++counts[pass][radix_digit(records[i].key, pass)];
+        }
+    }
+
+    if (n < RADIX_MIN_SIZE) {
+        std::stable_sort(records.begin(), records.end(),
+                         [](const RadixRecord &a, const RadixRecord &b) {
+                             return a.key < b.key;
+                         });
+    } else {
+        std::vector<RadixRecord> buffer(n);
+        for (unsigned pass = 0; pass < 16; ++pass) {
+            auto &count = counts[pass];
+            if (count[radix_digit(records[0].key, pass)] == n) {
+                continue; // every key has the same digit
+            }
+            std::size_t offset = 0;
+            for (std::size_t &c : count) {
+                offset += std::exchange(c, offset);
+            }
+            for (const RadixRecord &r : records) {
+                buffer[count[radix_digit(r.key, pass)]++] = r;
+            }
+            records.swap(buffer);
+        }
+    }
+
+    std::vector<std::size_t> order(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        order[i] = records[i].index;
+    }
+    return order;
+}
+
+// Reorders values so that values[i] becomes the old values[order[i]]
+template <typename T>
+void apply_order(std::span<T> values, const std::vector<std::size_t> &order) {
+    std::vector<T> sorted;
+    sorted.reserve(values.size());
+    for (std::size_t i : order) {
+        sorted.push_back(std::move(values[i]));
+    }
+    std::move(sorted.begin(), sorted.end(), values.begin());
+}
+
+} // namespace detail
+
+inline void radix_sort(std::span<BigNum> values) {
+    detail::apply_order(values, detail::radix_order(values));
+}
+
+// payload must have at least keys.size() elements; only that many are moved
+template <typename T>
+void radix_sort(std::span<BigNum> keys, std::span<T> payload) {
+    const auto order = detail::radix_order(keys);
+    detail::apply_order(keys, order);
+    detail::apply_order(payload.first(keys.size()), order);
+}
+
+} // namespace BigNumber
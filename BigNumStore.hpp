@@ -0,0 +1,390 @@
+/*
+BigNumStore: memory-mapped column file for persisting large amounts of BigNums
+The file holds a fixed header followed by the mantissa and exponent columns, so
+opening it maps the columns straight into memory instead of parsing every value
+
+Layout (little-endian, every offset a multiple of 8):
+    [0, 64)                                header, see BigNumStore::Header
+    [mantissa_offset, + 8 * capacity)      mantissas, IEEE-754 double bits
+    [exponent_offset, + 8 * capacity)      exponents, uint64
+Only the first `rows` entries of each column are meaningful. The checksum
+covers exactly those rows, and is updated incrementally by append(); the
+header checksum covers every other header field
+
+The header is the commit point: append() and reserve() write the data and
+msync it before replacing the header in a single write, so a crash or power
+loss leaves either the old or the new contents. reserve() copies the exponent
+column past the end of the old columns instead of moving it in place, so an
+interrupted reserve() leaves the old store intact
+
+Requires POSIX mmap. I/O and format errors throw, or abort when built with
+BIGNUM_NO_EXCEPTIONS
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "BigNum.hpp"
+
+namespace BigNumber {
+
+class BigNumStore {
+  public:
+    using man_t = BigNumArray::man_t;
+    using exp_t = BigNumArray::exp_t;
+
+    static inline constexpr std::uint32_t VERSION = 2;
+
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t header_size;
+        std::uint64_t rows;
+        std::uint64_t capacity;
+        std::uint64_t checksum; // over the rows
+        std::uint64_t mantissa_offset;
+        std::uint64_t exponent_offset;
+        std::uint64_t header_checksum; // over the fields above
+    };
+
+  private:
+    static_assert(std::endian::native == std::endian::little,
+                  "BigNumStore maps little-endian columns directly");
+    static_assert(sizeof(man_t) == 8 && sizeof(exp_t) == 8,
+                  "BigNumStore assumes 64-bit mantissa and exponent");
+    static_assert(sizeof(Header) == 64);
+
+    static inline constexpr char MAGIC[8] = {'B', 'I', 'G', 'N',
+                                             'U', 'M', 'C', 'F'};
+    static inline constexpr std::uint64_t CHECKSUM_SEED = 0xcbf29ce484222325;
+    static inline constexpr std::size_t MIN_CAPACITY = 1024;
+
+    int fd = -1;
+    std::byte *base = nullptr;
+    std::size_t mapped = 0;
+    bool writable = false;
+
+    BigNumStore(int file, bool write) : fd(file), writable(write) {}
+
+    static std::size_t file_size(std::uint64_t capacity) {
+        return sizeof(Header) + 2 * sizeof(std::uint64_t) * capacity;
+    }
+    static std::uint64_t column_end(std::uint64_t offset, std::uint64_t capacity) {
+        return offset + sizeof(std::uint64_t) * capacity;
+    }
+
+    // FNV-style mix over 64-bit words, two words (mantissa, exponent) per row
+    static std::uint64_t mix(std::uint64_t h, std::uint64_t word) {
+        h = (h ^ word) * 0x100000001b3;
+        return h ^ (h >> 32);
+    }
+    static std::uint64_t checksum(std::uint64_t h, const man_t *m,
+                                  const exp_t *e, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            h = mix(h, std::bit_cast<std::uint64_t>(m[i]));
+            h = mix(h, e[i]);
+        }
+        return h;
+    }
+    static std::uint64_t header_checksum(const Header &h) {
+        std::uint64_t words[offsetof(Header, header_checksum) / 8];
+        std::memcpy(words, &h, sizeof(words));
+        std::uint64_t sum = CHECKSUM_SEED;
+        for (std::uint64_t w : words) {
+            sum = mix(sum, w);
+        }
+        return sum;
+    }
+
+    [[noreturn]] static void throw_errno([[maybe_unused]] const std::string &what) {
+        BIGNUM_FATAL(std::system_error(errno, std::generic_category(),
+                                       "BigNumStore: " + what));
+    }
+
+    // Maps size bytes, replacing the current mapping only once the new one
+    // exists, so a failure leaves the store as it was
+    void map(std::size_t size) {
+        int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+        void *p = ::mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            throw_errno("mmap failed");
+        }
+        unmap();
+        base = static_cast<std::byte *>(p);
+        mapped = size;
+    }
+
+    void unmap() {
+        if (base != nullptr) {
+            ::munmap(base, mapped);
+            base = nullptr;
+            mapped = 0;
+        }
+    }
+
+    void close() {
+        unmap();
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    Header &header() { return *reinterpret_cast<Header *>(base); }
+    const Header &header() const { return *reinterpret_cast<const Header *>(base); }
+    man_t *mantissa_column() {
+        return reinterpret_cast<man_t *>(base + header().mantissa_offset);
+    }
+    const man_t *mantissa_column() const {
+        return reinterpret_cast<const man_t *>(base + header().mantissa_offset);
+    }
+    exp_t *exponent_column() {
+        return reinterpret_cast<exp_t *>(base + header().exponent_offset);
+    }
+    const exp_t *exponent_column() const {
+        return reinterpret_cast<const exp_t *>(base + header().exponent_offset);
+    }
+
+    // Blocks until [p, p + bytes) of the mapping is written to the file
+    void sync(const void *p, std::size_t bytes) {
+        const auto page = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+        const auto first = reinterpret_cast<std::uintptr_t>(p) & ~(page - 1);
+        const auto last = reinterpret_cast<std::uintptr_t>(p) + bytes;
+        if (::msync(reinterpret_cast<void *>(first), last - first, MS_SYNC) != 0) {
+            throw_errno("msync failed");
+        }
+    }
+
+    // Publishes h with one write of the whole header, after everything it
+    // points at has been synced
+    void commit_header(Header h) {
+        h.header_checksum = header_checksum(h);
+        std::memcpy(base, &h, sizeof(Header));
+    }
+
+    // Publishes count rows written from index rows on: syncs and checksums
+    // them, then commits the header once
+    void commit_rows(std::size_t rows, std::size_t count) {
+        sync(mantissa_column() + rows, sizeof(man_t) * count);
+        sync(exponent_column() + rows, sizeof(exp_t) * count);
+        Header h = header();
+        h.checksum = checksum(h.checksum, mantissa_column() + rows,
+                              exponent_column() + rows, count);
+        h.rows = rows + count;
+        commit_header(h);
+    }
+
+    // Columns are 8-byte aligned, inside the file and in order
+    static bool valid_layout(const Header &h, std::size_t size) {
+        const std::uint64_t max_capacity = (size - sizeof(Header)) / 16;
+        return h.capacity != 0 && h.rows <= h.capacity && h.capacity <= max_capacity &&
+               h.mantissa_offset == sizeof(Header) && h.exponent_offset % 8 == 0 &&
+               h.exponent_offset >= column_end(h.mantissa_offset, h.capacity) &&
+               h.exponent_offset <= size &&
+               (size - h.exponent_offset) / sizeof(exp_t) >= h.capacity;
+    }
+
+    void require_writable() const {
+        if (!writable) {
+            BIGNUM_FATAL(std::logic_error("BigNumStore: store is opened read-only"));
+        }
+    }
+
+  public:
+    // Creates (or truncates) a store file, ready for appending
+    static BigNumStore create(const std::string &path,
+                              std::size_t capacity = MIN_CAPACITY) {
+        int file = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (file < 0) {
+            throw_errno("cannot create " + path);
+        }
+        BigNumStore store(file, true);
+        capacity = std::max(capacity, std::size_t(1));
+        if (::ftruncate(file, static_cast<off_t>(file_size(capacity))) != 0) {
+            throw_errno("cannot resize " + path);
+        }
+        store.map(file_size(capacity));
+        Header h{};
+        std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+        h.version = VERSION;
+        h.header_size = sizeof(Header);
+        h.rows = 0;
+        h.capacity = capacity;
+        h.checksum = CHECKSUM_SEED;
+        h.mantissa_offset = sizeof(Header);
+        h.exponent_offset = column_end(h.mantissa_offset, capacity);
+        store.commit_header(h);
+        return store;
+    }
+
+    // Maps an existing store file. Verifying the checksum reads every row;
+    // skip it to pay only for the pages that are actually touched
+    static BigNumStore open(const std::string &path, bool write = false,
+                            bool verify_checksum = true) {
+        int file = ::open(path.c_str(), write ? O_RDWR : O_RDONLY);
+        if (file < 0) {
+            throw_errno("cannot open " + path);
+        }
+        BigNumStore store(file, write);
+        struct stat st;
+        if (::fstat(file, &st) != 0) {
+            throw_errno("cannot stat " + path);
+        }
+        auto size = static_cast<std::size_t>(st.st_size);
+        if (size < sizeof(Header)) {
+            BIGNUM_FATAL(std::runtime_error("BigNumStore: " + path +
+                                            " is too small to be a store"));
+        }
+        store.map(size);
+        const Header &h = store.header();
+        if (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0) {
+            BIGNUM_FATAL(std::runtime_error("BigNumStore: " + path +
+                                            " is not a BigNum store"));
+        }
+        if (h.version != VERSION || h.header_size != sizeof(Header)) {
+            BIGNUM_FATAL(std::runtime_error("BigNumStore: unsupported version " +
+                                            std::to_string(h.version) + " in " + path));
+        }
+        if (h.header_checksum != header_checksum(h)) {
+            BIGNUM_FATAL(std::runtime_error("BigNumStore: corrupt header in " + path));
+        }
+        // The file may be longer than the columns need if a reserve() was
+        // interrupted before its header was written
+        if (!valid_layout(h, size)) {
+            BIGNUM_FATAL(std::runtime_error("BigNumStore: " + path + " is truncated"));
+        }
+        if (verify_checksum && !store.verify()) {
+            BIGNUM_FATAL(std::runtime_error("BigNumStore: checksum mismatch in " + path));
+        }
+        return store;
+    }
+
+    BigNumStore(BigNumStore &&other) noexcept
+        : fd(std::exchange(other.fd, -1)),
+          base(std::exchange(other.base, nullptr)),
+          mapped(std::exchange(other.mapped, 0)), writable(other.writable) {}
+    BigNumStore &operator=(BigNumStore &&other) noexcept {
+        if (this != &other) {
+            close();
+            fd = std::exchange(other.fd, -1);
+            base = std::exchange(other.base, nullptr);
+            mapped = std::exchange(other.mapped, 0);
+            writable = other.writable;
+        }
+        return *this;
+    }
+    BigNumStore(const BigNumStore &) = delete;
+    BigNumStore &operator=(const BigNumStore &) = delete;
+    ~BigNumStore() { close(); }
+
+    std::size_t size() const { return header().rows; }
+    bool empty() const { return size() == 0; }
+    std::size_t capacity() const { return header().capacity; }
+    std::uint32_t version() const { return header().version; }
+
+    // Zero-copy views into the mapping, invalidated by append() and reserve()
+    std::span<const man_t> mantissas() const { return {mantissa_column(), size()}; }
+    std::span<const exp_t> exponents() const { return {exponent_column(), size()}; }
+    BigNumArray::ConstSpan columns() const { return {mantissas(), exponents()}; }
+    operator BigNumArray::ConstSpan() const { return columns(); }
+    BigNum operator[](std::size_t i) const { return columns()[i]; }
+
+    bool verify() const {
+        return header().header_checksum == header_checksum(header()) &&
+               checksum(CHECKSUM_SEED, mantissa_column(), exponent_column(),
+                        size()) == header().checksum;
+    }
+
+    // Grows the file so that at least n rows fit without remapping
+    void reserve(std::size_t n) {
+        require_writable();
+        const Header old = header();
+        if (n <= old.capacity) {
+            return;
+        }
+        Header h = old;
+        h.capacity = std::max({static_cast<std::uint64_t>(n), old.capacity * 2,
+                               static_cast<std::uint64_t>(MIN_CAPACITY)});
+        h.exponent_offset = std::max(column_end(h.mantissa_offset, h.capacity),
+                                     column_end(old.exponent_offset, old.capacity));
+        const std::size_t new_size = column_end(h.exponent_offset, h.capacity);
+        if (new_size > mapped &&
+            ::ftruncate(fd, static_cast<off_t>(new_size)) != 0) {
+            throw_errno("cannot resize store");
+        }
+        map(std::max(new_size, mapped));
+        std::memcpy(base + h.exponent_offset, base + old.exponent_offset,
+                    sizeof(exp_t) * old.rows);
+        flush();
+        commit_header(h);
+    }
+
+    // Appends rows; the header is updated after the data is on disk
+    void append(BigNumArray::ConstSpan values) {
+        assert(values.m.size() == values.e.size() &&
+               "Mantissa and exponent columns must have the same length");
+        require_writable();
+        std::size_t rows = size();
+        if (values.size() > capacity() - rows) {
+            reserve(rows + values.size());
+        }
+        if (values.size() == 0) {
+            return;
+        }
+        std::memcpy(mantissa_column() + rows, values.m.data(),
+                    values.m.size_bytes());
+        std::memcpy(exponent_column() + rows, values.e.data(),
+                    values.e.size_bytes());
+        commit_rows(rows, values.size());
+    }
+    void append(std::span<const BigNum> values) {
+        require_writable();
+        std::size_t rows = size();
+        if (values.size() > capacity() - rows) {
+            reserve(rows + values.size());
+        }
+        if (values.empty()) {
+            return;
+        }
+        man_t *m = mantissa_column() + rows;
+        exp_t *e = exponent_column() + rows;
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            m[i] = values[i].getM();
+            e[i] = values[i].getE();
+        }
+        commit_rows(rows, values.size());
+    }
+    void append(const BigNum &value) {
+        man_t m = value.getM();
+        exp_t e = value.getE();
+        append(BigNumArray::ConstSpan({&m, 1}, {&e, 1}));
+    }
+
+    // Blocks until every change is written to the file
+    void flush() {
+        if (writable && ::msync(base, mapped, MS_SYNC) != 0) {
+            throw_errno("msync failed");
+        }
+    }
+};
+
+} // namespace BigNumber
+
+using BigNumber::BigNumStore;
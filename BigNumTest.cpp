@@ -1,11 +1,38 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include <doctest/doctest.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "BigNum.hpp"
+#include "BigNumAtomic.hpp"
+#include "BigNumDD.hpp"
+#include "BigNumExpr.hpp"
+#include "BigNumGenerators.hpp"
+#include "BigNumLeaderboard.hpp"
+#include "BigNumNotation.hpp"
+#include "BigNumParallel.hpp"
+#include "BigNumSort.hpp"
+#if __has_include(<sys/mman.h>)
+#include "BigNumStore.hpp"
+#endif
 
 using namespace std::literals::string_literals;
 using namespace std::literals::string_view_literals;
@@ -45,6 +72,12 @@ TEST_SUITE("Instantiation Tests") {
         BigNum v6(123456789L);
         CHECK_EQ("123456789"s, v6.to_string());
         CHECK_EQ("123,456,789"s, v6.to_pretty_string());
+        CHECK_EQ("870"s, BigNum(870.0).to_string());
+        CHECK_EQ("-8,700"s, BigNum(-8700.0).to_pretty_string());
+        CHECK_EQ("1,234"s, BigNum(1234.0).to_pretty_string());
+        CHECK_EQ("-12,345"s, BigNum(-12345.0).to_pretty_string());
+        CHECK_EQ("-123"s, BigNum(-123.0).to_pretty_string());
+        CHECK_EQ("-123,456"s, BigNum(-123456.0).to_pretty_string());
     }
 }
 
@@ -110,6 +143,24 @@ TEST_SUITE("Comparison Tests") {
     TEST_CASE("v4 comparisons") {
         CHECK(v4 > v5);
     }
+
+    TEST_CASE("Negative values with the same exponent") {
+        CHECK(BigNum(-3.0, 6) > BigNum(-8.0, 6));
+        CHECK(BigNum(-8.0, 6) < BigNum(-3.0, 6));
+        CHECK(BigNum(-1.5, 100) > BigNum(-1.6, 100));
+        CHECK_EQ(BigNum(-3.0, 6) <=> BigNum(-3.0, 6), std::partial_ordering::equivalent);
+    }
+
+    TEST_CASE("Infinities against large finite values") {
+        const BigNum big(1.0, 1000);
+        CHECK(BigNum::inf() > big);
+        CHECK(BigNum::inf() > BigNum::max());
+        CHECK(-BigNum::inf() < -big);
+        CHECK(-BigNum::inf() < BigNum::min());
+        CHECK(big < BigNum::inf());
+        CHECK(-BigNum::inf() < BigNum::inf());
+        CHECK_EQ(BigNum::inf() <=> BigNum::inf(), std::partial_ordering::equivalent);
+    }
 }
 
 TEST_SUITE("Advanced Math Tests") {
@@ -161,4 +212,2126 @@ TEST_SUITE("Small Number Tests") {
         BigNum res4 = BigNum(0.5) * BigNum(0.25);
         CHECK((res4 - BigNum(0.125)).abs() < 1e-5);
     }
+
+    TEST_CASE("Rounding carries into the exponent") {
+        CHECK_EQ(BigNum(9.9), BigNum(10.0));
+        CHECK_EQ(BigNum(9.9).getM(), 1.0);
+        CHECK_EQ(BigNum(9.9).getE(), 1);
+        CHECK_EQ(BigNum(99.7), BigNum(1.0, 2));
+        CHECK_EQ(BigNum(-9.5), BigNum(-10.0));
+        CHECK_EQ(BigNum(9.999999, 5), BigNum(1.0, 6));
+    }
+
+    TEST_CASE("Dividing by a larger exponent") {
+        const BigNum q = BigNum(1.0) / BigNum(4.0, 1);
+        CHECK_EQ(q.getE(), 0);
+        CHECK((q - BigNum(0.025)).abs() < 1e-12);
+
+        BigNum r(3.0, 2);
+        r /= BigNum(6.0, 5);
+        CHECK_EQ(r.getE(), 0);
+        CHECK((r - BigNum(0.0005)).abs() < 1e-12);
+
+        CHECK_EQ((BigNum(5.0, 3) / BigNum(1.0, 40)).getE(), 0);
+        CHECK_EQ(BigNum(5.0, 3) / BigNum(1.0, 400), BigNum(0.0));
+    }
+
+    TEST_CASE("Mantissas below 1 borrow from the exponent") {
+        CHECK_EQ(BigNum(0.5, 20), BigNum(5.0, 19));
+        CHECK_EQ(BigNum(-0.025, 30), BigNum(-2.5, 28));
+
+        const BigNum q = BigNum(1.0, 30) / BigNum(4.0, 10);
+        CHECK_EQ(q.getM(), 2.5);
+        CHECK_EQ(q.getE(), 19);
+
+        BigNum r(2.0, 50);
+        r /= BigNum(8.0, 20);
+        CHECK_EQ(r, BigNum(2.5, 29));
+    }
+}
+
+TEST_SUITE("BigNumArray Tests") {
+    // Mix of regimes: small values, exponents around the rounding and
+    // alignment cutoffs, huge exponents, and special values
+    std::vector<BigNum> sample_values(size_t n, uint64_t seed) {
+        std::mt19937_64 rng(seed);
+        std::uniform_real_distribution<double> mant(-10.0, 10.0);
+        std::vector<BigNum> values;
+        values.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            switch (rng() % 10) {
+            case 0:
+                values.push_back(BigNum(mant(rng) * 1000.0));
+                break;
+            case 1:
+                values.push_back(BigNum(mant(rng), rng() % 20));
+                break;
+            case 2:
+                values.push_back(BigNum(mant(rng), (1ULL << 62) + rng() % 4));
+                break;
+            case 3: {
+                const BigNum specials[] = {BigNum::inf(), BigNum::nan(),
+                                           BigNum::max(), BigNum::min(),
+                                           BigNum(0.0), -BigNum::inf()};
+                values.push_back(specials[rng() % 6]);
+                break;
+            }
+            default:
+                values.push_back(BigNum(mant(rng), 15 + rng() % 40));
+                break;
+            }
+        }
+        return values;
+    }
+
+    bool same_bits(const BigNum &a, const BigNum &b) {
+        return std::bit_cast<uint64_t>(a.getM()) ==
+                   std::bit_cast<uint64_t>(b.getM()) &&
+               a.getE() == b.getE();
+    }
+
+    TEST_CASE("Batch operations match scalar operators") {
+        const size_t n = 4099; // not a multiple of any vector width
+        std::vector<BigNum> a = sample_values(n, 1);
+        std::vector<BigNum> b = sample_values(n, 2);
+        BigNumArray aa(a), ab(b), out(n);
+
+        size_t mismatches = 0;
+        BigNumArray::add(aa, ab, out);
+        for (size_t i = 0; i < n; ++i)
+            mismatches += !same_bits(out[i], a[i] + b[i]);
+        BigNumArray::sub(aa, ab, out);
+        for (size_t i = 0; i < n; ++i)
+            mismatches += !same_bits(out[i], a[i] - b[i]);
+        BigNumArray::mul(aa, ab, out);
+        for (size_t i = 0; i < n; ++i)
+            mismatches += !same_bits(out[i], a[i] * b[i]);
+        BigNumArray::div(aa, ab, out);
+        for (size_t i = 0; i < n; ++i)
+            mismatches += !same_bits(out[i], a[i] / b[i]);
+        CHECK_EQ(mismatches, 0);
+    }
+
+    TEST_CASE("In-place and broadcast operations") {
+        std::vector<BigNum> a = sample_values(1000, 3);
+        BigNumArray arr(a);
+        const BigNum rate("1.5e20");
+        arr *= rate;
+        arr += rate;
+        size_t mismatches = 0;
+        for (size_t i = 0; i < a.size(); ++i)
+            mismatches += !same_bits(arr[i], a[i] * rate + rate);
+        CHECK_EQ(mismatches, 0);
+    }
+
+    TEST_CASE("Batch normalize") {
+        std::mt19937_64 rng(4);
+        std::uniform_real_distribution<double> mant(-1e6, 1e6);
+        BigNumArray arr(1000);
+        for (size_t i = 0; i < arr.size(); ++i) {
+            arr.mantissas()[i] = mant(rng);
+            arr.exponents()[i] = rng() % 40;
+        }
+        std::vector<BigNum> expected;
+        for (size_t i = 0; i < arr.size(); ++i)
+            expected.push_back(BigNum(arr.mantissas()[i], arr.exponents()[i]));
+        arr.normalize();
+        size_t mismatches = 0;
+        for (size_t i = 0; i < arr.size(); ++i)
+            mismatches += !same_bits(arr[i], expected[i]);
+        CHECK_EQ(mismatches, 0);
+    }
+}
+
+TEST_SUITE("Deferred Normalization Tests") {
+    TEST_CASE("Chains match BigNum arithmetic") {
+        BigNum base("1.5e300"), mult1("2.5"), mult2("3.75e12"),
+            mult3("8.1e5"), bonus("4.2e318");
+        BigNum expected = base * mult1 * mult2 * mult3 + bonus;
+        BigNum lazy = UnnormalizedBigNum(base) * mult1 * mult2 * mult3 + bonus;
+        CHECK_EQ(lazy.getE(), expected.getE());
+        CHECK(lazy.getM() == doctest::Approx(expected.getM()).epsilon(1e-12));
+
+        BigNum q = UnnormalizedBigNum(expected) / mult3 / mult2 / mult1 - bonus;
+        CHECK(q.getM() == doctest::Approx(-4.2).epsilon(1e-12));
+        CHECK_EQ(q.getE(), 318);
+    }
+
+    TEST_CASE("Mantissa drift is folded back") {
+        const BigNum factor("9.5e3");
+        UnnormalizedBigNum v(BigNum("9.9e10"));
+        BigNum expected("9.9e10");
+        for (int i = 0; i < 500; ++i) {
+            v *= factor;
+            expected *= factor;
+        }
+        CHECK(std::isfinite(v.getM()));
+        CHECK_EQ(v.normalized().getE(), expected.getE());
+        CHECK(v.normalized().getM() ==
+              doctest::Approx(expected.getM()).epsilon(1e-9));
+        for (int i = 0; i < 500; ++i) {
+            v /= factor;
+        }
+        CHECK_EQ(BigNum("9.9e10"), v);
+    }
+
+    TEST_CASE("Large scalar factors are folded into the exponent") {
+        // |x - y| <= 1e-12 * |y|
+        auto close = [](const BigNum &x, const BigNum &y) {
+            return (x - y).abs() * BigNum(1.0, 12) <= y.abs();
+        };
+        const UnnormalizedBigNum u = UnnormalizedBigNum(BigNum(9.9)) * 1e99 * 1e300 * 1e300;
+        CHECK(std::isfinite(u.getM()));
+        CHECK(close(u, BigNum(9.9) * 1e99 * 1e300 * 1e300));
+        CHECK(close(UnnormalizedBigNum(1e300) * -1e300, BigNum(-1.0, 600)));
+        CHECK(close(UnnormalizedBigNum(BigNum(2.0, 700)) / 1e300 / 1e300, BigNum(2.0, 100)));
+        // Scalars inside the window are still applied exactly
+        CHECK_EQ(UnnormalizedBigNum(2.5).getM(), 2.5);
+    }
+
+    TEST_CASE("Comparisons and special values") {
+        UnnormalizedBigNum a = UnnormalizedBigNum(BigNum(5.0)) * 4.0;
+        CHECK_EQ(a, BigNum(20.0));
+        CHECK(a > BigNum(19.0));
+        CHECK(a < UnnormalizedBigNum(BigNum("1e5")));
+        CHECK((a / 0.0).normalized().is_nan());
+        CHECK_EQ("20"s, a.to_string());
+    }
+}
+
+TEST_SUITE("Formatting Tests") {
+    std::string chars(const BigNum &v, unsigned int precision, bool pretty) {
+        char buffer[128];
+        auto [ptr, ec] = pretty ? v.to_pretty_chars(buffer, buffer + 128, precision)
+                                : v.to_chars(buffer, buffer + 128, precision);
+        REQUIRE(ec == std::errc());
+        return std::string(buffer, ptr);
+    }
+
+    TEST_CASE("to_chars matches to_string") {
+        const BigNum values[] = {
+            BigNum("1.23456789e123456789"), BigNum("-1.23456789e123456789"),
+            BigNum("100"), BigNum("0"), BigNum(0.125), BigNum(-7.5),
+            BigNum(123456789.0), BigNum(-1234567.0), BigNum("9.9999999e20"),
+            BigNum::inf(), BigNum::nan(), BigNum::max(), BigNum::min()};
+        for (const BigNum &v : values) {
+            for (unsigned int precision : {1u, 2u, 3u, 9u}) {
+                CHECK_EQ(v.to_string(precision), chars(v, precision, false));
+                CHECK_EQ(v.to_pretty_string(precision), chars(v, precision, true));
+            }
+        }
+        CHECK_EQ("1.23e123456789"s, chars(BigNum("1.23456789e123456789"), 2, false));
+        CHECK_EQ("-1,234,567"s, chars(BigNum(-1234567.0), 3, true));
+    }
+
+    TEST_CASE("to_chars reports small buffers") {
+        char buffer[4];
+        auto [ptr, ec] = BigNum("1.5e300").to_chars(buffer, buffer + 4);
+        CHECK(ec == std::errc::value_too_large);
+        CHECK(ptr == buffer + 4);
+        auto pretty = BigNum(1234.0).to_pretty_chars(buffer, buffer + 4);
+        CHECK(pretty.ec == std::errc::value_too_large);
+    }
+
+    TEST_CASE("Explicit formatting contexts") {
+        const BigNumContext german{10, 2, ',', '.'};
+        CHECK_EQ("-1.234.567"s, BigNum(-1234567.0).to_pretty_string(german));
+        CHECK_EQ("1,23e100"s, BigNum("1.2345e100").to_string(german));
+        CHECK_EQ("0,1"s, BigNum(0.125).to_string(german));
+
+        BigNum parsed;
+        std::string_view text = "1.234.567,5e3";
+        auto [ptr, ec] = BigNum::from_chars(text.data(), text.data() + text.size(),
+                                            parsed, german);
+        CHECK(ec == std::errc());
+        CHECK(ptr == text.data() + text.size());
+        CHECK_EQ(parsed, BigNum("1234567500"));
+
+        // Other contexts leave the thread's default untouched
+        CHECK_EQ("1,234,567"s, BigNum(1234567.0).to_pretty_string());
+    }
+
+    TEST_CASE("Scoped contexts and serialization") {
+        const BigNum v("1.23456789e100");
+        const std::string serialized = v.serialize();
+        {
+            ScopedBigNumContext scope({10, 1, ',', ' '});
+            CHECK_EQ("1,2e100"s, v.to_string());
+            CHECK_EQ("1 234 567"s, BigNum(1234567.0).to_pretty_string());
+            CHECK_EQ(BigNum("2,5"), BigNum(2.5));
+            // Serialization does not depend on the thread's context
+            CHECK_EQ(serialized, v.serialize());
+            CHECK_EQ(BigNum::deserialize(serialized), v);
+            ScopedBigNumContext european({10, 3, ',', '.'});
+            const BigNum64 packed(BigNum(1.2345678, 23));
+            CHECK_EQ(BigNum64::deserialize(packed.serialize()).serialize(), packed.serialize());
+        }
+        CHECK_EQ("1.234e100"s, v.to_string());
+        CHECK_EQ("1.234567890e100"s, serialized);
+    }
+
+    TEST_CASE("Each thread has its own default context") {
+        const BigNum v(1234567.0);
+        std::string results[2];
+        {
+            std::jthread a([&] {
+                BigNumber::DefaultBigNumContext.thousands_separator = '.';
+                for (int i = 0; i < 1000; ++i) {
+                    results[0] = v.to_pretty_string();
+                }
+            });
+            std::jthread b([&] {
+                BigNumber::DefaultBigNumContext.thousands_separator = '\'';
+                for (int i = 0; i < 1000; ++i) {
+                    results[1] = v.to_pretty_string();
+                }
+            });
+        }
+        CHECK_EQ("1.234.567"s, results[0]);
+        CHECK_EQ("1'234'567"s, results[1]);
+        CHECK_EQ("1,234,567"s, v.to_pretty_string());
+    }
+
+#ifdef __cpp_lib_format
+    TEST_CASE("std::format support") {
+        BigNum v(1234567.0);
+        CHECK_EQ(v.to_string(), std::format("{}", v));
+        CHECK_EQ("1,234,567"s, std::format("{:p}", v));
+        CHECK_EQ("1.23e100"s, std::format("{:.2}", BigNum("1.2345e100")));
+        CHECK_EQ("__1.2e100"s, std::format("{:_>9.1}", BigNum("1.2345e100")));
+        CHECK_EQ("[100  ]"s, std::format("[{:<5}]", BigNum(100.0)));
+        // An alignment character after a field is literal text, not a fill
+        CHECK_EQ("100>"s, std::format("{}>", BigNum(100.0)));
+        CHECK_EQ("<100<"s, std::format("<{}<", BigNum(100.0)));
+        CHECK_EQ("100^ 7"s, std::format("{}^ {}", BigNum(100.0), BigNum(7.0)));
+        std::formatter<BigNum, char> braces;
+        std::format_parse_context brace_fill("{<5}");
+        CHECK_THROWS_AS(braces.parse(brace_fill), std::format_error);
+
+        // Format strings are checked at compile time, which needs a formatter
+        // that is constructible in a constant expression
+        static_assert([] {
+            std::formatter<BigNum, char> formatter;
+            return !formatter.has_precision;
+        }());
+
+        // Without a precision the thread's context applies when formatting
+        const BigNum big("1.23456e100");
+        ScopedBigNumContext scope({10, 1, '.', ','});
+        CHECK_EQ("1.2e100"s, std::format("{}", big));
+        CHECK_EQ("1.234e100"s, std::format("{:.3}", big));
+    }
+#endif
+}
+
+TEST_SUITE("Parsing Tests") {
+    std::from_chars_result parse(std::string_view str, BigNum &value) {
+        return BigNum::from_chars(str.data(), str.data() + str.size(), value);
+    }
+
+    TEST_CASE("Formats produced by to_string and to_pretty_string") {
+        const BigNum values[] = {BigNum(123456789.0), BigNum(-1234567.0),
+                                 BigNum("1.5e300"), BigNum(0.25), BigNum(7.0),
+                                 BigNum("-9.87e12345")};
+        for (const BigNum &v : values) {
+            BigNum parsed;
+            std::string str = v.to_pretty_string(9);
+            auto [ptr, ec] = parse(str, parsed);
+            CHECK(ec == std::errc());
+            CHECK(ptr == str.data() + str.size());
+            CHECK_EQ(v.to_string(9), parsed.to_string(9));
+        }
+
+        BigNum v;
+        CHECK(parse("1.5E10", v).ec == std::errc());
+        CHECK_EQ(BigNum("1.5e10"), v);
+        CHECK(parse("-1,234,567.5", v).ec == std::errc());
+        CHECK_EQ(BigNum(-1234567.5), v);
+        CHECK(parse("inf", v).ec == std::errc());
+        CHECK(v.is_inf());
+        CHECK(parse("nan", v).ec == std::errc());
+        CHECK(v.is_nan());
+    }
+
+    TEST_CASE("Long mantissas move digits into the exponent") {
+        std::string digits = "12" + std::string(400, '0');
+        BigNum v;
+        CHECK(parse(digits, v).ec == std::errc());
+        CHECK_EQ(v.getE(), 401);
+        CHECK(v.getM() == doctest::Approx(1.2).epsilon(1e-12));
+    }
+
+    TEST_CASE("Partial consumption and errors") {
+        BigNum v(42.0);
+        std::string_view str = "12abc";
+        auto result = parse(str, v);
+        CHECK(result.ec == std::errc());
+        CHECK(result.ptr == str.data() + 2);
+        CHECK_EQ(BigNum(12.0), v);
+
+        str = "1,23";
+        result = parse(str, v);
+        CHECK(result.ptr == str.data() + 1);
+        CHECK_EQ(BigNum(1.0), v);
+
+        str = "5e";
+        result = parse(str, v);
+        CHECK(result.ptr == str.data() + 1);
+
+        v = BigNum(42.0);
+        CHECK(parse("abc", v).ec == std::errc::invalid_argument);
+        CHECK(parse("-", v).ec == std::errc::invalid_argument);
+        CHECK(parse("", v).ec == std::errc::invalid_argument);
+        CHECK(parse("1e99999999999999999999999", v).ec ==
+              std::errc::result_out_of_range);
+        // Normalizing 123 would carry two more digits into the exponent
+        CHECK(parse("123e18446744073709551615", v).ec == std::errc::result_out_of_range);
+        CHECK(parse("1,000e18446744073709551613", v).ec == std::errc::result_out_of_range);
+        CHECK_EQ(BigNum(42.0), v);
+        CHECK(parse("123e18446744073709551613", v).ec == std::errc());
+        CHECK_EQ(v, BigNum(1.23, std::numeric_limits<uintmax_t>::max()));
+        v = BigNum(42.0);
+    }
+
+    TEST_CASE("Constructor and stream extraction") {
+        CHECK_THROWS_AS(BigNum("12abc"), std::invalid_argument);
+        CHECK_EQ(BigNum("1,000"), BigNum(1000.0));
+
+        std::istringstream in("1.5e20 -3 bogus");
+        BigNum a, b, c(7.0);
+        in >> a >> b;
+        CHECK_EQ(BigNum("1.5e20"), a);
+        CHECK_EQ(BigNum(-3.0), b);
+        CHECK_FALSE(in.fail());
+        in >> c;
+        CHECK(in.fail());
+        CHECK_EQ(BigNum(7.0), c);
+        // A token with a number in front is malformed as a whole
+        std::istringstream partial("12abc");
+        partial >> c;
+        CHECK(partial.fail());
+        CHECK_EQ(BigNum(7.0), c);
+        BigNum64 packed(BigNum(5.0));
+        std::istringstream partial64("12e3x");
+        partial64 >> packed;
+        CHECK(partial64.fail());
+        CHECK_EQ(BigNum(5.0), BigNum(packed));
+    }
+}
+
+TEST_SUITE("Binary Serialization Tests") {
+    bool same_bits(const BigNum &a, const BigNum &b) {
+        return std::bit_cast<uint64_t>(a.getM()) ==
+                   std::bit_cast<uint64_t>(b.getM()) &&
+               a.getE() == b.getE();
+    }
+
+    const BigNum samples[] = {
+        BigNum("1.23456789123456789e123456789"), BigNum(-0.1), BigNum(0.0),
+        -BigNum(0.0), BigNum(5.0), BigNum("7e127"), BigNum("7e128"),
+        BigNum("-3.3e16383"), BigNum("3.3e16384"), BigNum::max(), BigNum::min(),
+        BigNum::inf(), -BigNum::inf(), BigNum::nan()};
+
+    TEST_CASE("Round trip is exact") {
+        for (auto format : {BigNum::SerialFormat::Fixed, BigNum::SerialFormat::Compact}) {
+            for (const BigNum &v : samples) {
+                std::array<std::byte, BigNum::SERIAL_MAX_SIZE> buffer{};
+                size_t written = v.serialize_to(buffer, format);
+                CHECK_EQ(written, v.serialized_size(format));
+                BigNum parsed;
+                CHECK_EQ(BigNum::deserialize_from(buffer, parsed, format), written);
+                CHECK(same_bits(v, parsed));
+            }
+        }
+    }
+
+    TEST_CASE("Layout") {
+        std::array<std::byte, 16> buffer{};
+        BigNum(1.0, 0x0102).serialize_to(buffer);
+        CHECK(buffer[6] == std::byte{0xF0}); // 1.0 = 0x3FF0000000000000
+        CHECK(buffer[7] == std::byte{0x3F});
+        CHECK(buffer[8] == std::byte{0x02});
+        CHECK(buffer[9] == std::byte{0x01});
+
+        CHECK_EQ(BigNum(5.0).serialized_size(BigNum::SerialFormat::Compact), 9);
+        CHECK_EQ(BigNum("7e127").serialized_size(BigNum::SerialFormat::Compact), 9);
+        CHECK_EQ(BigNum("7e128").serialized_size(BigNum::SerialFormat::Compact), 10);
+        CHECK_EQ(BigNum("7e16383").serialized_size(BigNum::SerialFormat::Compact), 10);
+        CHECK_EQ(BigNum::max().serialized_size(BigNum::SerialFormat::Compact), 18);
+    }
+
+    TEST_CASE("Truncated and malformed input") {
+        std::array<std::byte, 18> buffer{};
+        BigNum v(42.0);
+        CHECK_EQ(BigNum("1e300").serialize_to(std::span(buffer).first(15)), 0);
+        CHECK_EQ(BigNum::deserialize_from(std::span(buffer).first(15), v), 0);
+        std::size_t size = BigNum("1e300").serialize_to(buffer, BigNum::SerialFormat::Compact);
+        CHECK_EQ(BigNum::deserialize_from(std::span(buffer).first(size - 1), v,
+                                          BigNum::SerialFormat::Compact), 0);
+        std::fill(buffer.begin() + 8, buffer.end(), std::byte{0xFF});
+        CHECK_EQ(BigNum::deserialize_from(buffer, v, BigNum::SerialFormat::Compact), 0);
+        CHECK_EQ(BigNum(42.0), v);
+    }
+
+    TEST_CASE("Encodings normalize() cannot produce are rejected") {
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        const double inf = std::numeric_limits<double>::infinity();
+        const std::pair<double, std::uint64_t> malformed[] = {
+            {12.5, 40}, {0.5, 40}, {-0.5, 3}, {0.0, 7}, {-nan, 7}, {inf, 2}, {10.0, 0}};
+        for (auto [mantissa, exponent] : malformed) {
+            std::array<std::byte, 16> buffer;
+            const auto bits = std::bit_cast<std::uint64_t>(mantissa);
+            for (int i = 0; i < 8; ++i) {
+                buffer[i] = static_cast<std::byte>(bits >> (8 * i));
+                buffer[8 + i] = static_cast<std::byte>(exponent >> (8 * i));
+            }
+            BigNum v(42.0);
+            CHECK_EQ(BigNum::deserialize_from(buffer, v), 0);
+            CHECK_EQ(BigNum(42.0), v);
+            std::vector<BigNum> values(1);
+            CHECK_EQ(BigNum::deserialize_from(buffer, values), 0);
+        }
+
+        // Everything arithmetic produces is accepted
+        std::mt19937_64 rng(6);
+        std::uniform_real_distribution<double> mant(1.0, 10.0);
+        std::vector<BigNum> results;
+        for (int i = 0; i < 10000; ++i) {
+            const BigNum a(mant(rng), rng() % 400), b(-mant(rng), rng() % 40);
+            results.insert(results.end(), {a * b, a / b, a + b, a - b, a.pow(0.5),
+                                           BigNum(mant(rng) * std::pow(10.0, rng() % 300))});
+        }
+        std::vector<std::byte> bytes(results.size() * BigNum::SERIAL_FIXED_SIZE);
+        CHECK_EQ(BigNum::serialize_to(results, bytes), bytes.size());
+        std::vector<BigNum> parsed(results.size());
+        CHECK_EQ(BigNum::deserialize_from(bytes, parsed), bytes.size());
+        CHECK(std::ranges::all_of(results, &BigNum::is_normalized));
+    }
+
+    TEST_CASE("Bulk round trip") {
+        for (auto format : {BigNum::SerialFormat::Fixed, BigNum::SerialFormat::Compact}) {
+            std::vector<std::byte> bytes(std::size(samples) * BigNum::SERIAL_MAX_SIZE);
+            size_t written = BigNum::serialize_to(samples, bytes, format);
+            CHECK(written > 0);
+            std::vector<BigNum> parsed(std::size(samples));
+            CHECK_EQ(BigNum::deserialize_from(std::span(bytes).first(written), parsed, format),
+                     written);
+            for (size_t i = 0; i < parsed.size(); ++i) {
+                CHECK(same_bits(samples[i], parsed[i]));
+            }
+        }
+    }
+}
+
+#if __has_include(<sys/mman.h>)
+TEST_SUITE("Column Store Tests") {
+    std::string temp_store_path(const char *name) {
+        return (std::filesystem::temp_directory_path() / name).string();
+    }
+
+    TEST_CASE("Write, reopen and view columns") {
+        std::string path = temp_store_path("bignum_store_test.bnc");
+        std::vector<BigNum> values;
+        for (int i = 0; i < 3000; ++i) {
+            values.push_back(BigNum(1.0 + i % 9, static_cast<uintmax_t>(i) * 7));
+        }
+        values.push_back(BigNum::nan());
+        values.push_back(-BigNum::inf());
+        {
+            BigNumStore store = BigNumStore::create(path, 16);
+            store.append(std::span(values).first(10));
+            store.append(std::span(values).subspan(10));
+            CHECK_EQ(store.size(), values.size());
+            CHECK(store.capacity() >= values.size());
+            store.flush();
+        }
+
+        BigNumStore store = BigNumStore::open(path);
+        REQUIRE_EQ(store.size(), values.size());
+        CHECK_EQ(store.version(), BigNumStore::VERSION);
+        bool all_same = true;
+        for (size_t i = 0; i < values.size(); ++i) {
+            all_same &= std::bit_cast<uint64_t>(store[i].getM()) ==
+                            std::bit_cast<uint64_t>(values[i].getM()) &&
+                        store[i].getE() == values[i].getE();
+        }
+        CHECK(all_same);
+        CHECK_THROWS_AS(store.append(BigNum(1.0)), std::logic_error);
+
+        // The mapped columns feed the batch kernels directly
+        BigNumArray doubled(store.size());
+        BigNumArray::add(store, store, doubled);
+        CHECK_EQ(doubled[5], values[5] * 2);
+
+        // Appending after reopening keeps the checksum valid
+        {
+            BigNumStore writer = BigNumStore::open(path, true);
+            writer.append(BigNum(5.0, 123));
+        }
+        CHECK_EQ(BigNumStore::open(path)[values.size()], BigNum(5.0, 123));
+        std::filesystem::remove(path);
+    }
+
+    TEST_CASE("Corrupted files are rejected") {
+        std::string path = temp_store_path("bignum_store_corrupt.bnc");
+        {
+            BigNumStore store = BigNumStore::create(path);
+            store.append(BigNum(1.5, 100));
+            store.append(BigNum(2.5, 200));
+        }
+        {
+            std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(sizeof(BigNumStore::Header) + 8);
+            file.put('\x42');
+        }
+        CHECK_THROWS_AS(BigNumStore::open(path), std::runtime_error);
+        CHECK_EQ(BigNumStore::open(path, false, false).size(), 2);
+
+        {
+            std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+            file.put('X');
+        }
+        CHECK_THROWS_AS(BigNumStore::open(path, false, false), std::runtime_error);
+        std::filesystem::resize_file(path, 10);
+        CHECK_THROWS_AS(BigNumStore::open(path), std::runtime_error);
+        std::filesystem::remove(path);
+        CHECK_THROWS_AS(BigNumStore::open(path), std::system_error);
+    }
+
+    TEST_CASE("Header fields are checksummed") {
+        std::string path = temp_store_path("bignum_store_header.bnc");
+        {
+            BigNumStore store = BigNumStore::create(path, 4);
+            store.append(BigNum(1.5, 100));
+        }
+        {
+            // A valid-looking row count that the data checksum alone would
+            // not catch when verification is skipped
+            std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(offsetof(BigNumStore::Header, rows));
+            file.put('\0');
+        }
+        CHECK_THROWS_AS(BigNumStore::open(path, false, false), std::runtime_error);
+        std::filesystem::remove(path);
+    }
+
+    TEST_CASE("Interrupted growth keeps the old store") {
+        std::string path = temp_store_path("bignum_store_grow.bnc");
+        std::vector<BigNum> values;
+        for (int i = 0; i < 4; ++i) {
+            values.push_back(BigNum(1.25 + i, static_cast<uintmax_t>(i) * 1000));
+        }
+        {
+            BigNumStore store = BigNumStore::create(path, 4);
+            store.append(values);
+            CHECK_EQ(store.capacity(), 4);
+        }
+
+        // reserve() grows the file before it writes the new header; a crash
+        // in between leaves a longer file that still opens with the old rows
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) * 5);
+        {
+            BigNumStore store = BigNumStore::open(path, true);
+            REQUIRE_EQ(store.size(), values.size());
+            CHECK_EQ(store.capacity(), 4);
+            CHECK_EQ(store[3], values[3]);
+
+            // Growing from there reuses the space and moves the exponents
+            store.append(BigNum(9.0, 9000));
+            CHECK(store.capacity() > 4);
+        }
+        BigNumStore store = BigNumStore::open(path);
+        REQUIRE_EQ(store.size(), values.size() + 1);
+        for (size_t i = 0; i < values.size(); ++i) {
+            CHECK_EQ(store[i], values[i]);
+        }
+        CHECK_EQ(store[4], BigNum(9.0, 9000));
+        std::filesystem::remove(path);
+    }
+}
+#endif
+
+TEST_SUITE("BigNum64 Tests") {
+    TEST_CASE("Packing and exact conversion back") {
+        CHECK_EQ(sizeof(BigNum64), 8);
+        std::mt19937_64 rng(64);
+        std::uniform_real_distribution<double> mant(1.0, 10.0);
+        for (int i = 0; i < 2000; ++i) {
+            BigNum v(((rng() & 1) ? 1 : -1) * mant(rng), rng() % 5000000);
+            BigNum64 packed(v);
+            BigNum back = packed;
+            CHECK(std::abs(back.getM() - v.getM()) <= std::abs(v.getM()) * 0x1p-38);
+            CHECK_EQ(back.getE(), v.getE());
+            // BigNum64 -> BigNum -> BigNum64 is lossless
+            CHECK_EQ(BigNum64(back).to_bits(), packed.to_bits());
+        }
+
+        CHECK_EQ(BigNum(BigNum64(0.0)), BigNum(0.0));
+        CHECK_EQ(BigNum(BigNum64(0.25)), BigNum(0.25));
+        CHECK_EQ(BigNum(BigNum64(12345.0)), BigNum(12345.0));
+        CHECK_EQ(BigNum(BigNum64(-7.0, 1234)), BigNum(-7.0, 1234));
+        CHECK(BigNum(BigNum64(BigNum::inf())).is_inf());
+        CHECK(BigNum(BigNum64(BigNum::nan())).is_nan());
+        CHECK(BigNum64(std::nextafter(10.0, 0.0), 5) == BigNum64(1.0, 6));
+
+        CHECK(BigNum64::from_exact(BigNum(1.5, 1000)).has_value());
+        CHECK_FALSE(BigNum64::from_exact(BigNum(1.0 / 3.0, 1000)).has_value());
+        CHECK_FALSE(BigNum64::from_exact(BigNum(1.0, 1ull << 30)).has_value());
+        CHECK_EQ(BigNum64(BigNum(1.0, 1ull << 30)), BigNum64::max());
+        CHECK_EQ(BigNum64(BigNum(-1.0, 1ull << 30)), BigNum64::min());
+    }
+
+    TEST_CASE("Comparisons agree with BigNum") {
+        std::mt19937_64 rng(8);
+        std::uniform_real_distribution<double> mant(1.0, 10.0);
+        auto sample = [&]() -> BigNum64 {
+            switch (rng() % 6) {
+            case 0:
+                return BigNum64(0.0);
+            case 1:
+                return BigNum64(((rng() & 1) ? 1 : -1) * mant(rng) / 20);
+            default:
+                return BigNum64(((rng() & 1) ? 1 : -1) * mant(rng), rng() % 40);
+            }
+        };
+        for (int i = 0; i < 2000; ++i) {
+            BigNum64 a = sample(), b = sample();
+            CHECK((a <=> b) == (BigNum(a) <=> BigNum(b)));
+        }
+        CHECK(BigNum64(-0.0) == BigNum64(0.0));
+        CHECK(BigNum64::inf() > BigNum64::max());
+        CHECK(-BigNum64::inf() < BigNum64::min());
+        CHECK_FALSE(BigNum64::nan() == BigNum64::nan());
+        CHECK((BigNum64::nan() <=> BigNum64(1.0)) == std::partial_ordering::unordered);
+        CHECK(BigNum64(2.0) == 2.0);
+        CHECK(BigNum64(2.0, 100) == BigNum(2.0, 100));
+    }
+
+    TEST_CASE("Arithmetic and formatting") {
+        BigNum64 a(1.5, 1000), b(2.0, 998);
+        CHECK_EQ(a + b, BigNum64(1.52, 1000));
+        CHECK_EQ(a - b, BigNum64(1.48, 1000));
+        CHECK_EQ(a * b, BigNum64(3.0, 1998));
+        CHECK_EQ(a / b, BigNum64(7.5, 1));
+        CHECK_EQ(a * 2.0, BigNum64(3.0, 1000));
+        CHECK_EQ(a + BigNum(1.5, 1000), BigNum(3.0, 1000));
+        CHECK_EQ(-a, BigNum64(-1.5, 1000));
+        BigNum64 c(5.0);
+        c += 1.0;
+        c *= "1e3";
+        CHECK_EQ(c, BigNum64(6000.0));
+        CHECK_EQ(c++, BigNum64(6000.0));
+        CHECK_EQ(c, BigNum64(6001.0));
+        CHECK_EQ(BigNum64(4.0, 10).sqrt(), BigNum64(2.0, 5));
+        CHECK_EQ(BigNum64(2.0, 10).pow(2.0), BigNum64(4.0, 20));
+        CHECK_EQ(BigNum64::max() * 10.0, BigNum64::max());
+
+        CHECK_EQ(a.to_string(), BigNum(a).to_string());
+        CHECK_EQ(BigNum64(1234567.0).to_pretty_string(), "1,234,567");
+        CHECK_EQ(BigNum64::deserialize(a.serialize()), a);
+        BigNum64 parsed;
+        std::string_view text = "1.25e77";
+        CHECK(BigNum64::from_chars(text.data(), text.data() + text.size(), parsed).ec ==
+              std::errc());
+        CHECK_EQ(parsed, BigNum64(1.25, 77));
+        std::ostringstream os;
+        os << BigNum64(42.0);
+        CHECK_EQ(os.str(), "42");
+    }
+
+#ifdef __cpp_lib_format
+    TEST_CASE("std::format support") {
+        static_assert([] {
+            std::formatter<BigNum64, char> formatter;
+            return !formatter.has_precision;
+        }());
+        CHECK_EQ(std::format("{}", BigNum64()), BigNum().to_string());
+        CHECK_EQ(std::format("{:.2}", BigNum64(1.5, 1000)), BigNum(1.5, 1000).to_string(2));
+        CHECK_EQ(std::format("{:p}", BigNum64(1234567.0)), "1,234,567");
+        CHECK_EQ(std::format("{}<", BigNum64(100.0)), "100<");
+    }
+#endif
+}
+
+TEST_SUITE("BigLog Tests") {
+    // Relative comparison through the log domain
+    bool close(const BigNum &a, const BigNum &b, double tolerance = 1e-9) {
+        if (a.is_negative() != b.is_negative()) {
+            return false;
+        }
+        return std::abs(*a.abs().log10() - *b.abs().log10()) <= tolerance;
+    }
+
+    TEST_CASE("Conversions") {
+        CHECK_EQ(BigLog(1000.0).log10(), doctest::Approx(3.0));
+        CHECK_EQ(BigLog(BigNum(2.5, 1000)).log10(), doctest::Approx(1000.39794));
+        CHECK_EQ(BigLog(12345.0).to_bignum(), BigNum(12345.0));
+        CHECK_EQ(BigLog(-0.25).to_bignum(), BigNum(-0.25));
+        CHECK(close(BigLog(BigNum(-7.25, 123456)).to_bignum(), BigNum(-7.25, 123456)));
+        CHECK(BigLog(0.0).is_zero());
+        CHECK_EQ(BigLog(0.0).to_bignum(), BigNum(0.0));
+        CHECK(BigLog(BigNum::inf()).to_bignum().is_inf());
+        CHECK(BigLog(BigNum::nan()).to_bignum().is_nan());
+        CHECK_EQ(BigLog::from_log10(1e30).to_bignum(), BigNum::max());
+        CHECK_EQ(BigLog::from_log10(1e30, true).to_bignum(), BigNum::min());
+    }
+
+    TEST_CASE("Multiplicative operations match BigNum") {
+        BigNum a(3.5, 400), b(-2.25, 120);
+        BigLog la(a), lb(b);
+        CHECK(close((la * lb).to_bignum(), a * b));
+        CHECK(close((la / lb).to_bignum(), a / b));
+        CHECK(close(la.pow(2.5).to_bignum(), a.pow(2.5)));
+        CHECK(close(lb.pow(static_cast<intmax_t>(3)).to_bignum(), b.pow(static_cast<intmax_t>(3))));
+        CHECK(close(lb.pow(static_cast<intmax_t>(2)).to_bignum(), b.pow(static_cast<intmax_t>(2))));
+        CHECK(close(la.root(3).to_bignum(), a.root(3)));
+        CHECK(close(lb.root(3).to_bignum(), b.root(3)));
+        CHECK(close(la.sqrt().to_bignum(), a.sqrt()));
+        CHECK_THROWS_AS(lb.pow(0.5), std::domain_error);
+        CHECK_THROWS_AS(lb.root(2), std::domain_error);
+        CHECK_THROWS_AS(BigLog(0.0).pow(-1.0), std::domain_error);
+        CHECK_THROWS_AS(la.root(0), std::domain_error);
+    }
+
+    TEST_CASE("Addition with log1p correction") {
+        BigNum a(3.5, 400), b(2.25, 398);
+        CHECK(close((BigLog(a) + BigLog(b)).to_bignum(), a + b, 1e-12));
+        CHECK(close((BigLog(a) - BigLog(b)).to_bignum(), a - b, 1e-12));
+        CHECK(close((BigLog(b) - BigLog(a)).to_bignum(), b - a, 1e-12));
+        // Tiny addends disappear instead of losing the big one
+        CHECK_EQ((BigLog(a) + BigLog(1.0)).log10(), BigLog(a).log10());
+        CHECK((BigLog(a) - BigLog(a)).is_zero());
+        CHECK_EQ((BigLog(0.0) + BigLog(5.0)).to_bignum(), BigNum(5.0));
+        CHECK_EQ((BigLog(2.0) + 3.0).to_bignum(), BigNum(5.0));
+        CHECK((BigLog(BigNum::inf()) - BigLog(BigNum::inf())).is_nan());
+    }
+
+    TEST_CASE("Comparisons") {
+        CHECK(BigLog(2.0) < BigLog(3.0));
+        CHECK(BigLog(-2.0) > BigLog(-3.0));
+        CHECK(BigLog(-2.0) < BigLog(0.0));
+        CHECK(BigLog(-0.0) == BigLog(0.0));
+        CHECK(BigLog(5.0) == 5.0);
+        CHECK_FALSE(BigLog(BigNum::nan()) == BigLog(BigNum::nan()));
+    }
+}
+
+#if BIGNUM_CONSTEXPR
+TEST_SUITE("Constexpr Tests") {
+    // Upgrade cost table baked at compile time: 100 * 1.15^level
+    constexpr auto upgrade_costs = [] {
+        std::array<BigNum, 64> costs{};
+        BigNum cost(100.0);
+        for (BigNum &c : costs) {
+            c = cost;
+            cost = cost * 115.0 / 100.0;
+        }
+        return costs;
+    }();
+
+    TEST_CASE("Literals") {
+        constexpr BigNum a = 1.5e300_bn;
+        static_assert(a.getM() == 1.5 && a.getE() == 300);
+        static_assert(1e5000_bn > 9.99e4999_bn);
+        static_assert(-2.5e10_bn < 0.0);
+        static_assert(1'000'000_bn == BigNum(1.0, 6));
+        static_assert(0.5_bn == BigNum(0.5));
+        static_assert(BigNum("123.456e78") == 123.456e78_bn);
+        // The largest exponent that still leaves room for normalizing 123
+        static_assert(123e18446744073709551613_bn ==
+                      BigNum(1.23, std::numeric_limits<uintmax_t>::max()));
+
+        CHECK_EQ(1.5e300_bn, BigNum("1.5e300"));
+        CHECK_EQ(12345.678e3_bn, BigNum("12345.678e3"));
+        CHECK_EQ(9.87654321e123456_bn, BigNum("9.87654321e123456"));
+        CHECK_EQ(42_bn, BigNum(42.0));
+    }
+
+    TEST_CASE("Core operations in constant expressions") {
+        static_assert(BigNum(2.0, 100) * BigNum(3.0, 50) == BigNum(6.0, 150));
+        static_assert(BigNum(6.0, 150) / BigNum(3.0, 50) == BigNum(2.0, 100));
+        static_assert(BigNum(1.0, 20) + BigNum(5.0, 19) == BigNum(1.5, 20));
+        static_assert(BigNum(1.0, 20) - BigNum(5.0, 19) == BigNum(5.0, 19));
+        static_assert(-BigNum(1.0, 20) < BigNum(1.0, 19));
+        static_assert(BigNum::max() > BigNum(1.0, 1000));
+        static_assert(BigNum::inf().is_inf() && BigNum::nan().is_nan());
+        static_assert(BigNum(-7.5, 40).abs() == BigNum(7.5, 40));
+        static_assert(BigNum(2.4) == BigNum(2.0) && BigNum(-2.5) == BigNum(-3.0));
+        static_assert(upgrade_costs[0] == BigNum(100.0));
+        static_assert(upgrade_costs[63] > upgrade_costs[62]);
+
+        BigNum cost(100.0);
+        for (const BigNum &c : upgrade_costs) {
+            CHECK_EQ(c, cost);
+            cost = cost * 115.0 / 100.0;
+        }
+    }
+}
+#endif
+
+TEST_SUITE("Normalization Edge Cases") {
+    TEST_CASE("Rounded powers of ten keep the mantissa in [1, 10)") {
+        // 1e300 / 1e300 is just below 1 in doubles
+        CHECK_EQ(BigNum(1e300), BigNum(1.0, 300));
+        BigNumArray batch(309);
+        for (int k = 0; k <= 308; ++k) {
+            const BigNum v(std::pow(10.0, k));
+            CHECK(v.getM() >= 1.0);
+            CHECK(v.getM() < 10.0);
+            batch.mantissas()[k] = -std::pow(10.0, k);
+        }
+        // The SIMD lanes leave such mantissas to the scalar path
+        batch.normalize();
+        for (int k = 0; k <= 308; ++k) {
+            const BigNum v(-std::pow(10.0, k));
+            CHECK_EQ(batch[k].getM(), v.getM());
+            CHECK_EQ(batch[k].getE(), v.getE());
+        }
+    }
+
+    TEST_CASE("Rounding carries into the exponent") {
+        CHECK_EQ(BigNum(9.9), BigNum(10.0));
+        CHECK_EQ(BigNum(9.9).getE(), 1);
+        CHECK_EQ(BigNum(-99.7), BigNum(-100.0));
+        CHECK_EQ(BigNum(9.9).to_string(), "10");
+    }
+
+    TEST_CASE("Division with a larger divisor exponent") {
+        BigNum q = BigNum(1.0, 5) / BigNum(1.0, 10);
+        CHECK_EQ(q.getE(), 0);
+        CHECK_EQ(q.getM(), doctest::Approx(1e-5));
+        BigNum r(5.0, 3);
+        r /= BigNum(2.0, 5);
+        CHECK_EQ(r.getM(), doctest::Approx(0.025));
+        CHECK_EQ(BigNum(1.0, 5) / BigNum(1.0, 400), BigNum(0.0));
+    }
+
+    TEST_CASE("Mantissas below 1 borrow from the exponent") {
+        BigNum q = BigNum(1.0, 30) / BigNum(4.0, 2);
+        CHECK_EQ(q.getM(), doctest::Approx(2.5));
+        CHECK_EQ(q.getE(), 27);
+        CHECK_EQ(BigNum(0.75, 2), BigNum(75.0));
+
+        BigNumArray a(std::vector<BigNum>(9, BigNum(1.0, 30)));
+        BigNumArray b(std::vector<BigNum>(9, BigNum(4.0, 2)));
+        BigNumArray out(9);
+        BigNumArray::div(a, b, out);
+        for (std::size_t i = 0; i < out.size(); ++i) {
+            CHECK_EQ(out[i].getE(), 27);
+            CHECK_EQ(out[i].getM(), q.getM());
+        }
+    }
+}
+
+TEST_SUITE("Series Tests") {
+    // Brute-force "buy max" loop, the way callers did it before
+    template <typename NextPrice>
+    int buy_max(double budget, double price, NextPrice next) {
+        int n = 0;
+        while (price <= budget && n < 100000) {
+            budget -= price;
+            price = next(price);
+            ++n;
+        }
+        return n;
+    }
+
+    TEST_CASE("Geometric series") {
+        // 100 + 115 + 132.25 + 152.0875 + 174.900625 = 674.238...
+        CHECK_EQ(BigNum::sum_geometric_series(BigNum(5.0), BigNum(100.0), 1.15),
+                 BigNum(674.0));
+        CHECK_EQ(BigNum::sum_geometric_series(BigNum(4.0), BigNum(100.0), 1.0),
+                 BigNum(400.0));
+        CHECK_EQ(BigNum::sum_geometric_series(BigNum(0.0), BigNum(100.0), 2.0),
+                 BigNum(0.0));
+
+        for (double budget : {0.0, 99.0, 100.0, 1000.0, 123456.0, 1e9}) {
+            int expected = buy_max(budget, 100.0, [](double p) { return p * 1.15; });
+            CHECK_EQ(BigNum::afford_geometric_series(BigNum(budget), BigNum(100.0), 1.15),
+                     BigNum(static_cast<double>(expected)));
+        }
+        // Owned items raise the starting price: 2 owned at ratio 2 start at 400
+        CHECK_EQ(BigNum::afford_geometric_series(BigNum(1200.0), BigNum(100.0), 2.0,
+                                                 BigNum(2.0)),
+                 BigNum(2.0));
+        // Decreasing prices converge to start / (1 - r) = 200
+        CHECK_EQ(BigNum::afford_geometric_series(BigNum(180.0), BigNum(100.0), 0.5),
+                 BigNum(3.0));
+        CHECK(BigNum::afford_geometric_series(BigNum(250.0), BigNum(100.0), 0.5).is_inf());
+        CHECK_THROWS_AS(BigNum::afford_geometric_series(BigNum(1.0), BigNum(1.0), 0.0),
+                        std::domain_error);
+    }
+
+    TEST_CASE("Geometric series with huge exponents") {
+        BigNum start(1.0, 1000), budget(1.0, 1100);
+        BigNum n = BigNum::afford_geometric_series(budget, start, 1.07, BigNum(10.0));
+        CHECK(BigNum::sum_geometric_series(n, start, 1.07, BigNum(10.0)) <= budget);
+        CHECK(BigNum::sum_geometric_series(n + 1.0, start, 1.07, BigNum(10.0)) > budget);
+        // log(0.07 * 1e100 / 1.07^10 + 1) / log(1.07) ~= 3353.9
+        CHECK_EQ(n, BigNum(3353.0));
+    }
+
+    TEST_CASE("Arithmetic series") {
+        // 10 + 15 + 20 + 25 + 30 = 100
+        CHECK_EQ(BigNum::sum_arithmetic_series(BigNum(5.0), BigNum(10.0), BigNum(5.0)),
+                 BigNum(100.0));
+        CHECK_EQ(BigNum::sum_arithmetic_series(BigNum(3.0), BigNum(10.0), BigNum(5.0),
+                                               BigNum(2.0)),
+                 BigNum(75.0));
+        for (double budget : {0.0, 9.0, 10.0, 99.0, 100.0, 101.0, 54321.0}) {
+            int expected = buy_max(budget, 10.0, [](double p) { return p + 5.0; });
+            CHECK_EQ(BigNum::afford_arithmetic_series(BigNum(budget), BigNum(10.0),
+                                                      BigNum(5.0)),
+                     BigNum(static_cast<double>(expected)));
+        }
+        CHECK_EQ(BigNum::afford_arithmetic_series(BigNum(100.0), BigNum(10.0),
+                                                  BigNum(5.0), BigNum(2.0)),
+                 BigNum(3.0));
+        CHECK_EQ(BigNum::afford_arithmetic_series(BigNum(100.0), BigNum(7.0), BigNum(0.0)),
+                 BigNum(14.0));
+        CHECK_EQ(BigNum::afford_arithmetic_series(BigNum(100.0), BigNum(0.0), BigNum(1.0)),
+                 BigNum(14.0));
+
+        // n^2 / 2 ~= 1e500 gives n ~= 1.414e250
+        BigNum n = BigNum::afford_arithmetic_series(BigNum(1.0, 500), BigNum(1.0),
+                                                    BigNum(1.0));
+        CHECK_EQ(n.getE(), 250);
+        CHECK_EQ(n.getM(), doctest::Approx(std::sqrt(2.0)));
+        CHECK_THROWS_AS(BigNum::afford_arithmetic_series(BigNum(1.0), BigNum(1.0),
+                                                         BigNum(-1.0)),
+                        std::domain_error);
+    }
+
+    TEST_CASE("Batch variants match the scalar functions") {
+        std::vector<BigNum::GeometricUpgrade> geometric = {
+            {BigNum(100.0), 1.15, BigNum(0.0)},
+            {BigNum(5.0, 300), 1.5, BigNum(20.0)},
+            {BigNum(1.0, 10), 0.9, BigNum(3.0)}};
+        std::vector<BigNum::ArithmeticUpgrade> arithmetic = {
+            {BigNum(10.0), BigNum(5.0), BigNum(0.0)},
+            {BigNum(1.0, 40), BigNum(3.0, 39), BigNum(7.0)}};
+        BigNum budget(1.0, 320);
+        std::vector<BigNum> out(3);
+        BigNum::afford_geometric_series(budget, geometric, out);
+        for (size_t i = 0; i < geometric.size(); ++i) {
+            const auto &u = geometric[i];
+            CHECK_EQ(out[i], BigNum::afford_geometric_series(budget, u.price_start,
+                                                             u.price_ratio,
+                                                             u.current_owned));
+        }
+        BigNum::sum_geometric_series(BigNum(10.0), geometric, out);
+        CHECK_EQ(out[1], BigNum::sum_geometric_series(BigNum(10.0), BigNum(5.0, 300),
+                                                      1.5, BigNum(20.0)));
+        BigNum::afford_arithmetic_series(budget, arithmetic, out);
+        CHECK_EQ(out[1], BigNum::afford_arithmetic_series(budget, BigNum(1.0, 40),
+                                                          BigNum(3.0, 39), BigNum(7.0)));
+        BigNum::sum_arithmetic_series(BigNum(4.0), arithmetic, out);
+        CHECK_EQ(out[0], BigNum(70.0));
+    }
+}
+
+TEST_SUITE("Reduction Tests") {
+    std::vector<BigNum> random_values(std::size_t n, std::uint64_t seed) {
+        std::mt19937_64 rng(seed);
+        std::uniform_real_distribution<double> mant(1.0, 10.0);
+        std::vector<BigNum> values;
+        for (std::size_t i = 0; i < n; ++i) {
+            double sign = (rng() & 1) ? 1.0 : -1.0;
+            values.push_back(BigNum(sign * mant(rng), 100 + rng() % 40));
+        }
+        return values;
+    }
+
+    TEST_CASE("Results do not depend on the thread count") {
+        std::vector<BigNum> values = random_values(50000, 7);
+        BigNumArray columns(values);
+        BigNum sum = reduce_sum(values, 1);
+        BigNum product = reduce_product(values, 1);
+        std::size_t best = argmax(values, 1);
+        for (std::size_t threads : {2, 3, 8, 0}) {
+            BigNum s = reduce_sum(values, threads);
+            CHECK_EQ(s.getM(), sum.getM());
+            CHECK_EQ(s.getE(), sum.getE());
+            CHECK_EQ(reduce_sum(columns, threads).getM(), sum.getM());
+            CHECK_EQ(reduce_product(values, threads).getM(), product.getM());
+            CHECK_EQ(argmax(values, threads), best);
+            CHECK_EQ(argmax(columns, threads), best);
+        }
+        CHECK_EQ(reduce_max(values), *std::max_element(values.begin(), values.end()));
+        CHECK_EQ(reduce_min(values), *std::min_element(values.begin(), values.end()));
+        CHECK_EQ(argmin(values), static_cast<std::size_t>(
+                                     std::min_element(values.begin(), values.end()) -
+                                     values.begin()));
+    }
+
+    TEST_CASE("Small contributions are not dropped") {
+        // Folding with add() drops every 1 against 1e20
+        std::vector<BigNum> values(1000000, BigNum(1.0));
+        values[123] = BigNum(1.0, 20);
+        BigNum serial;
+        for (const BigNum &v : values) {
+            serial += v;
+        }
+        CHECK_EQ(serial, BigNum(1.0, 20));
+        CHECK_EQ(reduce_sum(values, 4).getM(),
+                 doctest::Approx(1.00000000000001).epsilon(1e-15));
+        CHECK_EQ(reduce_sum(values, 4).getE(), 20);
+    }
+
+    TEST_CASE("Exact sums on the integer grid") {
+        std::vector<BigNum> values;
+        for (int i = 1; i <= 10000; ++i) {
+            values.push_back(BigNum(static_cast<double>(i)));
+        }
+        CHECK_EQ(reduce_sum(values), BigNum(50005000.0));
+        values.push_back(BigNum(-50005000.0));
+        CHECK_EQ(reduce_sum(values), BigNum(0.0));
+        CHECK_EQ(reduce_sum(std::span<const BigNum>()), BigNum(0.0));
+        CHECK_EQ(reduce_product(std::span<const BigNum>()), BigNum(1.0));
+    }
+
+    TEST_CASE("Special values") {
+        std::vector<BigNum> values = random_values(10000, 3);
+        values[5000] = BigNum::inf();
+        CHECK(reduce_sum(values).is_inf());
+        values[9000] = -BigNum::inf();
+        CHECK(reduce_sum(values).is_nan());
+        values[9000] = BigNum::nan();
+        CHECK(reduce_sum(values).is_nan());
+        // NaN is skipped by min/max
+        CHECK_EQ(argmax(values), 5000);
+        CHECK(reduce_max(std::vector<BigNum>(3, BigNum::nan())).is_nan());
+        CHECK_EQ(argmax(std::span<const BigNum>()), 0);
+
+        std::vector<BigNum> huge(3, BigNum(5.0, std::numeric_limits<uintmax_t>::max() / 2));
+        CHECK_EQ(reduce_product(huge), BigNum::max());
+        CHECK_EQ(reduce_sum(std::vector<BigNum>(20, BigNum::max())), BigNum::max());
+        huge[0] = -huge[0];
+        CHECK_EQ(reduce_product(huge), BigNum::min());
+    }
+}
+
+TEST_SUITE("Hash Tests") {
+    TEST_CASE("std::hash agrees with operator==") {
+        std::hash<BigNum> hash;
+        CHECK_EQ(hash(BigNum(0.0)), hash(BigNum(-0.0)));
+        CHECK_EQ(hash(BigNum::nan()), hash(-BigNum::nan()));
+        CHECK_EQ(hash(BigNum("1.5e300")), hash(BigNum(1.5, 300)));
+        CHECK_NE(hash(BigNum(1.5, 300)), hash(BigNum(1.5, 301)));
+        CHECK_NE(hash(BigNum(1.5, 300)), hash(BigNum(-1.5, 300)));
+        CHECK_NE(hash(BigNum::inf()), hash(-BigNum::inf()));
+
+        std::unordered_map<BigNum, int> memo;
+        memo[BigNum(0.0)] = 1;
+        memo[BigNum(-0.0)] += 1;
+        memo[BigNum("1e1000")] = 3;
+        CHECK_EQ(memo.size(), 2);
+        CHECK_EQ(memo[BigNum(0.0)], 2);
+        CHECK_EQ(memo.at(BigNum(1.0, 1000)), 3);
+    }
+
+    TEST_CASE("Quantized hashing shares nearby values") {
+        BigNumQuantizedHash hash{3};
+        BigNumQuantizedEqual equal{3};
+        const BigNum a(1.2345, 500);
+        const BigNum b(1.2349, 500);
+        CHECK(equal(a, b));
+        CHECK_EQ(hash(a), hash(b));
+        CHECK_FALSE(equal(a, BigNum(1.2445, 500)));
+        CHECK_FALSE(equal(a, BigNum(1.2345, 501)));
+        CHECK_FALSE(equal(a, -a));
+        CHECK(equal(BigNum(0.0), BigNum(-0.0)));
+        CHECK(equal(BigNum::nan(), BigNum::nan()));
+        CHECK_FALSE(equal(BigNum::inf(), -BigNum::inf()));
+        CHECK_FALSE(equal(BigNum::inf(), BigNum::max()));
+        // Fractions are quantized relative to their own magnitude
+        CHECK(equal(BigNum(0.0012345), BigNum(0.0012349)));
+        CHECK_FALSE(equal(BigNum(0.0012345), BigNum(0.012345)));
+        CHECK_FALSE(equal(BigNum(0.001), BigNum(0.0)));
+        CHECK(equal(BigNum(5e-320), BigNum(5e-320)));
+        CHECK_FALSE(equal(BigNum(5e-320), BigNum(5e-319)));
+
+        std::unordered_map<BigNum, int, BigNumQuantizedHash, BigNumQuantizedEqual>
+            cache(16, BigNumQuantizedHash{4}, BigNumQuantizedEqual{4});
+        cache[BigNum(3.14159, 80)] = 1;
+        CHECK(cache.contains(BigNum(3.14161, 80)));
+        CHECK_FALSE(cache.contains(BigNum(3.1426, 80)));
+    }
+}
+
+TEST_SUITE("Sort Tests") {
+    TEST_CASE("Sort keys follow operator<=>") {
+        std::vector<BigNum> values = {
+            -BigNum::inf(), BigNum::min(), BigNum(-5.0, 1000), BigNum(-9.0, 3),
+            BigNum(-1.0, 3), BigNum(-2.0), BigNum(-0.5), BigNum(0.0),
+            BigNum(0.25), BigNum(1.0), BigNum(7.0), BigNum(1.5, 40),
+            BigNum(1.0, std::numeric_limits<uintmax_t>::max() / 2 + 1),
+            BigNum::max(), BigNum::inf(), BigNum::nan()};
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            const BigNum::SortKey key = values[i].sort_key();
+            std::array<std::byte, 16> bytes;
+            key.to_bytes(bytes);
+            CHECK(BigNum::SortKey::from_bytes(bytes) == key);
+            if (!values[i].is_nan()) {
+                CHECK_EQ(BigNum::from_sort_key(key), values[i]);
+            }
+            for (std::size_t j = 0; j < values.size(); ++j) {
+                std::array<std::byte, 16> other;
+                values[j].sort_key().to_bytes(other);
+                const int byte_order = std::memcmp(bytes.data(), other.data(), 16);
+                CHECK_EQ(key < values[j].sort_key(), i < j);
+                CHECK_EQ(byte_order < 0, i < j);
+            }
+        }
+        CHECK(BigNum(-0.0).sort_key() == BigNum(0.0).sort_key());
+        CHECK(BigNum::from_sort_key(BigNum::nan().sort_key()).is_nan());
+    }
+
+    TEST_CASE("Radix sort matches std::stable_sort") {
+        std::mt19937_64 rng(11);
+        std::uniform_real_distribution<double> mant(1.0, 10.0);
+        for (std::size_t n : {0, 1, 100, 5000}) {
+            std::vector<BigNum> values;
+            std::vector<std::size_t> ids;
+            for (std::size_t i = 0; i < n; ++i) {
+                double sign = (rng() & 1) ? 1.0 : -1.0;
+                switch (rng() % 8) {
+                case 0:
+                    values.push_back(BigNum(sign * static_cast<double>(rng() % 4)));
+                    break;
+                case 1:
+                    values.push_back(rng() & 2   ? BigNum::nan()
+                                     : sign > 0 ? BigNum::inf()
+                                                : -BigNum::inf());
+                    break;
+                default:
+                    values.push_back(BigNum(sign * mant(rng), rng() % 64));
+                }
+                ids.push_back(i);
+            }
+            std::vector<std::size_t> expected = ids;
+            std::stable_sort(expected.begin(), expected.end(),
+                             [&](std::size_t a, std::size_t b) {
+                                 return values[a].sort_key() < values[b].sort_key();
+                             });
+            std::vector<BigNum> keys = values;
+            radix_sort(std::span<BigNum>(keys), std::span<std::size_t>(ids));
+            CHECK_EQ(ids, expected);
+            for (std::size_t i = 0; i < n; ++i) {
+                CHECK_EQ(std::memcmp(&keys[i], &values[ids[i]], sizeof(BigNum)), 0);
+                if (i > 0 && !keys[i].is_nan()) {
+                    CHECK_FALSE(keys[i] < keys[i - 1]);
+                }
+            }
+            radix_sort(values);
+            for (std::size_t i = 0; i < n; ++i) {
+                CHECK_EQ(std::memcmp(&values[i], &keys[i], sizeof(BigNum)), 0);
+            }
+        }
+    }
+}
+
+TEST_SUITE("Leaderboard Tests") {
+    TEST_CASE("Matches a sorted reference") {
+        using Board = BigNumLeaderboard<std::uint32_t>;
+        Board board(Board::NaNPolicy::Last);
+        std::vector<std::optional<BigNum>> scores(500);
+        std::mt19937_64 rng(5);
+        std::uniform_real_distribution<double> mant(1.0, 10.0);
+        for (int step = 0; step < 20000; ++step) {
+            const auto id = static_cast<std::uint32_t>(rng() % scores.size());
+            switch (rng() % 4) {
+            case 0:
+                CHECK_EQ(board.erase(id), scores[id].has_value());
+                scores[id].reset();
+                break;
+            case 1: {
+                // Few distinct scores, so that ties are common
+                BigNum score = rng() % 16 == 0 ? BigNum::nan()
+                                               : BigNum(mant(rng) > 5 ? 1.0 : -1.0,
+                                                        rng() % 4);
+                CHECK_EQ(board.insert(id, score), !scores[id].has_value());
+                scores[id] = scores[id].value_or(score);
+                break;
+            }
+            default: {
+                BigNum score((rng() & 1 ? 1.0 : -1.0) * mant(rng), rng() % 40);
+                CHECK(board.update(id, score));
+                scores[id] = score;
+            }
+            }
+        }
+
+        // NaN last, then descending score, then ascending id
+        std::vector<std::uint32_t> expected;
+        for (std::uint32_t id = 0; id < scores.size(); ++id) {
+            if (scores[id]) {
+                expected.push_back(id);
+            }
+        }
+        std::stable_sort(expected.begin(), expected.end(), [&](auto a, auto b) {
+            if (scores[a]->is_nan() || scores[b]->is_nan()) {
+                return !scores[a]->is_nan() && scores[b]->is_nan();
+            }
+            return *scores[a] > *scores[b];
+        });
+        REQUIRE_EQ(board.size(), expected.size());
+        const auto all = board.range(0, expected.size() + 10);
+        REQUIRE_EQ(all.size(), expected.size());
+        for (std::size_t r = 0; r < expected.size(); ++r) {
+            CHECK_EQ(all[r].id, expected[r]);
+            CHECK_EQ(board.rank(expected[r]), r);
+            CHECK_EQ(board.at_rank(r)->id, expected[r]);
+            // rank_of() gives the rank of the first entry with this score
+            if (!scores[expected[r]]->is_nan()) {
+                std::size_t first = r;
+                while (first > 0 && *scores[expected[first - 1]] == *scores[expected[r]]) {
+                    --first;
+                }
+                CHECK_EQ(board.rank_of(*scores[expected[r]]), first);
+            }
+        }
+        CHECK_FALSE(board.at_rank(expected.size()).has_value());
+        CHECK_FALSE(board.rank(100000).has_value());
+        const auto middle = board.range(10, 20);
+        REQUIRE_EQ(middle.size(), 10);
+        CHECK_EQ(middle.front().id, expected[10]);
+        CHECK_EQ(board.top(3).size(), 3);
+    }
+
+    TEST_CASE("NaN policy and ties") {
+        BigNumLeaderboard<int> board;
+        CHECK_FALSE(board.insert(1, BigNum::nan()));
+        CHECK(board.insert(1, BigNum(5.0)));
+        CHECK_FALSE(board.update(1, BigNum::nan()));
+        CHECK_EQ(board.score(1), BigNum(5.0));
+        CHECK(board.insert(3, BigNum(0.0)));
+        CHECK(board.insert(2, BigNum(-0.0)));
+        CHECK(board.insert(4, -BigNum::inf()));
+        CHECK_EQ(board.rank(2), 1);
+        CHECK_EQ(board.rank(3), 2);
+        CHECK_EQ(board.rank_of(BigNum(0.0)), 1);
+        CHECK_EQ(board.rank_of(BigNum(9.0)), 0);
+        CHECK_EQ(board.rank_of(BigNum::min()), 3);
+        board.clear();
+        CHECK_EQ(board.size(), 0);
+        CHECK(board.top(5).empty());
+    }
+
+    TEST_CASE("Concurrent readers see consistent rankings") {
+        BigNumLeaderboard<> board;
+        for (std::uint64_t id = 0; id < 1000; ++id) {
+            board.insert(id, BigNum(static_cast<double>(id)));
+        }
+        std::atomic<bool> done{false};
+        std::atomic<int> unordered{0};
+        {
+            std::vector<std::jthread> readers;
+            for (int t = 0; t < 4; ++t) {
+                readers.emplace_back([&] {
+                    while (!done) {
+                        const auto top = board.top(50);
+                        for (std::size_t i = 1; i < top.size(); ++i) {
+                            unordered += top[i].score > top[i - 1].score;
+                        }
+                    }
+                });
+            }
+            for (int i = 0; i < 20000; ++i) {
+                const std::uint64_t id = static_cast<std::uint64_t>(i) % 1000;
+                board.update(id, BigNum(static_cast<double>(i % 3000)));
+            }
+            done = true;
+        }
+        CHECK_EQ(unordered.load(), 0);
+        CHECK_EQ(board.size(), 1000);
+    }
+}
+
+TEST_SUITE("Atomic Tests") {
+    TEST_CASE("Single-threaded operations") {
+        AtomicBigNum a(BigNum("1e100"));
+        CHECK_EQ(a.load(), BigNum("1e100"));
+        CHECK_EQ(a.fetch_add(BigNum("1e100")), BigNum("1e100"));
+        CHECK_EQ(a.load(), BigNum("2e100"));
+        CHECK_EQ(a.fetch_mul(BigNum("1e50")), BigNum("2e100"));
+        CHECK_EQ(a.fetch_max(BigNum("1e10")), BigNum("2e150"));
+        CHECK_EQ(a.load(), BigNum("2e150"));
+        a.fetch_max(BigNum::nan());
+        CHECK_EQ(a.load(), BigNum("2e150"));
+        CHECK_EQ(a.exchange(BigNum(5.0)), BigNum("2e150"));
+
+        BigNum expected(4.0);
+        CHECK_FALSE(a.compare_exchange_strong(expected, BigNum(7.0)));
+        CHECK_EQ(expected, BigNum(5.0));
+        CHECK(a.compare_exchange_strong(expected, BigNum(7.0)));
+        a.store(BigNum(-0.0));
+        CHECK(std::signbit(a.load().getM()));
+        CHECK_EQ(AtomicBigNum().load(), BigNum());
+    }
+
+    TEST_CASE("Concurrent updates are not lost") {
+        constexpr int THREADS = 8;
+        constexpr int UPDATES = 5000;
+        AtomicBigNum sum;
+        AtomicBigNum best;
+        AtomicBigNum product(BigNum(1.0));
+        {
+            std::vector<std::jthread> pool;
+            for (int t = 0; t < THREADS; ++t) {
+                pool.emplace_back([&, t] {
+                    for (int i = 0; i < UPDATES; ++i) {
+                        sum.fetch_add(BigNum(1.0));
+                        best.fetch_max(BigNum(static_cast<double>(t * UPDATES + i)));
+                        if (i < 10) {
+                            product.fetch_mul(BigNum("1e10"));
+                        }
+                    }
+                });
+            }
+        }
+        CHECK_EQ(sum.load(), BigNum(THREADS * UPDATES));
+        CHECK_EQ(best.load(), BigNum(THREADS * UPDATES - 1));
+        CHECK_EQ(product.load(), BigNum("1e800"));
+    }
+}
+
+TEST_SUITE("Accumulator Tests") {
+    TEST_CASE("Small addends are not dropped") {
+        BigNum balance(1.0, 30);
+        BigNumAccumulator acc(balance);
+        for (int i = 0; i < 10000000; ++i) {
+            acc += BigNum(1.0, 10);
+        }
+        // 1e30 + 1e7 * 1e10
+        CHECK_EQ(acc.value().getE(), 30);
+        CHECK_EQ(acc.value().getM(), doctest::Approx(1.0000000000001).epsilon(1e-15));
+        for (int i = 0; i < 1000; ++i) {
+            balance += BigNum(1.0, 10);
+        }
+        CHECK_EQ(balance, BigNum(1.0, 30));
+    }
+
+    TEST_CASE("Matches exact sums") {
+        BigNumAccumulator acc;
+        CHECK_EQ(acc.value(), BigNum());
+        for (int i = 1; i <= 1000; ++i) {
+            acc += BigNum(static_cast<double>(i));
+        }
+        CHECK_EQ(acc.value(), BigNum(500500.0));
+        acc -= BigNum(500500.0);
+        CHECK_EQ(acc.value(), BigNum(0.0));
+
+        // Exponents spread over more buckets than the accumulator keeps
+        std::mt19937_64 rng(11);
+        BigNumAccumulator spread(true);
+        std::vector<BigNum> values;
+        for (int i = 0; i < 1000; ++i) {
+            values.push_back(BigNum(1.0 + static_cast<double>(rng() % 9),
+                                    200 + rng() % 400));
+            spread += values.back();
+        }
+        BigNum expected = reduce_sum(values, 1);
+        CHECK_EQ(spread.value().getE(), expected.getE());
+        CHECK_EQ(spread.value().getM(), doctest::Approx(expected.getM()).epsilon(1e-15));
+
+        acc.reset(BigNum(7.0, 100));
+        acc += BigNum(3.0, 100);
+        CHECK_EQ(acc.value(), BigNum(1.0, 101));
+    }
+
+    TEST_CASE("Compensated summation") {
+        BigNumAccumulator plain, kahan(true);
+        for (int i = 0; i < 1000000; ++i) {
+            plain += BigNum(1.1, 20);
+            kahan += BigNum(1.1, 20);
+        }
+        CHECK_EQ(kahan.value().getE(), 26);
+        CHECK_EQ(kahan.value().getM(), doctest::Approx(1.1).epsilon(1e-16));
+        CHECK(std::abs(plain.value().getM() - 1.1) >=
+              std::abs(kahan.value().getM() - 1.1));
+    }
+
+    TEST_CASE("Special values and saturation") {
+        BigNumAccumulator acc;
+        acc += BigNum(5.0, 50);
+        acc += BigNum::inf();
+        CHECK(acc.value().is_inf());
+        acc -= BigNum::inf();
+        CHECK(acc.value().is_nan());
+        acc.clear();
+        for (int i = 0; i < 20; ++i) {
+            acc += BigNum::max();
+        }
+        CHECK_EQ(acc.value(), BigNum::max());
+        BigNum converted = acc;
+        CHECK_EQ(converted, BigNum::max());
+    }
+}
+
+TEST_SUITE("Fused Operation Tests") {
+    std::vector<BigNum> fused_inputs(std::size_t n, std::uint64_t seed) {
+        std::mt19937_64 rng(seed);
+        std::uniform_real_distribution<double> mant(1.0, 10.0);
+        std::vector<BigNum> values;
+        for (std::size_t i = 0; i < n; ++i) {
+            double sign = (rng() & 1) ? 1.0 : -1.0;
+            switch (rng() % 8) {
+            case 0:
+                values.push_back(BigNum(sign * mant(rng) * 100.0));
+                break;
+            case 1:
+                values.push_back(rng() % 2 ? BigNum::inf() : BigNum::nan());
+                break;
+            case 2:
+                values.push_back(BigNum(0.0));
+                break;
+            case 3:
+                values.push_back(rng() % 2 ? BigNum::max() : BigNum::min());
+                break;
+            default:
+                values.push_back(BigNum(sign * mant(rng), rng() % 60));
+            }
+        }
+        return values;
+    }
+
+    bool same(const BigNum &a, const BigNum &b) {
+        return (a.is_nan() && b.is_nan()) ||
+               (std::bit_cast<std::uint64_t>(a.getM()) ==
+                    std::bit_cast<std::uint64_t>(b.getM()) &&
+                a.getE() == b.getE());
+    }
+
+    TEST_CASE("Scalar fused operations") {
+        BigNum a(3.0, 100), b(4.0, 50), c(5.0, 149);
+        CHECK_EQ(BigNum::fma(a, b, c), BigNum(1.25, 151));
+        CHECK_EQ(BigNum::fma(BigNum(3.0), BigNum(4.0), BigNum(5.0)), BigNum(17.0));
+        CHECK_EQ(BigNum::fma(BigNum(0.0), b, c), c);
+        CHECK(BigNum::fma(BigNum::nan(), b, c).is_nan());
+        CHECK(same(BigNum::fma(BigNum::max(), b, c), BigNum::max() * b + c));
+
+        // balance + rate * dt
+        BigNum balance(1.0, 30), rate(2.5, 20);
+        BigNum r = balance.scaled_add(rate, 0.016);
+        CHECK_EQ(r.getE(), 30);
+        CHECK_EQ(r.getM(), doctest::Approx(1.0000000000004));
+        CHECK_EQ(BigNum(100.0).scaled_add(BigNum(50.0), 2.0), BigNum(200.0));
+        CHECK_EQ(balance.scaled_add(rate, 0.0), balance);
+        CHECK_EQ(BigNum(100.0).scaled_add(BigNum(50.0), -2.0), BigNum(0.0));
+
+        // value * growth^t
+        BigNum g = BigNum(2.0, 40).mul_pow(1.07, 100.0);
+        CHECK_EQ(g.getE(), 43);
+        CHECK_EQ(g.getM(), doctest::Approx(2.0 * std::pow(1.07, 100.0) / 1000.0));
+        CHECK_EQ(BigNum(2.0, 40).mul_pow(BigNum(2.0, 3), 10.0),
+                 BigNum(2.0, 40) * BigNum(2.0, 3).pow(10.0));
+        CHECK_EQ(BigNum(5.0, 40).mul_pow(0.1, 30.0).getE(), 10);
+        CHECK_EQ(BigNum(5.0, 4).mul_pow(0.1, 30.0).getM(), doctest::Approx(5e-26));
+        CHECK_EQ(BigNum(2.0, 40).mul_pow(BigNum(-2.0), 2.0), BigNum(8.0, 40));
+    }
+
+    TEST_CASE("Batch fused operations match the scalar ones") {
+        constexpr std::size_t n = 515;
+        BigNumArray a(fused_inputs(n, 1)), b(fused_inputs(n, 2)), c(fused_inputs(n, 3));
+        BigNumArray out(n);
+        BigNum k(7.5, 12);
+
+        BigNumArray::fma(a, b, c, out);
+        for (std::size_t i = 0; i < n; ++i) {
+            CHECK(same(out[i], BigNum::fma(a[i], b[i], c[i])));
+        }
+        BigNumArray::fma(a, k, c, out);
+        for (std::size_t i = 0; i < n; ++i) {
+            CHECK(same(out[i], BigNum::fma(a[i], k, c[i])));
+        }
+        for (double factor : {0.016, 1.0, 250.0, -3e-7, 0.0}) {
+            BigNumArray::scaled_add(a, b, factor, out);
+            for (std::size_t i = 0; i < n; ++i) {
+                CHECK(same(out[i], a[i].scaled_add(b[i], factor)));
+            }
+        }
+        for (double power : {0.5, 3.0, 250.0, -2.0}) {
+            BigNumArray::mul_pow(a, 1.07, power, out);
+            for (std::size_t i = 0; i < n; ++i) {
+                CHECK(same(out[i], a[i].mul_pow(1.07, power)));
+            }
+            BigNumArray::mul_pow(a, k, power, out);
+            for (std::size_t i = 0; i < n; ++i) {
+                CHECK(same(out[i], a[i].mul_pow(k, power)));
+            }
+        }
+
+        // In place: balance += rate * dt
+        BigNumArray balance = c;
+        BigNumArray::scaled_add(balance, b, 0.016, balance);
+        for (std::size_t i = 0; i < n; ++i) {
+            CHECK(same(balance[i], c[i].scaled_add(b[i], 0.016)));
+        }
+    }
+}
+
+TEST_SUITE("Generator Chain Tests") {
+    // Tick-by-tick simulation, the way offline progress was computed before
+    void simulate(std::vector<double> &amounts, const std::vector<double> &rates,
+                  double seconds, int ticks) {
+        const double dt = seconds / ticks;
+        for (int i = 0; i < ticks; ++i) {
+            for (std::size_t k = 0; k < rates.size(); ++k) {
+                amounts[k] += rates[k] * amounts[k + 1] * dt;
+            }
+        }
+    }
+
+    TEST_CASE("Polynomial terms") {
+        std::vector<BigNum> rates = {BigNum(1.0), BigNum(1.0)};
+        GeneratorChain chain(rates);
+        CHECK_EQ(chain.tiers(), 3);
+        std::vector<BigNum> amounts = {BigNum(0.0), BigNum(0.0), BigNum(1.0)};
+        chain.advance(amounts, 10.0);
+        CHECK_EQ(amounts[2], BigNum(1.0));
+        CHECK_EQ(amounts[1], BigNum(10.0));
+        CHECK_EQ(amounts[0], BigNum(50.0)); // t^2 / 2
+
+        // a0 + r1 a1 t + r1 r2 a2 t^2 / 2 + r1 r2 r3 a3 t^3 / 6
+        rates = {BigNum(2.0), BigNum(3.0), BigNum(4.0)};
+        amounts = {BigNum(5.0), BigNum(7.0), BigNum(11.0), BigNum(13.0)};
+        GeneratorChain(rates).advance(amounts, 30.0);
+        CHECK_EQ(amounts[0].getM(),
+                 doctest::Approx((5.0 + 2 * 7 * 30.0 + 6 * 11 * 900.0 / 2 +
+                                  24 * 13 * 27000.0 / 6) /
+                                 1e6));
+        CHECK_EQ(amounts[0].getE(), 6);
+        CHECK_EQ(amounts[3], BigNum(13.0));
+    }
+
+    TEST_CASE("Matches a fine-grained simulation") {
+        std::vector<double> rates = {1.5, 0.25, 2.0, 0.75};
+        std::vector<double> start = {0.0, 3.0, 0.0, 1.0, 2.0};
+        std::vector<double> simulated = start;
+        simulate(simulated, rates, 100.0, 200000);
+
+        std::vector<BigNum> amounts;
+        for (double a : start) {
+            amounts.push_back(BigNum(a));
+        }
+        // Rates as doubles: BigNum(1.5) would round to 2
+        GeneratorChain chain(rates);
+        chain.advance(amounts, 100.0);
+        for (std::size_t k = 0; k < amounts.size(); ++k) {
+            double actual = amounts[k].getM() * std::pow(10.0, amounts[k].getE());
+            CHECK_EQ(actual, doctest::Approx(simulated[k]).epsilon(1e-3));
+        }
+    }
+
+    TEST_CASE("Huge times and batches") {
+        std::vector<BigNum> rates(20, BigNum(1.0, 50));
+        GeneratorChain chain(rates);
+        std::vector<BigNum> amounts(2 * chain.tiers(), BigNum(0.0));
+        amounts[chain.tiers() - 1] = BigNum(1.0);
+        amounts[2 * chain.tiers() - 1] = BigNum(1.0);
+        std::vector<double> seconds = {1e6, 0.0};
+        chain.advance(amounts, seconds);
+        // 1e(50 * 20) * 1e(6 * 20) / 20! = 4.11e1101
+        CHECK_EQ(amounts[0].getE(), 1101);
+        CHECK_EQ(amounts[0].getM(), doctest::Approx(1e19 / 2432902008176640000.0));
+        CHECK_EQ(amounts[chain.tiers()], BigNum(0.0));
+
+        CHECK_THROWS_AS(chain.advance(std::span(amounts).first(chain.tiers()), -1.0),
+                        std::domain_error);
+        std::vector<BigNum> bad = {BigNum::nan()};
+        CHECK_THROWS_AS(GeneratorChain{bad}, std::invalid_argument);
+    }
+}
+
+TEST_SUITE("Fast Math Tests") {
+    // Error of x in units in the last place of the reference
+    double ulp_error(double x, long double ref) {
+        const double r = static_cast<double>(ref);
+        const double ulp = std::nextafter(std::fabs(r), INFINITY) - std::fabs(r);
+        return static_cast<double>(std::fabs(static_cast<long double>(x) - ref) / ulp);
+    }
+
+    TEST_CASE("Kernels stay within their error bounds") {
+        std::mt19937_64 rng(21);
+        double exp_err = 0, log_err = 0;
+        std::uniform_real_distribution<double> unit(-1.0, 1.0), mant(1.0, 10.0),
+            near_one(0.99, 1.01), wide(-300.0, 300.0);
+        for (int i = 0; i < 200000; ++i) {
+            const double x = unit(rng);
+            exp_err = std::max(exp_err, ulp_error(FastMath::exp10(x),
+                                                  powl(10.0L, static_cast<long double>(x))));
+            for (double y : {mant(rng), near_one(rng), std::pow(10.0, wide(rng))}) {
+                if (y != 1.0) {
+                    log_err = std::max(log_err, ulp_error(FastMath::log10(y),
+                                                          log10l(static_cast<long double>(y))));
+                }
+            }
+        }
+        CHECK(exp_err <= FastMath::EXP10_MAX_ULP);
+        CHECK(log_err <= FastMath::LOG10_MAX_ULP);
+
+        CHECK_EQ(FastMath::exp10(0.0), 1.0);
+        CHECK_EQ(FastMath::log10(1.0), 0.0);
+        CHECK_EQ(FastMath::log10(10.0), doctest::Approx(1.0));
+        CHECK_EQ(FastMath::exp10(5.0), 1e5);
+        CHECK_EQ(FastMath::log10(1e-310), std::log10(1e-310));
+        CHECK(std::isnan(FastMath::log10(-1.0)));
+        CHECK(std::isinf(FastMath::log10(INFINITY)));
+        CHECK(std::isnan(FastMath::exp10(NAN)));
+    }
+
+    TEST_CASE("Fast BigNum functions agree with the exact ones") {
+        for (BigNum v : {BigNum(2.0), BigNum(3.7, 12), BigNum(1.5, 1000), BigNum(9.99, 123456),
+                         BigNum(0.25), BigNum(1.0)}) {
+            for (double power : {0.5, 2.0, 3.3, 100.0}) {
+                const BigNum fast = v.fast_pow(power), exact = v.pow(power);
+                CHECK_EQ(fast.getE(), exact.getE());
+                CHECK_EQ(fast.getM(), doctest::Approx(exact.getM()).epsilon(1e-12));
+            }
+            for (intmax_t n : {2, 3, 7}) {
+                CHECK_EQ(v.fast_root(n).getM(), doctest::Approx(v.root(n).getM()).epsilon(1e-12));
+            }
+            CHECK_EQ(*v.fast_log10(), doctest::Approx(*v.log10()).epsilon(1e-14));
+        }
+        CHECK(BigNum(-8.0).fast_root(3).is_nan() == BigNum(-8.0).root(3).is_nan());
+        CHECK(BigNum::nan().fast_pow(2.0).is_nan());
+        CHECK_FALSE(BigNum(0.0).fast_log10().has_value() != BigNum(0.0).log10().has_value());
+
+#ifdef BIGNUM_FAST_MATH
+        CHECK_EQ(BigNum::exp(50).getE(), 21);
+        CHECK_EQ(BigNum::exp(50).getM(), doctest::Approx(5.184705528587072));
+        CHECK_EQ(BigNum::exp(1000).getE(), 434);
+        CHECK_EQ(BigNum::exp(1000).getM(), doctest::Approx(1.9700711140170469));
+#else
+        // Without BIGNUM_FAST_MATH exp() keeps its original definition
+        for (uintmax_t n : {0, 1, 50, 1000}) {
+            CHECK_EQ(BigNum::exp(n), BigNum(std::exp(1)).pow(static_cast<intmax_t>(n)));
+        }
+#endif
+    }
+
+    TEST_CASE("Batch kernels match the scalar ones") {
+        std::mt19937_64 rng(22);
+        std::uniform_real_distribution<double> mant(1.0, 10.0);
+        std::vector<BigNum> values;
+        for (std::size_t i = 0; i < 515; ++i) {
+            switch (rng() % 10) {
+            case 0:
+                values.push_back(BigNum::nan());
+                break;
+            case 1:
+                values.push_back(BigNum(mant(rng) / 100.0));
+                break;
+            case 2:
+                values.push_back(BigNum(0.0));
+                break;
+            case 3:
+                values.push_back(BigNum::max());
+                break;
+            default:
+                values.push_back(BigNum(mant(rng), rng() % 100000));
+            }
+        }
+        BigNumArray a(values), out(values.size());
+        auto close = [](const BigNum &x, const BigNum &y) {
+            if (x.is_nan() || y.is_nan() || x.is_inf() || y.is_inf()) {
+                return x.is_nan() == y.is_nan() && x.is_inf() == y.is_inf();
+            }
+            return x.getE() == y.getE() && std::fabs(x.getM() - y.getM()) <= 1e-9 * x.getM();
+        };
+        for (double power : {0.5, 2.0, 1.75, 0.001}) {
+            BigNumArray::pow(a, power, out);
+            for (std::size_t i = 0; i < values.size(); ++i) {
+                CHECK(close(out[i], values[i].fast_pow(power)));
+            }
+        }
+        for (intmax_t n : {2, 5}) {
+            BigNumArray::root(a, n, out);
+            for (std::size_t i = 0; i < values.size(); ++i) {
+                CHECK(close(out[i], values[i].fast_root(n)));
+            }
+        }
+        std::vector<double> logs(values.size());
+        BigNumArray::log10(a, logs);
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            const std::optional<double> log = values[i].fast_log10();
+            REQUIRE(log.has_value());
+            if (std::isfinite(*log)) {
+                CHECK_EQ(logs[i], doctest::Approx(*log).epsilon(1e-15));
+            } else {
+                CHECK_EQ(std::isnan(logs[i]), std::isnan(*log));
+                CHECK_EQ(std::isinf(logs[i]), std::isinf(*log));
+            }
+        }
+    }
+}
+
+TEST_SUITE("Double-Double Tests") {
+    // Prints integers up to 40 digits in full
+    const BigNumContext wide{40, 3, '.', ','};
+
+    TEST_CASE("Ledgers do not drift") {
+        // 1e20 + 1e6 payments of 1: BigNum drops every payment
+        BigNumDD balance(BigNum(1.0, 20));
+        BigNum coarse(1.0, 20);
+        for (int i = 0; i < 1000000; ++i) {
+            balance += BigNumDD(1);
+            coarse += BigNum(1.0);
+        }
+        CHECK_EQ(balance.to_string(wide), "100000000000001000000");
+        CHECK_EQ(coarse, BigNum(1.0, 20));
+        BigNumDD payments(BigNum(1.0, 20));
+        for (int i = 0; i < 1000; ++i) {
+            payments += BigNumDD("1234567.8925");
+        }
+        CHECK_EQ(payments.to_string(wide), "100000000001234568000");
+
+        CHECK_EQ((BigNumDD("1e29") + BigNumDD(1)).to_string(wide),
+                 "100000000000000000000000000001");
+        CHECK_EQ((BigNumDD("1e29") + BigNumDD(1)).serialize(),
+                 "1.00000000000000000000000000001e29");
+        CHECK_EQ(BigNumDD("1e30") + BigNumDD(1), BigNumDD("1e30"));
+        CHECK_EQ(BigNumDD(3).pow(60).to_string(wide), "42391158275216203514294433201");
+        CHECK_EQ(BigNumDD("2e40").sqrt().to_string(wide), "141421356237309504880");
+        CHECK_EQ((BigNumDD(1) / BigNumDD(7)).to_string(30), "0.142857142857142857142857142857");
+        CHECK_EQ((BigNumDD("1e50") / BigNumDD(7) * BigNumDD(7)).to_string(28),
+                 "1.0000000000000000000000000000e50");
+    }
+
+    TEST_CASE("Strings round-trip every digit") {
+        std::mt19937_64 rng(22);
+        for (int i = 0; i < 1000; ++i) {
+            std::string text = std::to_string(1 + rng() % 9) + ".";
+            for (int j = 0; j < BigNumDD::DIGITS - 1; ++j) {
+                text += static_cast<char>('0' + rng() % 10);
+            }
+            text += "e" + std::to_string(30 + rng() % 100000);
+            if (rng() % 2) {
+                text = "-" + text;
+            }
+            const BigNumDD value(text);
+            CHECK_EQ(value.serialize(), text);
+            CHECK_EQ(BigNumDD::deserialize(value.serialize()), value);
+        }
+
+        CHECK_EQ(BigNumDD("1,234,567").to_pretty_string(), "1,234,567");
+        CHECK_EQ(BigNumDD("-0.000123456").to_string(9), "-0.000123456");
+        CHECK_EQ(BigNumDD("0.000123456").to_string(5), "0.00012");
+        CHECK_EQ(BigNumDD("-2.5e100").to_string(), "-2.500e100");
+        CHECK_EQ(BigNumDD("9.99999e100").to_string(2), "9.99e100");
+        CHECK_EQ(BigNumDD("123456789012345678901234567890123").to_string(),
+                 "1.234e32");
+        CHECK_EQ(BigNumDD(0.0).to_string(), "0");
+        CHECK_EQ(BigNumDD::nan().to_string(), "nan");
+        CHECK_EQ((-BigNumDD::inf()).to_string(), "-inf");
+
+        BigNumDD parsed;
+        std::string_view bad = "x1";
+        CHECK_EQ(BigNumDD::from_chars(bad.data(), bad.data() + bad.size(), parsed).ec,
+                 std::errc::invalid_argument);
+        CHECK_THROWS_AS(BigNumDD("1e"), std::invalid_argument);
+    }
+
+    TEST_CASE("Arithmetic and conversions") {
+        std::mt19937_64 rng(23);
+        std::uniform_real_distribution<double> mant(1.0, 10.0);
+        for (int i = 0; i < 1000; ++i) {
+            const BigNum a(mant(rng), 100 + rng() % 1000), b(-mant(rng), rng() % 1000);
+            CHECK_EQ(BigNumDD(a).to_bignum(), a);
+            CHECK_EQ(BigNumDD(a) < BigNumDD(b), a < b);
+            CHECK_EQ(BigNumDD(a) > BigNumDD(b), a > b);
+            const BigNum product = (BigNumDD(a) * BigNumDD(b)).to_bignum();
+            CHECK_EQ(product.getE(), (a * b).getE());
+            CHECK_EQ(product.getM(), doctest::Approx((a * b).getM()));
+            // a / b * b within the last digits, when a / b is not rounded to
+            // an integer
+            const BigNum c(-mant(rng), a.getE() - 31 - rng() % 50);
+            const BigNumDD q = BigNumDD(a) / BigNumDD(c) * BigNumDD(c);
+            CHECK((q - BigNumDD(a)).abs() * BigNumDD(BigNum(1.0, 28)) <= BigNumDD(a));
+        }
+
+        CHECK(BigNumDD::nan() != BigNumDD::nan());
+        CHECK((BigNumDD::inf() - BigNumDD::inf()).is_nan());
+        CHECK((BigNumDD(1) / BigNumDD(0.0)).is_nan());
+        CHECK_EQ(BigNumDD::inf() + BigNumDD(5), BigNumDD::inf());
+        CHECK_EQ(BigNumDD::max() * BigNumDD(2), BigNumDD::max());
+        CHECK_EQ(BigNumDD::min() * BigNumDD(2), BigNumDD::min());
+        CHECK_EQ(BigNumDD::max() + BigNumDD(1), BigNumDD::max());
+        CHECK_EQ(BigNumDD::max().to_bignum(), BigNum::max());
+        CHECK_EQ(BigNumDD(BigNum(1.0, 10)) / BigNumDD(BigNum(1.0, 400)), BigNumDD(0.0));
+        CHECK_EQ(BigNumDD(5) - BigNumDD(5), BigNumDD(0.0));
+        CHECK_THROWS_AS(BigNumDD(-4).sqrt(), std::domain_error);
+
+        BigNumDD counter(9);
+        CHECK_EQ(counter++, BigNumDD(9));
+        CHECK_EQ(++counter, BigNumDD(11));
+        CHECK_EQ(--counter, BigNumDD(10));
+
+        // long double is only wider than double on some platforms
+        if constexpr (BigNumLD::DIGITS >= 18) {
+            CHECK_EQ((BigNumLD("1e17") + BigNumLD(1)).to_string(wide), "100000000000000001");
+        }
+        CHECK_EQ(BigNumLD("12345").to_string(), "12345");
+    }
+}
+
+#ifdef __cpp_lib_expected
+TEST_SUITE("Error Code Tests") {
+    static_assert(noexcept(std::declval<const BigNum &>().try_pow(2.0)));
+    static_assert(noexcept(std::declval<const BigNum &>().try_root(2)));
+    static_assert(noexcept(BigNum::try_parse("1")));
+
+    // The message of the exception that the throwing call raises
+    template <typename F> std::string thrown_message(F &&f) {
+        try {
+            f();
+        } catch (const std::exception &e) {
+            return e.what();
+        }
+        return "";
+    }
+
+    TEST_CASE("try_pow and try_root report domain errors") {
+        CHECK(BigNum(0.0).try_pow(-1.0).error() == BigNumError::ZeroToNegativePower);
+        CHECK(BigNum(-8.0).try_pow(0.5).error() == BigNumError::ComplexPower);
+        CHECK(BigNum(2.0).try_root(0).error() == BigNumError::ZerothRoot);
+        CHECK(BigNum(-16.0).try_root(2).error() == BigNumError::EvenRootOfNegative);
+
+        CHECK_EQ(BigNum(0.0).try_pow(0.0).value(), BigNum(1.0));
+        CHECK_EQ(BigNum(-8.0).try_pow(3).value(), BigNum(-512.0));
+        CHECK_EQ(BigNum(-27.0).try_root(3).value(), BigNum(-3.0));
+        CHECK_EQ(BigNum(0.0).try_root(2).value(), BigNum(0.0));
+
+        CHECK_EQ(thrown_message([] { return BigNum(0.0).pow(-1.0); }),
+                 error_message(BigNumError::ZeroToNegativePower));
+        CHECK_EQ(thrown_message([] { return BigNum(-8.0).pow(0.5); }),
+                 error_message(BigNumError::ComplexPower));
+        CHECK_EQ(thrown_message([] { return BigNum(2.0).root(0); }),
+                 error_message(BigNumError::ZerothRoot));
+        CHECK_EQ(thrown_message([] { return BigNum(-16.0).root(2); }),
+                 error_message(BigNumError::EvenRootOfNegative));
+
+        std::mt19937_64 rng(23);
+        std::uniform_real_distribution<double> mant(1.0, 10.0);
+        for (int i = 0; i < 1000; ++i) {
+            const BigNum x(i % 2 ? mant(rng) : -mant(rng), rng() % 100000);
+            const double power = (i % 4 < 2) ? std::round(mant(rng)) : mant(rng) - 5.0;
+            const intmax_t n = static_cast<intmax_t>(rng() % 9) - 4;
+            const auto p = x.try_pow(power);
+            const auto r = x.try_root(n);
+            CHECK(p.has_value() == (!x.is_negative() || power == std::round(power)));
+            CHECK(r.has_value() == (n != 0 && (!x.is_negative() || n % 2 != 0)));
+            if (p) {
+                CHECK_EQ(*p, x.pow(power));
+            }
+            if (r) {
+                CHECK_EQ(*r, x.root(n));
+            }
+        }
+    }
+
+    TEST_CASE("try_parse reports invalid text") {
+        CHECK_EQ(BigNum::try_parse("1.5e300").value(), BigNum("1.5e300"));
+        CHECK_EQ(BigNum::try_parse("-1,234,567").value(), BigNum(-1234567.0));
+        CHECK(BigNum::try_parse("nan").value().is_nan());
+        CHECK(BigNum::try_parse("12abc").error() == BigNumError::InvalidNumber);
+        CHECK(BigNum::try_parse("").error() == BigNumError::InvalidNumber);
+        CHECK(BigNum::try_parse("5e").error() == BigNumError::InvalidNumber);
+        CHECK(BigNum::try_parse("1e99999999999999999999999").error() ==
+              BigNumError::ExponentOutOfRange);
+
+        const BigNumContext european{10, 3, ',', '.'};
+        CHECK_EQ(BigNum::try_parse("1.234,5", european).value(), BigNum(1234.5));
+        CHECK(BigNum::try_parse("1,234.5", european).error() == BigNumError::InvalidNumber);
+
+        const BigNum v("-9.87654e12345");
+        CHECK_EQ(BigNum::try_parse(v.to_pretty_string(9)).value().to_string(9),
+                 v.to_string(9));
+        CHECK_EQ(BigNum::try_parse(v.serialize(), BigNumber::SerialBigNumContext).value(),
+                 BigNum::deserialize(v.serialize()));
+    }
+}
+#endif
+
+TEST_SUITE("Expression Template Tests") {
+    // |x - y| <= 1e-13 * scale
+    bool close(const BigNum &x, const BigNum &y, const BigNum &scale) {
+        return (x - y).abs() * BigNum(1.0, 13) <= scale.abs();
+    }
+
+    TEST_CASE("Expressions match their eager counterparts") {
+        std::mt19937_64 rng(24);
+        std::uniform_real_distribution<double> mant(1.0, 10.0);
+        // Exponents of at least 17, and quotients above 1e17, so that the
+        // eager results are not rounded to integers
+        auto random = [&](int min_e) {
+            return BigNum((rng() & 1) ? mant(rng) : -mant(rng), min_e + rng() % 20);
+        };
+        for (int i = 0; i < 1000; ++i) {
+            const BigNum a = random(60), b = random(17), c = random(60), d = random(17),
+                         e = random(17);
+            const BigNum scale = std::max({(a * b).abs(), (c * d).abs(), e.abs()});
+            CHECK(close(lazy(a) * b + lazy(c) * d - e, a * b + c * d - e, scale));
+            CHECK(close(lazy(a) / b - c / lazy(d), a / b - c / d,
+                        std::max((a / b).abs(), (c / d).abs())));
+            CHECK(close(-(lazy(a) - b) * c, -(a - b) * c, (a - b).abs() * c.abs()));
+
+            BigNum total = e, eager = e;
+            total += lazy(a) * b;
+            eager += a * b;
+            CHECK(close(total, eager, std::max((a * b).abs(), e.abs())));
+        }
+
+        // Scalars past double range once multiplied together
+        const BigNum big = lazy(BigNum(9.9)) * 1e99 * 1e300;
+        CHECK(close(big, BigNum(9.9) * 1e99 * 1e300, big));
+        CHECK(close(1e300 * (lazy(BigNum(2.0, 50)) * 1e300), BigNum(2.0, 650), BigNum(2.0, 650)));
+
+        // Single operations need no rounding of intermediates
+        const BigNum x("3.25e40"), y("-7.5e21");
+        CHECK_EQ(BigNum(lazy(x) * y), x * y);
+        CHECK_EQ(BigNum(lazy(x) / y), x / y);
+        CHECK_EQ(BigNum(lazy(x) + x), x + x);
+        CHECK_EQ(BigNum(lazy(y) - x), y - x);
+    }
+
+    TEST_CASE("Scalar and string operands") {
+        const BigNum v(1.0, 20);
+        // BigNum(2.5) is rounded to 3, a scalar operand is not
+        CHECK_EQ(v * 2.5, BigNum(3.0, 20));
+        CHECK_EQ(BigNum(lazy(v) * 2.5), BigNum(2.5, 20));
+        CHECK_EQ(BigNum(2 * lazy(v) + 1e19), BigNum(2.1, 20));
+        CHECK_EQ(BigNum(1e21 - lazy(v) / 4), BigNum(9.75, 20));
+        CHECK_EQ(BigNum(lazy(v) + "1e21" - "5e19"), BigNum(1.05, 21));
+        CHECK_THROWS_AS(lazy(v) + "1e2x", std::invalid_argument);
+
+        // Compounding by 1.15 per level, which BigNum(1.15) would round to 1
+        const BigNum start(1.0, 20);
+        CHECK_EQ(start * 1.15, start);
+        BigNum cost = start;
+        for (int level = 0; level < 100; ++level) {
+            cost = lazy(cost) * 1.15;
+        }
+        CHECK(close(cost, start.mul_pow(1.15, 100.0), cost));
+    }
+
+    TEST_CASE("Special values and stored expressions") {
+        const BigNum one(1.0);
+        CHECK(BigNum(lazy(one) / 0.0).is_nan());
+        CHECK_EQ(BigNum(lazy(BigNum::inf()) * 2 + BigNum(1.0, 300)), BigNum::inf());
+        CHECK(BigNum(lazy(BigNum::nan()) * 0.0 + one).is_nan());
+        CHECK_EQ(BigNum(lazy(BigNum::max()) * BigNum::max()), BigNum::max() * BigNum::max());
+        CHECK_EQ(BigNum(lazy(BigNum(5.0)) - 5), BigNum(0.0));
+        CHECK_EQ(BigNum(lazy(BigNum(0.25)) * 2), BigNum(0.5));
+
+        // Operands are copied, so the expression outlives them
+        auto make = [] {
+            BigNum a(2.0, 50), b(3.0, 50);
+            return lazy(a) * b - a;
+        };
+        const auto expr = make();
+        CHECK_EQ(expr.eval(), BigNum(2.0, 50) * BigNum(3.0, 50) - BigNum(2.0, 50));
+
+        const UnnormalizedBigNum u = UnnormalizedBigNum(BigNum(4.0, 30)) * BigNum(2.0, 30);
+        CHECK_EQ(BigNum(lazy(u) + BigNum(1.0, 60)), BigNum(9.0, 60));
+
+#if BIGNUM_CONSTEXPR
+        constexpr BigNum folded = lazy(BigNum(2.0, 30)) * 3 + BigNum(1.0, 30);
+        static_assert(folded == BigNum(7.0, 30));
+#endif
+    }
+}
+
+TEST_SUITE("Notation Tests") {
+    TEST_CASE("Short scale") {
+        CHECK_EQ(to_notation_string(BigNum(1234.0), Notation::ShortScale, 2), "1.23 K");
+        CHECK_EQ(to_notation_string(BigNum(4.56, 15), Notation::ShortScale, 2), "4.56 Qa");
+        CHECK_EQ(to_notation_string(BigNum(1.0, 6), Notation::ShortScale, 2), "1.00 M");
+        CHECK_EQ(to_notation_string(BigNum(9.9999, 11), Notation::ShortScale, 2), "999.99 B");
+        CHECK_EQ(to_notation_string(BigNum(1.0, 33), Notation::ShortScale, 0), "1 Dc");
+        CHECK_EQ(to_notation_string(BigNum(1.23, 36), Notation::ShortScale, 2), "1.23 UDc");
+        CHECK_EQ(to_notation_string(BigNum(1.0, 63), Notation::ShortScale, 0), "1 Vg");
+        CHECK_EQ(to_notation_string(BigNum(1.0, 303), Notation::ShortScale, 0), "1 Ce");
+        CHECK_EQ(to_notation_string(BigNum(1.0, 3002), Notation::ShortScale, 0),
+                 "100 NoNogNoCe");
+
+        // Past the table the scientific form is used
+        const BigNum huge(1.0, 3003);
+        CHECK_EQ(to_notation_string(huge, Notation::ShortScale, 2), huge.to_string(2));
+    }
+
+    TEST_CASE("Long scale and engineering") {
+        CHECK_EQ(to_notation_string(BigNum(1.0, 6), Notation::LongScale, 0), "1 M");
+        CHECK_EQ(to_notation_string(BigNum(1.0, 9), Notation::LongScale, 0), "1 Md");
+        CHECK_EQ(to_notation_string(BigNum(1.0, 12), Notation::LongScale, 0), "1 B");
+        CHECK_EQ(to_notation_string(BigNum(1.0, 15), Notation::LongScale, 0), "1 Bd");
+        CHECK_EQ(to_notation_string(BigNum(1.0, 60), Notation::LongScale, 0), "1 Dc");
+        CHECK_EQ(to_notation_string(BigNum(2.5, 66), Notation::LongScale, 1), "2.5 UDc");
+
+        CHECK_EQ(to_notation_string(BigNum(1.2345, 7), Notation::Engineering, 2), "12.34e6");
+        CHECK_EQ(to_notation_string(BigNum(1.0, 3), Notation::Engineering, 1), "1.0e3");
+        CHECK_EQ(to_notation_string(BigNum(5.0, 100000), Notation::Engineering, 0),
+                 "50e99999");
+    }
+
+    TEST_CASE("Letters") {
+        CHECK_EQ(to_notation_string(BigNum(1.0, 12), Notation::Letters, 0), "1 T");
+        CHECK_EQ(to_notation_string(BigNum(1.0, 15), Notation::Letters, 0), "1 aa");
+        CHECK_EQ(to_notation_string(BigNum(1.0, 18), Notation::Letters, 0), "1 ab");
+        CHECK_EQ(to_notation_string(BigNum(1.0, 90), Notation::Letters, 0), "1 az");
+        CHECK_EQ(to_notation_string(BigNum(1.0, 93), Notation::Letters, 0), "1 ba");
+        CHECK_EQ(to_notation_string(BigNum(1.0, 2040), Notation::Letters, 0), "1 zz");
+        CHECK_EQ(to_notation_string(BigNum(1.0, 2043), Notation::Letters, 0), "1 aaa");
+        CHECK_EQ(to_notation_string(BigNum::max(), Notation::Letters, 0), "9 blkgrhlyfhfuoa");
+    }
+
+    TEST_CASE("Small values, signs and contexts") {
+        for (Notation n : {Notation::ShortScale, Notation::LongScale, Notation::Engineering,
+                           Notation::Letters}) {
+            CHECK_EQ(to_notation_string(BigNum(999.0), n, 2), BigNum(999.0).to_string(2));
+            CHECK_EQ(to_notation_string(BigNum(0.5), n, 2), BigNum(0.5).to_string(2));
+            CHECK_EQ(to_notation_string(BigNum::inf(), n), "inf");
+            CHECK_EQ(to_notation_string(BigNum::nan(), n), "nan");
+        }
+        CHECK_EQ(to_notation_string(BigNum(-1234.0), Notation::ShortScale, 2), "-1.23 K");
+        CHECK_EQ(to_notation_string(BigNum(-1.0, 15), Notation::Letters, 1), "-1.0 aa");
+
+        const BigNumContext ctx{10, 2, ',', '.'};
+        CHECK_EQ(to_notation_string(BigNum(4.56, 15), Notation::ShortScale, ctx), "4,56 Qa");
+        CHECK_EQ(to_notation_string(BigNum(1.2345, 7), Notation::Engineering, ctx),
+                 "12,34e6");
+    }
+
+    TEST_CASE("Caller buffers") {
+        const BigNum v(1.23, 36);
+        char buf[8];
+        auto [ptr, ec] = to_notation_chars(buf, buf + sizeof(buf), v, Notation::ShortScale, 2);
+        CHECK_EQ(ec, std::errc());
+        CHECK_EQ(std::string_view(buf, ptr), "1.23 UDc");
+
+        auto small = to_notation_chars(buf, buf + 7, v, Notation::ShortScale, 2);
+        CHECK_EQ(small.ec, std::errc::value_too_large);
+        CHECK_EQ(small.ptr, buf + 7);
+        CHECK_EQ(to_notation_chars(buf, buf + 4, v, Notation::Engineering, 2).ec,
+                 std::errc::value_too_large);
+
+        // Every notation agrees with the engineering mantissa and exponent
+        std::mt19937_64 rng(25);
+        std::uniform_real_distribution<double> mantissa(1.0, 10.0);
+        std::uniform_int_distribution<std::uint64_t> exponent(3, 3000);
+        std::vector<char> out(max_notation_chars());
+        for (int i = 0; i < 1000; ++i) {
+            const BigNum x(mantissa(rng), exponent(rng));
+            const std::string eng = to_notation_string(x, Notation::Engineering);
+            const std::string mant = eng.substr(0, eng.find('e'));
+            for (Notation n : {Notation::ShortScale, Notation::LongScale, Notation::Letters}) {
+                auto r = to_notation_chars(out.data(), out.data() + out.size(), x, n);
+                REQUIRE_EQ(r.ec, std::errc());
+                const std::string_view text(out.data(), r.ptr);
+                CHECK_EQ(text.substr(0, text.find(' ')), mant);
+                CHECK_EQ(text, to_notation_string(x, n));
+            }
+        }
+    }
 }